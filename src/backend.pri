@@ -99,20 +99,32 @@ HEADERS += \
     $$PWD/backend/fib-processor.h \
     $$PWD/backend/fic-handler.h \
     $$PWD/backend/msc-handler.h \
+    $$PWD/backend/decoder-pool.h \
     $$PWD/backend/freq-interleaver.h \
     $$PWD/backend/ofdm-decoder.h \
+    $$PWD/backend/dqpsk-demapper.h \
     $$PWD/backend/ofdm-processor.h \
+    $$PWD/backend/coarse-sync.h \
     $$PWD/backend/phasereference.h \
     $$PWD/backend/phasetable.h \
     $$PWD/backend/tii-decoder.h \
+    $$PWD/backend/symbol-buffer-pool.h \
+    $$PWD/backend/sync-milestones.h \
+    $$PWD/backend/time-deinterleaver.h \
     $$PWD/backend/protTables.h \
     $$PWD/backend/protection.h \
     $$PWD/backend/radio-controller.h \
     $$PWD/backend/radio-receiver.h \
+    $$PWD/backend/rs-syndromes.h \
     $$PWD/backend/tools.h \
     $$PWD/backend/uep-protection.h \
     $$PWD/backend/viterbi.h \\
+    $$PWD/backend/viterbi-batch.h \
     $$PWD/various/fft.h \
+    $$PWD/various/cpu_features.h \
+    $$PWD/various/nco.h \
+    $$PWD/various/signal_level.h \
+    $$PWD/various/spsc_queue.h \
     $$PWD/various/ringbuffer.h \
     $$PWD/various/Xtan2.h \
     $$PWD/various/channels.h \
@@ -148,23 +160,35 @@ SOURCES += \
     $$PWD/backend/mot_manager.cpp \
     $$PWD/backend/pad_decoder.cpp \
     $$PWD/backend/eep-protection.cpp \
+    $$PWD/backend/energy_dispersal.cpp \
     $$PWD/backend/fib-processor.cpp \
     $$PWD/backend/fic-handler.cpp \
     $$PWD/backend/msc-handler.cpp \
+    $$PWD/backend/decoder-pool.cpp \
     $$PWD/backend/freq-interleaver.cpp \
     $$PWD/backend/ofdm-decoder.cpp \
+    $$PWD/backend/dqpsk-demapper.cpp \
     $$PWD/backend/ofdm-processor.cpp \
+    $$PWD/backend/coarse-sync.cpp \
     $$PWD/backend/phasereference.cpp \
     $$PWD/backend/phasetable.cpp \
     $$PWD/backend/tii-decoder.cpp \
+    $$PWD/backend/symbol-buffer-pool.cpp \
+    $$PWD/backend/sync-milestones.cpp \
+    $$PWD/backend/time-deinterleaver.cpp \
     $$PWD/backend/protTables.cpp \
     $$PWD/backend/radio-receiver.cpp \
+    $$PWD/backend/rs-syndromes.cpp \
     $$PWD/backend/tools.cpp \
     $$PWD/backend/uep-protection.cpp \
     $$PWD/backend/viterbi.cpp \
+    $$PWD/backend/viterbi-batch.cpp \
     $$PWD/various/Xtan2.cpp \
     $$PWD/various/channels.cpp \
     $$PWD/various/fft.cpp \
+    $$PWD/various/cpu_features.cpp \
+    $$PWD/various/nco.cpp \
+    $$PWD/various/signal_level.cpp \
     $$PWD/various/wavfile.c \
     $$PWD/various/Socket.cpp \
     $$PWD/libs/fec/encode_rs_char.c \
@@ -292,6 +316,11 @@ mpg123_builtin {
 }
 
 #### Devices ####
+# The NEON kernels have not been verified on ARM yet
+neon_kernels {
+    DEFINES    += NEON_KERNELS
+}
+
 airspy {
     DEFINES    += HAVE_AIRSPY
     HEADERS    += $$PWD/input/airspy_sdr.h
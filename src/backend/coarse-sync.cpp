@@ -0,0 +1,309 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "coarse-sync.h"
+
+using namespace std;
+
+//  Offsets from -SEARCH_RANGE / 2 to SEARCH_RANGE / 2 carriers are tried
+#define SEARCH_RANGE        (2 * 36)
+#define CORRELATION_LENGTH  24
+//  Number of phase differences needed by the search
+#define NUM_ARGS            (SEARCH_RANGE + CORRELATION_LENGTH)
+
+/* atan2 without branches and without calls to libm, so that a loop over
+ * an array can be vectorised by the compiler. The polynomial is the one
+ * from Abramowitz and Stegun 4.4.49, its error of 2e-8 on [0, 1] is below
+ * the float resolution. */
+static inline float fast_atan2(float y, float x)
+{
+    const float ax = std::fabs(x);
+    const float ay = std::fabs(y);
+    const float a = std::min(ax, ay) / std::max(std::max(ax, ay), FLT_MIN);
+    const float s = a * a;
+    float r = -0.0161657367f + 0.0028662257f * s;
+    r = 0.0429096138f + r * s;
+    r = -0.0752896400f + r * s;
+    r = 0.1065626393f + r * s;
+    r = -0.1420889944f + r * s;
+    r = 0.1999355085f + r * s;
+    r = -0.3333314528f + r * s;
+    r = a + a * s * r;
+    r = ay > ax ? (float)M_PI_2 - r : r;
+    r = x < 0 ? (float)M_PI - r : r;
+    return std::copysign(r, y);
+}
+
+CoarseFrequencySync::CoarseFrequencySync(const DABParams& params,
+        PhaseReference& phaseRef,
+        FreqsyncMethod method,
+        bool useThread) :
+    m_params(params),
+    m_method(method),
+    m_fft(params.T_u),
+    m_fft_buffer(m_fft.getVector()),
+    m_ref_arg(CORRELATION_LENGTH),
+    m_arg(NUM_ARGS),
+    m_abs_arg(NUM_ARGS),
+    m_score(SEARCH_RANGE),
+    m_use_thread(useThread)
+{
+    const auto T_u = m_params.T_u;
+    for (int i = 0; i < CORRELATION_LENGTH; i++)  {
+        m_ref_arg[i] = abs(arg(phaseRef[(T_u + i) % T_u] *
+                conj(phaseRef[(T_u + i + 1) % T_u])));
+    }
+
+    if (m_use_thread) {
+        m_thread = thread(&CoarseFrequencySync::run, this);
+    }
+}
+
+CoarseFrequencySync::~CoarseFrequencySync()
+{
+    unique_lock<mutex> lock(m_state_mutex);
+    m_state = State::Abort;
+    lock.unlock();
+    m_state_changed.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool CoarseFrequencySync::push(const SymbolBuffer& prs)
+{
+    if (not m_use_thread) {
+        m_result = estimate(prs.data());
+        m_state = State::ResultReady;
+        return true;
+    }
+
+    unique_lock<mutex> lock(m_state_mutex);
+    if (m_state != State::Idle) {
+        return false;
+    }
+    m_prs = prs;
+    m_state = State::PrsReady;
+    lock.unlock();
+    m_state_changed.notify_all();
+    return true;
+}
+
+bool CoarseFrequencySync::getResult(int16_t& correction)
+{
+    lock_guard<mutex> lock(m_state_mutex);
+    if (m_state != State::ResultReady) {
+        return false;
+    }
+    correction = m_result;
+    m_state = State::Idle;
+    return true;
+}
+
+void CoarseFrequencySync::clear()
+{
+    unique_lock<mutex> lock(m_state_mutex);
+    // The estimation in progress cannot be interrupted, wait for it
+    // to finish and drop its result.
+    while (m_state == State::PrsReady) {
+        m_state_changed.wait(lock);
+    }
+    if (m_state == State::ResultReady) {
+        m_state = State::Idle;
+    }
+}
+
+void CoarseFrequencySync::run()
+{
+    while (true) {
+        unique_lock<mutex> lock(m_state_mutex);
+        while (not (m_state == State::PrsReady or
+                    m_state == State::Abort)) {
+            m_state_changed.wait(lock);
+        }
+
+        if (m_state == State::Abort) {
+            return;
+        }
+        lock.unlock();
+
+        const int16_t correction = estimate(m_prs.data());
+        m_prs.release();
+
+        lock.lock();
+        if (m_state == State::PrsReady) {
+            m_result = correction;
+            m_state = State::ResultReady;
+        }
+        lock.unlock();
+        m_state_changed.notify_all();
+    }
+}
+
+int16_t CoarseFrequencySync::estimate(const DSPCOMPLEX *prs)
+{
+    memcpy(m_fft_buffer, prs, m_params.T_u * sizeof(DSPCOMPLEX));
+    m_fft.do_FFT();
+
+    switch (m_method) {
+        case FreqsyncMethod::GetMiddle:
+            return getMiddle();
+        case FreqsyncMethod::CorrelatePRS:
+            computePhaseDifferences();
+            return correlatePRS();
+        case FreqsyncMethod::PatternOfZeros:
+            computePhaseDifferences();
+            return patternOfZeros();
+    }
+    throw logic_error("Unimplemented freqsyncMethod");
+}
+
+void CoarseFrequencySync::computePhaseDifferences()
+{
+    //  The search window wraps around the end of the FFT output
+    const auto T_u = m_params.T_u;
+    const DSPCOMPLEX *v = m_fft_buffer;
+    float re[NUM_ARGS];
+    float im[NUM_ARGS];
+    for (int i = 0; i < NUM_ARGS; i++) {
+        const int32_t k = T_u - SEARCH_RANGE / 2 + i;
+        const DSPCOMPLEX z = v[k % T_u] * conj(v[(k + 1) % T_u]);
+        re[i] = real(z);
+        im[i] = imag(z);
+    }
+
+    for (int i = 0; i < NUM_ARGS; i++) {
+        m_arg[i] = fast_atan2(im[i], re[i]);
+        m_abs_arg[i] = std::fabs(m_arg[i]);
+    }
+}
+
+int16_t CoarseFrequencySync::correlatePRS()
+{
+    //  The "best" approach for computing the coarse frequency
+    //  offset is to look at the spectrum of symbol 0 and relate that
+    //  with the spectrum as it should be, i.e. the refTable
+    //  However, since there might be
+    //  a pretty large phase offset between the incoming data and
+    //  the reference table data, we correlate the
+    //  phase differences between the subsequent carriers rather
+    //  than the values in the segments themselves.
+    //  It seems to work pretty well
+    for (int i = 0; i < SEARCH_RANGE; i++) {
+        float sum = 0;
+        for (int j = 0; j < CORRELATION_LENGTH; j++) {
+            sum += m_ref_arg[j] * m_abs_arg[i + j];
+        }
+        m_score[i] = sum;
+    }
+
+    int16_t index = NO_CORRECTION;
+    float MMax = 0;
+    for (int i = 0; i < SEARCH_RANGE; i++) {
+        if (m_score[i] > MMax) {
+            MMax = m_score[i];
+            index = i;
+        }
+    }
+
+    if (index == NO_CORRECTION) {
+        return NO_CORRECTION;
+    }
+    //  Now map the index back to the right carrier
+    return index - SEARCH_RANGE / 2;
+}
+
+int16_t CoarseFrequencySync::patternOfZeros()
+{
+    //  An alternative way is to look at a special pattern consisting
+    //  of zeros in the row of args between successive carriers.
+    //  Each phase difference is used by several candidate offsets,
+    //  the terms of the sum are therefore computed once.
+    const float *e = m_abs_arg.data();
+    float f[NUM_ARGS];
+    float g[NUM_ARGS - 1];
+    for (int i = 0; i < NUM_ARGS; i++) {
+        f[i] = std::fabs(e[i] / (float)M_PI - 1);
+    }
+    for (int i = 0; i < NUM_ARGS - 1; i++) {
+        //  Phase difference between carriers i and i + 2
+        float a = m_arg[i] + m_arg[i + 1];
+        a = a > (float)M_PI ? a - 2 * (float)M_PI : a;
+        a = a <= -(float)M_PI ? a + 2 * (float)M_PI : a;
+        g[i] = std::fabs(std::fabs(a) / (float)M_PI - 1);
+    }
+
+    for (int i = 0; i < SEARCH_RANGE; i++) {
+        m_score[i] = f[i + 1] + f[i + 2] + e[i + 3] + e[i + 4] + e[i + 5] +
+            g[i + 17] + e[i + 19] + e[i + 20] + e[i + 21];
+    }
+
+    int16_t index = NO_CORRECTION;
+    float Mmin = 1000;
+    for (int i = 0; i < SEARCH_RANGE; i++) {
+        if (m_score[i] < Mmin) {
+            Mmin = m_score[i];
+            index = i;
+        }
+    }
+
+    if (index == NO_CORRECTION) {
+        return NO_CORRECTION;
+    }
+    return index - SEARCH_RANGE / 2;
+}
+
+int16_t CoarseFrequencySync::getMiddle()
+{
+    const DSPCOMPLEX *v = m_fft_buffer;
+    const auto T_u = m_params.T_u;
+    const auto K = m_params.K;
+    int16_t     i;
+    DSPFLOAT    sum = 0;
+    int16_t     maxIndex = 0;
+    DSPFLOAT    oldMax  = 0;
+    //
+    //  basic sum over K carriers that are - most likely -
+    //  in the range
+    //  The range in which the carrier should be is
+    //  T_u / 2 - K / 2 .. T_u / 2 + K / 2
+    //  We first determine an initial sum over K carriers
+    for (i = 40; i < K + 40; i ++)
+        sum += abs (v [(T_u / 2 + i) % T_u]);
+    //
+    //  Now a moving sum, look for a maximum within a reasonable
+    //  range (around (T_u - K) / 2, the start of the useful frequencies)
+    for (i = 40; i < T_u - (K - 40); i ++) {
+        sum -= abs (v [(T_u / 2 + i) % T_u]);
+        sum += abs (v [(T_u / 2 + i + K) % T_u]);
+        if (sum > oldMax) {
+            sum = oldMax;
+            maxIndex = i;
+        }
+    }
+    return maxIndex - (T_u - K) / 2;
+}
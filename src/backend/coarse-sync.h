@@ -0,0 +1,105 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __COARSE_SYNC__
+#define __COARSE_SYNC__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dab-constants.h"
+#include "fft.h"
+#include "phasereference.h"
+#include "radio-receiver-options.h"
+#include "symbol-buffer-pool.h"
+
+/* Estimation of the coarse frequency offset, in carriers, from the
+ * phase reference symbol.
+ *
+ * The phase differences between neighbouring carriers in the search
+ * range are computed once per symbol, in one pass over an array, and
+ * the candidate offsets are then scored from these arrays.
+ *
+ * The estimation can run on a helper thread, so that the thread reading
+ * the samples does not wait for the FFT and the search. */
+class CoarseFrequencySync {
+    public:
+        // Returned when no offset could be estimated
+        static const int16_t NO_CORRECTION = 100;
+
+        CoarseFrequencySync(const DABParams& params,
+                PhaseReference& phaseRef,
+                FreqsyncMethod method,
+                bool useThread);
+        ~CoarseFrequencySync();
+        CoarseFrequencySync(const CoarseFrequencySync& other) = delete;
+        CoarseFrequencySync& operator=(const CoarseFrequencySync& other) = delete;
+
+        void setMethod(FreqsyncMethod method) { m_method = method; }
+
+        // Estimate the offset of the given PRS on the calling thread
+        int16_t estimate(const DSPCOMPLEX *prs);
+
+        // Start the estimation for the PRS. Returns false if the previous
+        // estimation is not finished, or its result was not taken yet.
+        // Without helper thread, the result is available immediately.
+        bool push(const SymbolBuffer& prs);
+
+        // Take the result of the last estimation, if it is finished
+        bool getResult(int16_t& correction);
+
+        // Forget the PRS being processed and the result
+        void clear(void);
+
+    private:
+        void run(void);
+        void computePhaseDifferences(void);
+        int16_t correlatePRS(void);
+        int16_t patternOfZeros(void);
+        int16_t getMiddle(void);
+
+        const DABParams& m_params;
+        std::atomic<FreqsyncMethod> m_method;
+
+        fft::Forward m_fft;
+        DSPCOMPLEX *m_fft_buffer;
+
+        // Absolute phase differences of the reference, for CorrelatePRS
+        std::vector<float> m_ref_arg;
+        // Phase differences between the carriers of the search window
+        std::vector<float> m_arg;
+        std::vector<float> m_abs_arg;
+        std::vector<float> m_score;
+
+        enum class State { Idle, PrsReady, ResultReady, Abort };
+
+        bool m_use_thread;
+        std::thread m_thread;
+        std::mutex m_state_mutex;
+        std::condition_variable m_state_changed;
+        State m_state = State::Idle;
+        SymbolBuffer m_prs;
+        int16_t m_result = NO_CORRECTION;
+};
+
+#endif
@@ -22,24 +22,21 @@
  *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <chrono>
 #include <iostream>
 #include "dab-constants.h"
 #include "dab-audio.h"
 #include "decoder_adapter.h"
 #include "eep-protection.h"
 #include "uep-protection.h"
+#include "viterbi-batch.h"
+
+//  Duration of a logical frame, in seconds
+#define FRAME_DURATION  0.024
+//  After the soft output was switched off for taking too long, it is
+//  tried again after this many frames (30 s)
+#define SOFT_OUTPUT_PROBE_FRAMES    1250
 
-//  As an experiment a version of the backend is created
-//  that will be running in a separate thread. Might be
-//  useful for multicore processors.
-//
-//  Interleaving is - for reasons of simplicity - done
-//  inline rather than through a special class-object
-//static
-//int8_t    interleaveDelays[] = {
-//       15, 7, 11, 3, 13, 5, 9, 1, 14, 6, 10, 2, 12, 4, 8, 0};
-//
-//
 //  fragmentsize == Length * CUSize
 DabAudio::DabAudio(
         AudioServiceComponentType dabModus,
@@ -47,113 +44,129 @@ DabAudio::DabAudio(
         int16_t bitRate,
         ProtectionSettings protection,
         ProgrammeHandlerInterface& phi,
-        const std::string& dumpFileName) :
-    myProgrammeHandler(phi),
-    mscBuffer(64 * 32768),
-    dumpFileName(dumpFileName)
+        const std::string& dumpFileName,
+        SyncMilestoneTracker& milestones,
+        float softOutputBudget) :
+    myProgrammeHandler(&phi),
+    dumpFileName(dumpFileName),
+    softOutputBudget(softOutputBudget)
 {
     this->dabModus         = dabModus;
     this->fragmentSize     = fragmentSize;
     this->bitRate          = bitRate;
 
-    outV.resize(bitRate * 24);
-    for (int i = 0; i < 16; i ++) {
-        interleaveData[i].resize(fragmentSize);
-    }
-
     using std::make_unique;
 
     if (protection.shortForm) {
-        protectionHandler = make_unique<UEPProtection>(bitRate, protection.uepLevel);
+        auto uep = make_unique<UEPProtection>(bitRate, protection.uepLevel);
+        viterbi = uep.get();
+        schedule = &UEPProtection::getSchedule(bitRate, protection.uepLevel);
+        protectionHandler = std::move(uep);
     }
     else {
         const bool profile_is_eep_a =
             protection.eepProfile == EEPProtectionProfile::EEP_A;
-        protectionHandler = make_unique<EEPProtection>(
+        auto eep = make_unique<EEPProtection>(
+                bitRate, profile_is_eep_a, (int)protection.eepLevel);
+        viterbi = eep.get();
+        schedule = &EEPProtection::getSchedule(
                 bitRate, profile_is_eep_a, (int)protection.eepLevel);
+        protectionHandler = std::move(eep);
     }
 
-    our_dabProcessor = make_unique<DecoderAdapter>(
-            myProgrammeHandler, bitRate, dabModus, dumpFileName);
+    // Only the Reed-Solomon code of DAB+ makes use of the soft output
+    if (dabModus == AudioServiceComponentType::DABPlus and
+            softOutputBudget > 0) {
+        setSoftOutput(true);
+    }
 
-    running = true;
-    ourThread = std::thread(&DabAudio::run, this);
+    our_dabProcessor = make_unique<DecoderAdapter>(
+            *myProgrammeHandler, bitRate, dabModus, dumpFileName, milestones);
 }
 
 DabAudio::~DabAudio()
 {
-    running = false;
-
-    if (ourThread.joinable()) {
-        mscDataAvailable.notify_all();
-        ourThread.join();
-    }
 }
 
-int32_t DabAudio::process(int16_t *v, int16_t cnt)
+void DabAudio::reuse(ProgrammeHandlerInterface& phi)
 {
-    int32_t fr;
+    myProgrammeHandler = &phi;
+
+    softOutputLoad = -1;
+    framesUntilProbe = 0;
+    setSoftOutput(dabModus == AudioServiceComponentType::DABPlus and
+            softOutputBudget > 0);
 
-    if (mscBuffer.GetRingBufferWriteAvailable () < cnt)
-        fprintf (stderr, "dab-concurrent: buffer full\n");
+    our_dabProcessor->reset(*myProgrammeHandler);
+}
 
-    while ((fr = mscBuffer.GetRingBufferWriteAvailable ()) <= cnt) {
-        if (!running)
-            return 0;
-        std::this_thread::sleep_for(std::chrono::microseconds(1));
+bool DabAudio::getViterbiFrame(const int16_t *v, uint8_t *output,
+        ViterbiFrame& frame)
+{
+    // In soft-output mode, the frame is decoded alone
+    if (softOutput) {
+        return false;
     }
 
-    mscBuffer.putDataIntoBuffer(v, cnt);
-    mscDataAvailable.notify_all();
-    return fr;
+    frame.viterbi = viterbi;
+    frame.input = v;
+    frame.schedule = schedule;
+    frame.output = output;
+    return true;
 }
 
-const int16_t interleaveMap[] = {0,8,4,12,2,10,6,14,1,9,5,13,3,11,7,15};
-
-void DabAudio::run()
+void DabAudio::processFrame(int16_t *v, uint8_t *output, bool decoded)
 {
-    int16_t i;
-    int16_t countforInterleaver = 0;
-    int16_t interleaverIndex    = 0;
-    int16_t Data[fragmentSize];
-    int16_t tempX[fragmentSize];
-
-    while (running) {
-        std::unique_lock<std::mutex> lock(ourMutex);
-        while (running && mscBuffer.GetRingBufferReadAvailable() <= fragmentSize) {
-            mscDataAvailable.wait(lock);
+    bool softOutputUsed = false;
+    if (not decoded) {
+        softOutputUsed = viterbi->getSoftOutput();
+        const auto t0 = std::chrono::steady_clock::now();
+        protectionHandler->deconvolve(v, fragmentSize, output);
+        if (softOutputUsed) {
+            governSoftOutput(std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - t0).count());
         }
+    }
 
-        if (!running)
-            break;
-
-        // mscBuffer is threadsafe to access, no need to keep the lock
-        lock.unlock();
-
-
-        mscBuffer.getDataFromBuffer(Data, fragmentSize);
+    if (not softOutputUsed and framesUntilProbe > 0 and
+            --framesUntilProbe == 0) {
+        // The other subchannels may leave more time now
+        setSoftOutput(true);
+    }
 
-        for (i = 0; i < fragmentSize; i ++) {
-            tempX[i] = interleaveData[(interleaverIndex +
-                    interleaveMap[i & 017]) & 017][i];
-            interleaveData[interleaverIndex][i] = Data[i];
-        }
-        interleaverIndex = (interleaverIndex + 1) & 0x0F;
+    // and the inline energy dispersal
+    energyDispersal.dedisperse(output, bitRate * 24 / 8);
 
-        //  only continue when de-interleaver is filled
-        if (countforInterleaver <= 15) {
-            countforInterleaver ++;
-            continue;
-        }
+    if (our_dabProcessor) {
+        our_dabProcessor->addtoFrame(output, softOutputUsed ?
+                viterbi->getByteReliability() : nullptr);
+    }
+}
 
-        protectionHandler->deconvolve(tempX, fragmentSize, outV.data());
+void DabAudio::setSoftOutput(bool enable)
+{
+    viterbi->setSoftOutput(enable);
+    softOutput = enable;
+}
 
-        // and the inline energy dispersal
-        energyDispersal.dedisperse(outV);
+void DabAudio::governSoftOutput(double decodeTime)
+{
+    // The wall-clock time also grows when the core is busy with
+    // other threads, which is when the soft output should stop.
+    const double load = decodeTime / FRAME_DURATION;
+    if (softOutputLoad < 0) {
+        softOutputLoad = load;
+    }
+    else {
+        softOutputLoad += (load - softOutputLoad) / 16;
+    }
 
-        if (our_dabProcessor) {
-            our_dabProcessor->addtoFrame(outV.data());
-        }
+    if (softOutputLoad > softOutputBudget) {
+        std::clog << "DabAudio: soft output takes " <<
+            100 * softOutputLoad << "% of the time, switched off" << std::endl;
+        setSoftOutput(false);
+        softOutputLoad = -1;
+        framesUntilProbe = SOFT_OUTPUT_PROBE_FRAMES;
     }
 }
 
@@ -29,16 +29,15 @@
 #include <memory>
 #include <atomic>
 #include <vector>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
 #include <cstdio>
-#include "ringbuffer.h"
 #include "energy_dispersal.h"
 #include "radio-controller.h"
+#include "sync-milestones.h"
 
-class DabProcessor;
+class DecoderAdapter;
 class Protection;
+class PunctureSchedule;
+class Viterbi;
 
 class DabAudio : public DabVirtual
 {
@@ -48,35 +47,51 @@ class DabAudio : public DabVirtual
                   int16_t bitRate,
                   ProtectionSettings protection,
                   ProgrammeHandlerInterface& phi,
-                  const std::string& dumpFileName);
+                  const std::string& dumpFileName,
+                  SyncMilestoneTracker& milestones,
+                  float softOutputBudget = 0);
         ~DabAudio(void);
         DabAudio(const DabAudio&) = delete;
         DabAudio& operator=(const DabAudio&) = delete;
 
-        int32_t process(int16_t *v, int16_t cnt);
+        bool getViterbiFrame(const int16_t *v, uint8_t *output,
+                ViterbiFrame& frame) override;
+        void processFrame(int16_t *v, uint8_t *output,
+                bool decoded) override;
+
+        // Decode another subchannel with the same audio type, fragment
+        // size, bitrate and protection for the given handler, without a
+        // dump file. The Viterbi decoder, the Reed-Solomon decoder and the
+        // audio decoders are kept, and start over as if they were new.
+        // Must not be called while a frame is being processed.
+        void reuse(ProgrammeHandlerInterface& phi);
 
     protected:
-        ProgrammeHandlerInterface& myProgrammeHandler;
+        ProgrammeHandlerInterface *myProgrammeHandler;
 
     private:
-        void    run(void);
-        std::atomic<bool> running;
+        void    governSoftOutput(double decodeTime);
+        void    setSoftOutput(bool enable);
         AudioServiceComponentType dabModus;
         int16_t fragmentSize;
         int16_t bitRate;
-        std::vector<uint8_t> outV;
-        std::vector<int16_t> interleaveData[16];
         EnergyDispersal energyDispersal;
 
-        std::condition_variable  mscDataAvailable;
-        std::mutex               ourMutex;
-        std::thread              ourThread;
-
         std::unique_ptr<Protection> protectionHandler;
-        std::unique_ptr<DabProcessor> our_dabProcessor;
-        RingBuffer<int16_t> mscBuffer;
+        std::unique_ptr<DecoderAdapter> our_dabProcessor;
 
         const std::string dumpFileName;
+
+        // The Viterbi decoder of protectionHandler, and its puncturing.
+        // Its soft output is used while it takes less than
+        // softOutputBudget of the real time, on average over the last
+        // frames. The frames are then not decoded in a batch.
+        Viterbi *viterbi = nullptr;
+        const PunctureSchedule *schedule = nullptr;
+        std::atomic<bool> softOutput = ATOMIC_VAR_INIT(false);
+        float softOutputBudget;
+        double softOutputLoad = -1;
+        int framesUntilProbe = 0;
 };
 
 #endif
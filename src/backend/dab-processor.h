@@ -31,7 +31,9 @@
 class DabProcessor {
     public:
         virtual ~DabProcessor() = default;
-        virtual void addtoFrame(uint8_t *) = 0;
+        // v holds the packed bits of the frame, reliability
+        // the reliability of its bytes, or nullptr
+        virtual void addtoFrame(uint8_t *v, const uint8_t *reliability) = 0;
 };
 
 #endif
@@ -27,10 +27,25 @@
 
 #define CUSize  (4 * 16)
 
+struct ViterbiFrame;
+
+//  The handlers of the subchannels receive the time de-interleaved
+//  logical frames, one at a time
 class DabVirtual {
     public:
         virtual ~DabVirtual() {}
-        virtual int32_t process(int16_t *v, int16_t cnt) = 0;
+
+        // Describe the Viterbi decoding of the soft bits in v into the
+        // packed bytes of output, so that it can be done in a batch with
+        // the other subchannels. Returns false if the handler decodes
+        // the frame itself.
+        virtual bool getViterbiFrame(const int16_t *v, uint8_t *output,
+                ViterbiFrame& frame) = 0;
+
+        // Decode the frame of soft bits in v. If decoded is true, output
+        // already holds the result of the Viterbi decoding.
+        virtual void processFrame(int16_t *v, uint8_t *output,
+                bool decoded) = 0;
 };
 #endif
 
@@ -53,6 +53,7 @@ MP2Decoder::MP2Decoder(SubchannelSinkObserver* observer, bool float32) : Subchan
 
 	scf_crc_len = -1;
 	lsf = false;
+	format_pending = false;
 
 
 	int mpg_result;
@@ -109,6 +110,20 @@ MP2Decoder::~MP2Decoder() {
 	mpg123_exit();
 }
 
+void MP2Decoder::Reset() {
+	// reopening the feed drops the buffered data
+	int mpg_result = mpg123_close(handle);
+	if(mpg_result != MPG123_OK)
+		throw std::runtime_error("MP2Decoder: error while mpg123_close: " + std::string(mpg123_plain_strerror(mpg_result)));
+
+	mpg_result = mpg123_open_feed(handle);
+	if(mpg_result != MPG123_OK)
+		throw std::runtime_error("MP2Decoder: error while mpg123_open_feed: " + std::string(mpg123_plain_strerror(mpg_result)));
+
+	// mpg123 only reports a format that differs from the previous one
+	format_pending = true;
+}
+
 void MP2Decoder::Feed(const uint8_t *data, size_t len) {
 	int mpg_result = mpg123_feed(handle, data, len);
 	if(mpg_result != MPG123_OK)
@@ -124,6 +139,9 @@ void MP2Decoder::Feed(const uint8_t *data, size_t len) {
 			ProcessFormat();
 			// fall through - as MPG123_NEW_FORMAT implies MPG123_OK
 		case MPG123_OK: {
+			if(format_pending)
+				ProcessFormat();
+
 			// forward decoded frame, if applicable
 			uint8_t *frame_data;
 			size_t frame_len = DecodeFrame(&frame_data);
@@ -250,6 +268,8 @@ bool MP2Decoder::CheckCRC(const unsigned long& header, const uint8_t *body_data,
 }
 
 void MP2Decoder::ProcessFormat() {
+	format_pending = false;
+
 	mpg123_frameinfo info;
 	int mpg_result = mpg123_info(handle, &info);
 	if(mpg_result != MPG123_OK)
@@ -45,6 +45,8 @@ private:
 
 	int scf_crc_len;
 	bool lsf;
+	// the format is announced again after a reset
+	bool format_pending;
 	std::vector<uint8_t> frame;
 
 	void ProcessFormat();
@@ -62,6 +64,7 @@ public:
 	~MP2Decoder();
 
 	void Feed(const uint8_t *data, size_t len);
+	void Reset();
 };
 
 #endif /* DAB_DECODER_H_ */
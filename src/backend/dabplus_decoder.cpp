@@ -31,22 +31,39 @@ SuperframeFilter::SuperframeFilter(SubchannelSinkObserver* observer, bool decode
 	sync_frames = 0;
 
 	sf_raw = nullptr;
+	sf_reliability = nullptr;
 	sf = nullptr;
 	sf_len = 0;
 
 	sf_format_set = false;
 	sf_format_raw = 0;
+	aac_dec_format_raw = 0;
 
 	num_aus = 0;
 }
 
 SuperframeFilter::~SuperframeFilter() {
 	delete[] sf_raw;
+	delete[] sf_reliability;
 	delete[] sf;
 	delete aac_dec;
 }
 
+void SuperframeFilter::Reset() {
+	// the buffers keep their size, as the frame len does not change
+	frame_count = 0;
+	sync_frames = 0;
+
+	// announce the format again once in sync
+	sf_format_set = false;
+	num_aus = 0;
+}
+
 void SuperframeFilter::Feed(const uint8_t *data, size_t len) {
+	FeedWithReliability(data, nullptr, len);
+}
+
+void SuperframeFilter::FeedWithReliability(const uint8_t *data, const uint8_t *reliability, size_t len) {
 	// check frame len
 	if(frame_len) {
 		if(frame_len != len) {
@@ -67,19 +84,26 @@ void SuperframeFilter::Feed(const uint8_t *data, size_t len) {
 		sf_len = 5 * frame_len;
 
 		sf_raw = new uint8_t[sf_len];
+		sf_reliability = new uint8_t[sf_len];
 		sf = new uint8_t[sf_len];
 	}
 
 	if(frame_count == 5) {
 		// shift previous frames
-		for(int i = 0; i < 4; i++)
+		for(int i = 0; i < 4; i++) {
 			memcpy(sf_raw + i * frame_len, sf_raw + (i + 1) * frame_len, frame_len);
+			memcpy(sf_reliability + i * frame_len, sf_reliability + (i + 1) * frame_len, frame_len);
+		}
 	} else {
 		frame_count++;
 	}
 
-	// copy frame
+	// copy frame; without reliability, all bytes are considered reliable
 	memcpy(sf_raw + (frame_count - 1) * frame_len, data, frame_len);
+	if(reliability)
+		memcpy(sf_reliability + (frame_count - 1) * frame_len, reliability, frame_len);
+	else
+		memset(sf_reliability + (frame_count - 1) * frame_len, 0xFF, frame_len);
 
 	if(frame_count < 5)
 		return;
@@ -90,7 +114,7 @@ void SuperframeFilter::Feed(const uint8_t *data, size_t len) {
 
 	// append RS coding on copy
 	memcpy(sf, sf_raw, sf_len);
-	rs_dec.DecodeSuperframe(sf, sf_len, total_corr_count, uncorr_errors);
+	rs_dec.DecodeSuperframe(sf, sf_len, total_corr_count, uncorr_errors, sf_reliability);
 
 	// forward statistics if errors present
 	if(total_corr_count || uncorr_errors)
@@ -253,7 +277,14 @@ void SuperframeFilter::ProcessFormat() {
 	observer->FormatChange(ss.str());
 
 	if(decode_audio) {
+		// after a reset, the decoder is still set up for this format
+		if(aac_dec && aac_dec_format_raw == sf_format_raw) {
+			aac_dec->Reset();
+			return;
+		}
+
 		delete aac_dec;
+		aac_dec_format_raw = sf_format_raw;
 #ifdef DABLIN_AAC_FAAD2
 		aac_dec = new AACDecoderFAAD2(observer, sf_format, enable_float32);
 #endif
@@ -323,17 +354,46 @@ void SuperframeFilter::ProcessUntouchedStream(const uint8_t *data, size_t len) {
 
 
 // --- RSDecoder -----------------------------------------------------------------
+// RS(120, 110) corrects up to 10 erasures. The more erasures, the more likely a
+// wrong correction, which the CRC of the AUs then has to catch.
+#define RS_MAX_ERASURES 8
+
 RSDecoder::RSDecoder() {
 	rs_handle = init_rs_char(8, 0x11D, 0, 1, 10, 135);
 	if(!rs_handle)
 		throw std::runtime_error("RSDecoder: error while init_rs_char");
+	erasure_corrections = 0;
 }
 
 RSDecoder::~RSDecoder() {
 	free_rs_char(rs_handle);
 }
 
-void RSDecoder::DecodeSuperframe(uint8_t *sf, size_t sf_len, int& total_corr_count, bool& uncorr_errors) {
+int RSDecoder::DecodeWithErasures(int max_erasures) {
+	// bytes with the highest reliability are not worth an erasure
+	int candidates = 0;
+	for(int pos = 0; pos < 120; pos++)
+		if(rs_reliability[pos] < 0xFF)
+			rs_order[candidates++] = pos;
+	std::stable_sort(rs_order, rs_order + candidates, [&](int a, int b) {
+		return rs_reliability[a] < rs_reliability[b];
+	});
+
+	// each erasure costs one parity byte instead of two, but leaves less
+	// margin to detect a wrong correction - so start with a few
+	for(int no_eras = 2; no_eras <= std::min(max_erasures, candidates); no_eras += 2) {
+		for(int j = 0; j < no_eras; j++)
+			corr_pos[j] = rs_order[j] + 135;
+		int corr_count = decode_rs_char(rs_handle, rs_packet, corr_pos, no_eras);
+		if(corr_count != -1) {
+			erasure_corrections++;
+			return corr_count;
+		}
+	}
+	return -1;
+}
+
+void RSDecoder::DecodeSuperframe(uint8_t *sf, size_t sf_len, int& total_corr_count, bool& uncorr_errors, const uint8_t *reliability) {
 //	// insert errors for test
 //	sf[0] ^= 0xFF;
 //	sf[10] ^= 0xFF;
@@ -343,13 +403,28 @@ void RSDecoder::DecodeSuperframe(uint8_t *sf, size_t sf_len, int& total_corr_cou
 	total_corr_count = 0;
 	uncorr_errors = false;
 
-	// process all RS packets
+	// check all RS packets at once - usually none of them has errors
+	rs_errors.resize(subch_index);
+	rs_syndromes.check(sf, subch_index, rs_errors.data());
+
+	// process the RS packets with errors
 	for(int i = 0; i < subch_index; i++) {
+		if(!rs_errors[i])
+			continue;
+
 		for(int pos = 0; pos < 120; pos++)
 			rs_packet[pos] = sf[pos * subch_index + i];
 
 		// detect errors
 		int corr_count = decode_rs_char(rs_handle, rs_packet, corr_pos, 0);
+
+		// retry with erasures (a failed decoding leaves the packet untouched)
+		if(corr_count == -1 && reliability) {
+			for(int pos = 0; pos < 120; pos++)
+				rs_reliability[pos] = reliability[pos * subch_index + i];
+			corr_count = DecodeWithErasures(RS_MAX_ERASURES);
+		}
+
 		if(corr_count == -1)
 			uncorr_errors = true;
 		else
@@ -458,6 +533,11 @@ AACDecoderFAAD2::~AACDecoderFAAD2() {
 	NeAACDecClose(handle);
 }
 
+void AACDecoderFAAD2::Reset() {
+	// also clears the overlap and SBR state with the first frame
+	NeAACDecPostSeekReset(handle, 0);
+}
+
 void AACDecoderFAAD2::DecodeFrame(uint8_t *data, size_t len) {
 	// decode audio
 	uint8_t* output_frame = (uint8_t*) NeAACDecDecode(handle, &dec_frameinfo, data, len);
@@ -526,6 +606,12 @@ AACDecoderFDKAAC::~AACDecoderFDKAAC() {
 	delete[] output_frame;
 }
 
+void AACDecoderFDKAAC::Reset() {
+	AAC_DECODER_ERROR result = aacDecoder_SetParam(handle, AAC_TPDEC_CLEAR_BUFFER, 1);
+	if(result != AAC_DEC_OK)
+		throw std::runtime_error("AACDecoderFDKAAC: error while setting parameter AAC_TPDEC_CLEAR_BUFFER: " + std::to_string(result));
+}
+
 void AACDecoderFDKAAC::DecodeFrame(uint8_t *data, size_t len) {
 	uint8_t* input_buffer[1] {data};
 	const unsigned int input_buffer_size[1] {(unsigned int) len};
@@ -22,9 +22,11 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <algorithm>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #if !(defined(DABLIN_AAC_FAAD2) ^ defined(DABLIN_AAC_FDKAAC))
 #error "You must select a AAC decoder by defining either DABLIN_AAC_FAAD2 or DABLIN_AAC_FDKAAC!"
@@ -43,6 +45,7 @@ extern "C" {
 }
 
 #include "subchannel_sink.h"
+#include "rs-syndromes.h"
 #include "tools.h"
 
 
@@ -75,13 +78,24 @@ struct SuperframeFormat {
 class RSDecoder {
 private:
 	void *rs_handle;
+	RSSyndromes rs_syndromes;
+	std::vector<uint8_t> rs_errors;
 	uint8_t rs_packet[120];
+	uint8_t rs_reliability[120];
+	int rs_order[120];
 	int corr_pos[10];
+
+	int DecodeWithErasures(int max_erasures);
 public:
 	RSDecoder();
 	~RSDecoder();
 
-	void DecodeSuperframe(uint8_t *sf, size_t sf_len, int& total_corr_count, bool& uncorr_errors);
+	// If the reliability of the bytes is given, a packet that cannot be
+	// corrected is tried again with its least reliable bytes as erasures.
+	void DecodeSuperframe(uint8_t *sf, size_t sf_len, int& total_corr_count, bool& uncorr_errors, const uint8_t *reliability = nullptr);
+
+	// packets corrected thanks to erasures, since the start
+	int erasure_corrections;
 };
 
 
@@ -97,6 +111,8 @@ public:
 	virtual ~AACDecoder() {}
 
 	virtual void DecodeFrame(uint8_t *data, size_t len) = 0;
+	// forget the previous frames, before a new stream of the same format
+	virtual void Reset() = 0;
 };
 
 
@@ -112,6 +128,7 @@ public:
 	~AACDecoderFAAD2();
 
 	void DecodeFrame(uint8_t *data, size_t len);
+	void Reset();
 };
 #endif
 
@@ -128,6 +145,7 @@ public:
 	~AACDecoderFDKAAC();
 
 	void DecodeFrame(uint8_t *data, size_t len);
+	void Reset();
 };
 #endif
 
@@ -146,12 +164,15 @@ private:
 	int sync_frames;
 
 	uint8_t *sf_raw;
+	uint8_t *sf_reliability;
 	uint8_t *sf;
 	size_t sf_len;
 
 	bool sf_format_set;
 	uint8_t sf_format_raw;
 	SuperframeFormat sf_format;
+	// format of aac_dec, kept across Reset()
+	uint8_t aac_dec_format_raw;
 
 	int num_aus;
 	int au_start[6+1]; // +1 for end of last AU
@@ -168,6 +189,9 @@ public:
 	~SuperframeFilter();
 
 	void Feed(const uint8_t *data, size_t len);
+	void FeedWithReliability(const uint8_t *data, const uint8_t *reliability, size_t len);
+	// the AAC decoder is kept if the format does not change
+	void Reset();
 };
 
 
@@ -0,0 +1,135 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "decoder-pool.h"
+#include <algorithm>
+
+//  The pool and the worker index of the calling thread, if it is one
+//  of the threads of a pool
+static thread_local const DecoderPool *currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+DecoderPool::DecoderPool(size_t numThreads)
+{
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < numThreads; i++) {
+        workers.emplace_back(new Worker());
+    }
+
+    for (size_t i = 0; i < numThreads; i++) {
+        threads.emplace_back(&DecoderPool::run, this, i);
+    }
+}
+
+DecoderPool::~DecoderPool()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    stopping = true;
+    lock.unlock();
+    taskAvailable.notify_all();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void DecoderPool::submit(std::function<void()>&& task)
+{
+    const size_t index = currentPool == this ? currentWorker :
+        nextWorker++ % workers.size();
+
+    auto& worker = *workers[index];
+    std::unique_lock<std::mutex> workerLock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+    workerLock.unlock();
+
+    //  Taking the lock orders the increment with the check of a thread
+    //  going to sleep, so that the wake-up is not lost
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    numQueued++;
+    lock.unlock();
+    taskAvailable.notify_one();
+}
+
+decoder_pool_stats_t DecoderPool::getStats() const
+{
+    decoder_pool_stats_t stats;
+    stats.num_threads = threads.size();
+    stats.num_tasks = numTasks;
+    stats.num_steals = numSteals;
+    return stats;
+}
+
+//  The newest task of the own queue, else the oldest one of another
+//  queue
+bool DecoderPool::takeTask(size_t index, Task& task)
+{
+    auto& own = *workers[index];
+    std::unique_lock<std::mutex> lock(own.mutex);
+    if (not own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+    }
+    lock.unlock();
+
+    for (size_t i = 1; i < workers.size(); i++) {
+        auto& other = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> otherLock(other.mutex);
+        if (not other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            numSteals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DecoderPool::run(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        while (numQueued == 0 and not stopping) {
+            taskAvailable.wait(lock);
+        }
+
+        // The remaining tasks are dropped
+        if (stopping) {
+            return;
+        }
+        lock.unlock();
+
+        Task task;
+        if (takeTask(index, task)) {
+            numQueued--;
+            numTasks++;
+            task();
+        }
+    }
+}
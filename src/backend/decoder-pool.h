@@ -0,0 +1,94 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __DECODER_POOL__
+#define __DECODER_POOL__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct decoder_pool_stats_t {
+    size_t num_threads = 0;
+    // Tasks run, and tasks taken from the queue of another thread
+    size_t num_tasks = 0;
+    size_t num_steals = 0;
+};
+
+/* Fixed number of threads decoding the subchannels of the MSC.
+ *
+ * Each thread has a queue of its own. A task submitted by a task of the
+ * pool goes to the queue of its thread, and runs next on that thread,
+ * while the data it works on is still in the cache. Tasks submitted from
+ * outside are spread over the queues. A thread with an empty queue takes
+ * the oldest task of another thread, so that a burst of work on one
+ * subchannel uses all cores.
+ *
+ * Tasks are not run in a given order. A task must not wait for another
+ * task. */
+class DecoderPool
+{
+    public:
+        // 0 starts one thread per core
+        DecoderPool(size_t numThreads = 0);
+        ~DecoderPool();
+        DecoderPool(const DecoderPool& other) = delete;
+        DecoderPool& operator=(const DecoderPool& other) = delete;
+
+        size_t numThreads(void) const { return threads.size(); }
+
+        void submit(std::function<void()>&& task);
+
+        decoder_pool_stats_t getStats(void) const;
+
+    private:
+        using Task = std::function<void()>;
+
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void run(size_t index);
+        bool takeTask(size_t index, Task& task);
+
+        std::vector<std::unique_ptr<Worker> > workers;
+        // Tasks of the external submitters go to the workers in turn
+        std::atomic<size_t> nextWorker = ATOMIC_VAR_INIT(0);
+
+        // The idle threads sleep until a task is queued
+        std::mutex sleepMutex;
+        std::condition_variable taskAvailable;
+        std::atomic<size_t> numQueued = ATOMIC_VAR_INIT(0);
+        bool stopping = false;
+
+        std::atomic<size_t> numTasks = ATOMIC_VAR_INIT(0);
+        std::atomic<size_t> numSteals = ATOMIC_VAR_INIT(0);
+
+        std::vector<std::thread> threads;
+};
+
+#endif
@@ -26,9 +26,10 @@
 #include <iostream>
 #include "decoder_adapter.h"
 
-DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, AudioServiceComponentType &dabModus, const std::string &dumpFileName):
+DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, AudioServiceComponentType &dabModus, const std::string &dumpFileName, SyncMilestoneTracker &milestones):
     bitRate(bitRate),
-    myInterface(mr),
+    myInterface(&mr),
+    milestones(milestones),
     padDecoder(this, true)
 {
     if (dabModus == AudioServiceComponentType::DAB)
@@ -51,32 +52,39 @@ DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, A
     padDecoder.SetMOTAppType(12);
 }
 
-void DecoderAdapter::addtoFrame(uint8_t *v)
+void DecoderAdapter::addtoFrame(uint8_t *v, const uint8_t *reliability)
 {
+    // The bits of the frame come packed from the Viterbi decoder
     size_t  length  = 24 * bitRate / 8;
-    uint8_t data [24 * bitRate / 8];
-
-    // Convert 8 bits (stored in one uint8) into one uint8
-    for (int i = 0; i < 24 * bitRate / 8; i ++) {
-        data [i] = 0;
-        for (int j = 0; j < 8; j ++) {
-            data [i] <<= 1;
-            data [i] |= v [8 * i + j] & 01;
-        }
-    }
 
-    decoder->Feed(data, length);
+    if (reliability)
+        decoder->FeedWithReliability(v, reliability, length);
+    else
+        decoder->Feed(v, length);
 
     if (dumpFile) {
-        fwrite(data, length, 1, dumpFile.get());
+        fwrite(v, length, 1, dumpFile.get());
     }
 
-    myInterface.onFrameErrors(frameErrorCounter);
+    myInterface->onFrameErrors(frameErrorCounter);
     frameErrorCounter = 0;
 }
 
+void DecoderAdapter::reset(ProgrammeHandlerInterface& mr)
+{
+    myInterface = &mr;
+    frameErrorCounter = 0;
+    dumpFile.reset();
+
+    decoder->Reset();
+    padDecoder.Reset();
+    padDecoder.SetMOTAppType(12);
+}
+
 void DecoderAdapter::FormatChange(const std::string &format)
 {
+    // Called once the decoder found the first frame (DAB) or superframe (DAB+)
+    milestones.reached(SyncMilestone::AudioSync);
     audioFormat = format;
 }
 
@@ -112,7 +120,8 @@ void DecoderAdapter::PutAudio(const uint8_t *data, size_t len)
         }
     }
 
-    myInterface.onNewAudio(
+    milestones.reached(SyncMilestone::FirstAudio);
+    myInterface->onNewAudio(
         std::move(audio),
         audioSamplerate,
         audioChannels == 2,
@@ -133,21 +142,21 @@ void DecoderAdapter::AudioError(const std::string &hint)
 void DecoderAdapter::AudioWarning(const std::string &hint)
 {
     (void)hint;
-    myInterface.onAacErrors(1);
+    myInterface->onAacErrors(1);
 }
 
 void DecoderAdapter::FECInfo(int total_corr_count, bool uncorr_errors)
 {
-    myInterface.onRsErrors(uncorr_errors, total_corr_count);
+    myInterface->onRsErrors(uncorr_errors, total_corr_count);
 }
 
 void DecoderAdapter::PADChangeDynamicLabel(const DL_STATE &dl)
 {
     if (dl.raw.empty()) {
-        myInterface.onNewDynamicLabel("");
+        myInterface->onNewDynamicLabel("");
     }
     else {
-        myInterface.onNewDynamicLabel(
+        myInterface->onNewDynamicLabel(
                 toUtf8StringUsingCharset(
                     dl.raw.data(),
                     (CharacterSet)dl.charset,
@@ -157,10 +166,10 @@ void DecoderAdapter::PADChangeDynamicLabel(const DL_STATE &dl)
 
 void DecoderAdapter::PADChangeSlide(const MOT_FILE &slide)
 {
-    myInterface.onMOT(slide.data, slide.content_sub_type);
+    myInterface->onMOT(slide.data, slide.content_sub_type);
 }
 
 void DecoderAdapter::PADLengthError(size_t announced_xpad_len, size_t xpad_len)
 {
-    myInterface.onPADLengthError(announced_xpad_len, xpad_len);
+    myInterface->onPADLengthError(announced_xpad_len, xpad_len);
 }
@@ -34,6 +34,7 @@
 #include "dab-processor.h"
 #include "pad_decoder.h"
 #include "radio-controller.h"
+#include "sync-milestones.h"
 #include "subchannel_sink.h"
 #include "dab_decoder.h"
 #include "dabplus_decoder.h"
@@ -44,9 +45,15 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
         DecoderAdapter(ProgrammeHandlerInterface& mr,
                      int16_t bitRate,
                      AudioServiceComponentType &dabModus,
-                     const std::string& dumpFileName);
+                     const std::string& dumpFileName,
+                     SyncMilestoneTracker& milestones);
 
-        virtual void addtoFrame(uint8_t *v);
+        virtual void addtoFrame(uint8_t *v, const uint8_t *reliability);
+
+        // Decode another subchannel of the same type and bitrate for
+        // the given handler. The audio decoders are kept, the dump file
+        // is closed.
+        void reset(ProgrammeHandlerInterface& mr);
 
         // SubchannelSinkObserver impl
         virtual void FormatChange(const std::string& /*format*/);
@@ -65,7 +72,8 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
     private:
         int16_t bitRate;
         int frameErrorCounter = 0;
-        ProgrammeHandlerInterface& myInterface;
+        ProgrammeHandlerInterface *myInterface;
+        SyncMilestoneTracker& milestones;
         std::unique_ptr<SubchannelSink> decoder;
         PADDecoder padDecoder;
 
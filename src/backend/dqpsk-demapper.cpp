@@ -0,0 +1,302 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dqpsk-demapper.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(SIMD_X86)
+#  include <immintrin.h>
+#endif
+#if defined(SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
+// The soft bits are scaled to +-127 by the l1 norm of the differential
+// symbol. A carrier with zero energy gives zero soft bits.
+#define SOFT_BIT_SCALE  127.0f
+#define L1_MIN          1e-30f
+
+/* All kernels compute, for carriers i = from .. K-1,
+ *   r1 = c[idx[i]] * conj(ref[i])
+ *   bits[i] = -real(r1) * 127 / l1_norm(r1)
+ *   bits[K + i] = -imag(r1) * 127 / l1_norm(r1)
+ *   ref[i] = c[idx[i]]
+ * with the same floating point operations, so that their output is
+ * identical, apart from the reciprocal used on ARMv7. They return the
+ * number of carriers they handled. */
+static int32_t demap_generic(const DSPCOMPLEX *c, const int32_t *idx,
+        DSPCOMPLEX *ref, int16_t *bits, int32_t K, int32_t from)
+{
+    for (int32_t i = from; i < K; i++) {
+        const DSPCOMPLEX s = c[idx[i]];
+        const DSPCOMPLEX r = ref[i];
+        ref[i] = s;
+
+        const float re = s.real() * r.real() + s.imag() * r.imag();
+        const float im = s.imag() * r.real() - s.real() * r.imag();
+        const float ab = SOFT_BIT_SCALE /
+            std::max(std::abs(re) + std::abs(im), L1_MIN);
+
+        bits[i]     = -re * ab;
+        bits[K + i] = -im * ab;
+    }
+    return K;
+}
+
+#if defined(SIMD_X86)
+SIMD_TARGET("sse2")
+static inline __m128 load_carriers_sse2(const DSPCOMPLEX *c,
+        const int32_t *idx)
+{
+    __m128 v = _mm_setzero_ps();
+    v = _mm_loadl_pi(v, (const __m64*)(c + idx[0]));
+    return _mm_loadh_pi(v, (const __m64*)(c + idx[1]));
+}
+
+SIMD_TARGET("sse2")
+static int32_t demap_sse2(const DSPCOMPLEX *c, const int32_t *idx,
+        DSPCOMPLEX *ref, int16_t *bits, int32_t K)
+{
+    float *r = reinterpret_cast<float*>(ref);
+
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 scale = _mm_set1_ps(SOFT_BIT_SCALE);
+    const __m128 l1_min = _mm_set1_ps(L1_MIN);
+
+    int32_t i = 0;
+    for (; i + 8 <= K; i += 8) {
+        __m128i re32[2];
+        __m128i im32[2];
+
+        for (int h = 0; h < 2; h++) {
+            const int32_t j = i + 4 * h;
+            const __m128 a = load_carriers_sse2(c, idx + j);
+            const __m128 b = load_carriers_sse2(c, idx + j + 2);
+            const __m128 ra = _mm_loadu_ps(r + 2 * j);
+            const __m128 rb = _mm_loadu_ps(r + 2 * j + 4);
+            _mm_storeu_ps(r + 2 * j, a);
+            _mm_storeu_ps(r + 2 * j + 4, b);
+
+            const __m128 s_re = _mm_shuffle_ps(a, b, 0x88);
+            const __m128 s_im = _mm_shuffle_ps(a, b, 0xDD);
+            const __m128 r_re = _mm_shuffle_ps(ra, rb, 0x88);
+            const __m128 r_im = _mm_shuffle_ps(ra, rb, 0xDD);
+
+            const __m128 re = _mm_add_ps(
+                    _mm_mul_ps(s_re, r_re), _mm_mul_ps(s_im, r_im));
+            const __m128 im = _mm_sub_ps(
+                    _mm_mul_ps(s_im, r_re), _mm_mul_ps(s_re, r_im));
+            const __m128 l1 = _mm_add_ps(
+                    _mm_andnot_ps(sign, re), _mm_andnot_ps(sign, im));
+            const __m128 ab = _mm_div_ps(scale, _mm_max_ps(l1, l1_min));
+
+            re32[h] = _mm_cvttps_epi32(_mm_mul_ps(_mm_xor_ps(re, sign), ab));
+            im32[h] = _mm_cvttps_epi32(_mm_mul_ps(_mm_xor_ps(im, sign), ab));
+        }
+
+        _mm_storeu_si128((__m128i*)(bits + i),
+                _mm_packs_epi32(re32[0], re32[1]));
+        _mm_storeu_si128((__m128i*)(bits + K + i),
+                _mm_packs_epi32(im32[0], im32[1]));
+    }
+    return i;
+}
+
+SIMD_TARGET("avx2")
+static inline __m256 load_carriers_avx2(const DSPCOMPLEX *c,
+        const int32_t *idx)
+{
+    // Individual loads are faster than the AVX2 gather instruction on
+    // most CPUs
+    return _mm256_insertf128_ps(
+            _mm256_castps128_ps256(load_carriers_sse2(c, idx)),
+            load_carriers_sse2(c, idx + 2), 1);
+}
+
+SIMD_TARGET("avx2")
+static int32_t demap_avx2(const DSPCOMPLEX *c, const int32_t *idx,
+        DSPCOMPLEX *ref, int16_t *bits, int32_t K)
+{
+    float *r = reinterpret_cast<float*>(ref);
+
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 scale = _mm256_set1_ps(SOFT_BIT_SCALE);
+    const __m256 l1_min = _mm256_set1_ps(L1_MIN);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int32_t i = 0;
+    for (; i + 16 <= K; i += 16) {
+        __m256i re32[2];
+        __m256i im32[2];
+
+        for (int h = 0; h < 2; h++) {
+            const int32_t j = i + 8 * h;
+            const __m256 a = load_carriers_avx2(c, idx + j);
+            const __m256 b = load_carriers_avx2(c, idx + j + 4);
+            const __m256 ra = _mm256_loadu_ps(r + 2 * j);
+            const __m256 rb = _mm256_loadu_ps(r + 2 * j + 8);
+            _mm256_storeu_ps(r + 2 * j, a);
+            _mm256_storeu_ps(r + 2 * j + 8, b);
+
+            // Separate real and imaginary parts. This puts the carriers
+            // in the order 0 1 4 5 2 3 6 7, which is undone after packing
+            const __m256 s_re = _mm256_shuffle_ps(a, b, 0x88);
+            const __m256 s_im = _mm256_shuffle_ps(a, b, 0xDD);
+            const __m256 r_re = _mm256_shuffle_ps(ra, rb, 0x88);
+            const __m256 r_im = _mm256_shuffle_ps(ra, rb, 0xDD);
+
+            const __m256 re = _mm256_add_ps(
+                    _mm256_mul_ps(s_re, r_re), _mm256_mul_ps(s_im, r_im));
+            const __m256 im = _mm256_sub_ps(
+                    _mm256_mul_ps(s_im, r_re), _mm256_mul_ps(s_re, r_im));
+            const __m256 l1 = _mm256_add_ps(
+                    _mm256_andnot_ps(sign, re), _mm256_andnot_ps(sign, im));
+            const __m256 ab = _mm256_div_ps(scale, _mm256_max_ps(l1, l1_min));
+
+            re32[h] = _mm256_cvttps_epi32(
+                    _mm256_mul_ps(_mm256_xor_ps(re, sign), ab));
+            im32[h] = _mm256_cvttps_epi32(
+                    _mm256_mul_ps(_mm256_xor_ps(im, sign), ab));
+        }
+
+        const __m256i re16 = _mm256_permutevar8x32_epi32(
+                _mm256_packs_epi32(re32[0], re32[1]), order);
+        const __m256i im16 = _mm256_permutevar8x32_epi32(
+                _mm256_packs_epi32(im32[0], im32[1]), order);
+        _mm256_storeu_si256((__m256i*)(bits + i), re16);
+        _mm256_storeu_si256((__m256i*)(bits + K + i), im16);
+    }
+    return i;
+}
+#endif
+
+#if defined(SIMD_NEON)
+static int32_t demap_neon(const DSPCOMPLEX *c, const int32_t *idx,
+        DSPCOMPLEX *ref, int16_t *bits, int32_t K)
+{
+    float *r = reinterpret_cast<float*>(ref);
+    const float32x4_t scale = vdupq_n_f32(SOFT_BIT_SCALE);
+    const float32x4_t l1_min = vdupq_n_f32(L1_MIN);
+
+    int32_t i = 0;
+    for (; i + 4 <= K; i += 4) {
+        // NEON has no gather, assemble the four carriers first
+        float32x4x2_t s;
+        s.val[0] = vsetq_lane_f32(c[idx[i]].real(), vdupq_n_f32(0), 0);
+        s.val[1] = vsetq_lane_f32(c[idx[i]].imag(), vdupq_n_f32(0), 0);
+        s.val[0] = vsetq_lane_f32(c[idx[i + 1]].real(), s.val[0], 1);
+        s.val[1] = vsetq_lane_f32(c[idx[i + 1]].imag(), s.val[1], 1);
+        s.val[0] = vsetq_lane_f32(c[idx[i + 2]].real(), s.val[0], 2);
+        s.val[1] = vsetq_lane_f32(c[idx[i + 2]].imag(), s.val[1], 2);
+        s.val[0] = vsetq_lane_f32(c[idx[i + 3]].real(), s.val[0], 3);
+        s.val[1] = vsetq_lane_f32(c[idx[i + 3]].imag(), s.val[1], 3);
+
+        const float32x4x2_t rr = vld2q_f32(r + 2 * i);
+        vst2q_f32(r + 2 * i, s);
+
+        const float32x4_t re = vaddq_f32(
+                vmulq_f32(s.val[0], rr.val[0]), vmulq_f32(s.val[1], rr.val[1]));
+        const float32x4_t im = vsubq_f32(
+                vmulq_f32(s.val[1], rr.val[0]), vmulq_f32(s.val[0], rr.val[1]));
+        const float32x4_t l1 = vmaxq_f32(
+                vaddq_f32(vabsq_f32(re), vabsq_f32(im)), l1_min);
+#if defined(__aarch64__)
+        const float32x4_t ab = vdivq_f32(scale, l1);
+#else
+        // No division on ARMv7, refine the reciprocal estimate instead
+        float32x4_t inv = vrecpeq_f32(l1);
+        inv = vmulq_f32(vrecpsq_f32(l1, inv), inv);
+        inv = vmulq_f32(vrecpsq_f32(l1, inv), inv);
+        const float32x4_t ab = vmulq_f32(scale, inv);
+#endif
+
+        vst1_s16(bits + i, vqmovn_s32(vcvtq_s32_f32(
+                        vmulq_f32(vnegq_f32(re), ab))));
+        vst1_s16(bits + K + i, vqmovn_s32(vcvtq_s32_f32(
+                        vmulq_f32(vnegq_f32(im), ab))));
+    }
+    return i;
+}
+#endif
+
+DqpskDemapper::DqpskDemapper(const DABParams& p,
+        FrequencyInterleaver& interleaver,
+        size_t constellationDecimation,
+        SimdLevel level) :
+    K(p.K),
+    constellationDecimation(constellationDecimation),
+    level(simdLevelSupported(level) ? level : SimdLevel::Generic),
+    gatherIndex(p.K),
+    reference(p.K)
+{
+    /* The negative carriers are at the end of the FFT output, the
+     * positive/negative frequencies are not interchanged.
+     * The gather table takes care of it. */
+    for (int32_t i = 0; i < K; i++) {
+        int32_t index = interleaver.mapIn(i);
+        if (index < 0)
+            index += p.T_u;
+        gatherIndex[i] = index;
+    }
+}
+
+void DqpskDemapper::setReference(const DSPCOMPLEX *carriers)
+{
+    for (int32_t i = 0; i < K; i++) {
+        reference[i] = carriers[gatherIndex[i]];
+    }
+}
+
+void DqpskDemapper::demap(const DSPCOMPLEX *carriers, int16_t *softBits,
+        DSPCOMPLEX *constellation)
+{
+    if (constellation) {
+        for (int32_t i = 0; i < K; i += constellationDecimation) {
+            *constellation++ = carriers[gatherIndex[i]] * conj(reference[i]);
+        }
+    }
+
+    int32_t done = 0;
+    switch (level) {
+#if defined(SIMD_X86)
+        case SimdLevel::SSE2:
+            done = demap_sse2(carriers, gatherIndex.data(), reference.data(),
+                    softBits, K);
+            break;
+        case SimdLevel::AVX2:
+            done = demap_avx2(carriers, gatherIndex.data(), reference.data(),
+                    softBits, K);
+            break;
+#endif
+#if defined(SIMD_NEON)
+        case SimdLevel::NEON:
+            done = demap_neon(carriers, gatherIndex.data(), reference.data(),
+                    softBits, K);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    demap_generic(carriers, gatherIndex.data(), reference.data(),
+            softBits, K, done);
+}
@@ -0,0 +1,68 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __DQPSK_DEMAPPER__
+#define __DQPSK_DEMAPPER__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "dab-constants.h"
+#include "freq-interleaver.h"
+#include "cpu_features.h"
+
+/* Differential demodulation of the K carriers of a symbol into 2K soft
+ * bits, in frequency de-interleaved order.
+ *
+ * The carriers are taken from the FFT output through a gather table
+ * that already contains the frequency de-interleaving. The phase
+ * reference is kept in the same de-interleaved order, so that it can be
+ * read and written sequentially. */
+class DqpskDemapper
+{
+    public:
+        DqpskDemapper(const DABParams& p,
+                FrequencyInterleaver& interleaver,
+                size_t constellationDecimation,
+                SimdLevel level = detectSimdLevel());
+
+        // Take the FFT output of the phase reference symbol as reference
+        void setReference(const DSPCOMPLEX *carriers);
+
+        // Demap the FFT output of a data symbol into 2K soft bits,
+        // and keep it as reference for the next symbol. If constellation
+        // is not null, every constellationDecimation-th differential
+        // symbol is written to it (K / constellationDecimation points).
+        void demap(const DSPCOMPLEX *carriers, int16_t *softBits,
+                DSPCOMPLEX *constellation = nullptr);
+
+        SimdLevel getSimdLevel(void) const { return level; }
+
+    private:
+        int32_t K;
+        size_t constellationDecimation;
+        SimdLevel level;
+
+        // FFT bin of the i-th de-interleaved carrier
+        std::vector<int32_t> gatherIndex;
+        std::vector<DSPCOMPLEX> reference;
+};
+
+#endif
@@ -20,10 +20,18 @@
  *
  *  The eep handling
  */
+#include <map>
+#include <mutex>
+#include <tuple>
 #include "dab-constants.h"
 #include "eep-protection.h"
 #include "protTables.h"
 
+// The schedules of all EEP handlers, by bitrate, profile and level.
+// The entries are never removed, the handlers keep references to them.
+static std::mutex schedulesMutex;
+static std::map<std::tuple<int16_t, bool, int>, PunctureSchedule> schedules;
+
 /**
  * \brief eep_deconvolve
  * equal error protection, bitRate and protLevel
@@ -31,9 +39,23 @@
  */
 EEPProtection::EEPProtection(int16_t bitRate, bool profile_is_eep_a, int level) :
     Viterbi(24 * bitRate),
-    outSize(24 * bitRate),
-    viterbiBlock(outSize * 4 + 24)
+    schedule(getSchedule(bitRate, profile_is_eep_a, level))
+{
+}
+
+const PunctureSchedule& EEPProtection::getSchedule(int16_t bitRate,
+        bool profile_is_eep_a, int level)
 {
+    std::lock_guard<std::mutex> lock(schedulesMutex);
+    const auto key = std::make_tuple(bitRate, profile_is_eep_a, level);
+    auto it = schedules.find(key);
+    if (it != schedules.end()) {
+        return it->second;
+    }
+
+    int16_t L1, L2;
+    const int8_t *PI1, *PI2;
+
     if (profile_is_eep_a) {
         switch (level) {
             case 1:
@@ -110,6 +132,21 @@ EEPProtection::EEPProtection(int16_t bitRate, bool profile_is_eep_a, int level)
                 throw std::logic_error("Invalid EEP_A level");
         }
     }
+
+    //  according to the standard we process the logical frame
+    //  with a pair of tuples
+    //  (L1, PI1), (L2, PI2)
+    //  followed by a final block of 24 bits with puncturing according
+    //  to PI_X. This block constitues the 6 * 4 bits of the register itself.
+    PunctureSchedule& schedule = schedules[key];
+    schedule.addBlocks(L1, PI1);
+    schedule.addBlocks(L2, PI2);
+    schedule.addTail(PI_X);
+
+    // Bitrates that are not a multiple of the profile granularity give
+    // a shorter schedule than the frame
+    schedule.resize(4 * 24 * bitRate + 24);
+    return schedule;
 }
 
 bool EEPProtection::deconvolve(
@@ -117,40 +154,8 @@ bool EEPProtection::deconvolve(
         int32_t size,
         uint8_t *outBuffer)
 {
-    int16_t i, j;
-    int32_t inputCounter    = 0;
-    int32_t viterbiCounter  = 0;
     (void)size;         // currently unused
-    memset(viterbiBlock.data(), 0, (outSize * 4 + 24) * sizeof(int16_t));
-    //
-    //  according to the standard we process the logical frame
-    //  with a pair of tuples
-    //  (L1, PI1), (L2, PI2)
-    //
-    for (i = 0; i < L1; i ++) {
-        for (j = 0; j < 128; j ++) {
-            if (PI1 [j % 32] != 0)
-                viterbiBlock[viterbiCounter] = v [inputCounter ++];
-            viterbiCounter++;
-        }
-    }
-
-    for (i = 0; i < L2; i ++) {
-        for (j = 0; j < 128; j ++) {
-            if (PI2 [j % 32] != 0)
-                viterbiBlock[viterbiCounter] = v [inputCounter ++];
-            viterbiCounter++;
-        }
-    }
-    //  we had a final block of 24 bits  with puncturing according to PI_X
-    //  This block constitues the 6 * 4 bits of the register itself.
-    for (i = 0; i < 24; i ++) {
-        if (PI_X [i] != 0)
-            viterbiBlock[viterbiCounter] = v [inputCounter ++];
-        viterbiCounter++;
-    }
-
-    Viterbi::deconvolve(viterbiBlock.data(), outBuffer);
+    Viterbi::deconvolve(v, schedule, outBuffer);
     return true;
 }
 
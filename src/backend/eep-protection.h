@@ -32,13 +32,13 @@ class EEPProtection: public Protection, public Viterbi {
     public:
         EEPProtection(int16_t bitRate, bool profile_is_eep_a, int level);
         bool deconvolve(int16_t *v, int32_t size, uint8_t *outBuffer);
+
+        // The schedule of the (L1, PI1), (L2, PI2) profile, built on the
+        // first use and shared by all handlers with the same settings
+        static const PunctureSchedule& getSchedule(int16_t bitRate,
+                bool profile_is_eep_a, int level);
     private:
-        int16_t L1;
-        int16_t L2;
-        const int8_t *PI1;
-        const int8_t *PI2;
-        int32_t outSize;
-        std::vector<int16_t> viterbiBlock;
+        const PunctureSchedule& schedule;
 };
 
 #endif
@@ -0,0 +1,131 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    Copyright (C) 2013
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Programming
+ *
+ *    This file is part of the SDR-J (JSDR).
+ *    SDR-J is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    SDR-J is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with SDR-J; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "energy_dispersal.h"
+#include <cstring>
+
+#if defined(SIMD_X86)
+#  include <immintrin.h>
+#endif
+#if defined(SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
+/* All kernels XOR the PRBS onto the first bytes of data, and return the
+ * number of bytes they handled. The generic one does the rest. */
+
+static size_t xor_generic(uint8_t *data, const uint8_t *prbs, size_t length)
+{
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t d, p;
+        memcpy(&d, data + i, 8);
+        memcpy(&p, prbs + i, 8);
+        d ^= p;
+        memcpy(data + i, &d, 8);
+    }
+    for (; i < length; i++) {
+        data[i] ^= prbs[i];
+    }
+    return i;
+}
+
+#if defined(SIMD_X86)
+SIMD_TARGET("sse2")
+static size_t xor_sse2(uint8_t *data, const uint8_t *prbs, size_t length)
+{
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i d = _mm_loadu_si128((const __m128i *)(data + i));
+        const __m128i p = _mm_loadu_si128((const __m128i *)(prbs + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(d, p));
+    }
+    return i;
+}
+
+SIMD_TARGET("avx2")
+static size_t xor_avx2(uint8_t *data, const uint8_t *prbs, size_t length)
+{
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m256i d = _mm256_loadu_si256((const __m256i *)(data + i));
+        const __m256i p = _mm256_loadu_si256((const __m256i *)(prbs + i));
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(d, p));
+    }
+    return i;
+}
+#endif
+
+#if defined(SIMD_NEON)
+static size_t xor_neon(uint8_t *data, const uint8_t *prbs, size_t length)
+{
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        vst1q_u8(data + i, veorq_u8(vld1q_u8(data + i), vld1q_u8(prbs + i)));
+    }
+    return i;
+}
+#endif
+
+EnergyDispersal::EnergyDispersal(SimdLevel level) :
+    level(simdLevelSupported(level) ? level : SimdLevel::Generic)
+{
+}
+
+void EnergyDispersal::dedisperse(uint8_t *data, size_t length)
+{
+    if (prbs.size() != length) {
+        // The PRBS starts again with the register all ones for every frame
+        uint16_t shiftRegister = 0x1FF;
+
+        prbs.assign(length, 0);
+        for (size_t i = 0; i < 8 * length; i++) {
+            const uint8_t b = ((shiftRegister >> 8) ^ (shiftRegister >> 4)) & 1;
+            shiftRegister = (shiftRegister << 1) | b;
+            prbs[i / 8] |= b << (7 - i % 8);
+        }
+    }
+
+    size_t done = 0;
+    switch (level) {
+#if defined(SIMD_X86)
+        case SimdLevel::SSE2:
+            done = xor_sse2(data, prbs.data(), length);
+            break;
+        case SimdLevel::AVX2:
+            done = xor_avx2(data, prbs.data(), length);
+            break;
+#endif
+#if defined(SIMD_NEON)
+        case SimdLevel::NEON:
+            done = xor_neon(data, prbs.data(), length);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    xor_generic(data + done, prbs.data() + done, length - done);
+}
@@ -25,36 +25,29 @@
 #ifndef __ENERGY_DISPERSAL
 #define __ENERGY_DISPERSAL
 
+#include <cstddef>
 #include <cstdint>
-#include <cstring>
 #include <vector>
-#include <stdexcept>
+#include "cpu_features.h"
 
+/* Energy dispersal of EN 300 401 clause 10.2, on packed bits.
+ *
+ * The PRBS is packed like the output of the Viterbi decoder, the first
+ * bit in the most significant bit of the first byte. It is computed once
+ * for the frame length, and XORed onto the frame 64, 128 or 256 bits at
+ * a time. */
 class EnergyDispersal {
     public:
-        void dedisperse(std::vector<uint8_t>& data)
-        {
-            if (dispersalVector.size() != data.size()) {
-                std::vector<uint8_t> shiftRegister(9, 1);
-
-                dispersalVector.resize(data.size());
+        EnergyDispersal(SimdLevel level = detectSimdLevel());
 
-                for (size_t i = 0; i < data.size(); i++) {
-                    uint8_t b = shiftRegister[8] ^ shiftRegister[4];
-                    for (int j = 8; j > 0; j--)
-                        shiftRegister[j] = shiftRegister[j - 1];
-                    shiftRegister[0] = b;
-                    dispersalVector[i] ^= b;
-                }
-            }
+        // Remove the dispersal from the length bytes of data
+        void dedisperse(uint8_t *data, size_t length);
 
-            for (size_t i = 0; i < data.size(); i++) {
-                data[i] ^= dispersalVector[i];
-            }
-        }
+        SimdLevel getSimdLevel(void) const { return level; }
 
     private:
-        std::vector<uint8_t> dispersalVector;
+        SimdLevel level;
+        std::vector<uint8_t> prbs;
 };
 
 #endif // __ENERGY_DISPERSAL
@@ -31,13 +31,15 @@
 #include "charsets.h"
 #include "MathHelper.h"
 
-FIBProcessor::FIBProcessor(RadioControllerInterface& mr) :
-    myRadioInterface(mr)
+FIBProcessor::FIBProcessor(RadioControllerInterface& mr,
+        SyncMilestoneTracker& milestones) :
+    myRadioInterface(mr),
+    milestones(milestones)
 {
     clearEnsemble();
 }
 
-//  FIB's are segments of 256 bits. When here, we already
+//  FIB's are segments of 32 bytes. When here, we already
 //  passed the crc and we start unpacking into FIGs
 //  This is merely a dispatcher
 void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
@@ -49,7 +51,7 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
 
     (void)fib;
     while (processedBytes  < 30) {
-        const uint8_t FIGtype = getBits_3 (d, 0);
+        const uint8_t FIGtype = getPackedBits(d, 0, 3);
         switch (FIGtype) {
             case 0:
                 process_FIG0 (d);
@@ -68,8 +70,8 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
         }
         //  Thanks to Ronny Kunze, who discovered that I used
         //  a p rather than a d
-        processedBytes += getBits_5 (d, 3) + 1;
-        d = p + processedBytes * 8;
+        processedBytes += getPackedBits(d, 3, 5) + 1;
+        d = p + processedBytes;
     }
 }
 //
@@ -77,8 +79,8 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
 //
 void FIBProcessor::process_FIG0 (uint8_t *d)
 {
-    uint8_t extension   = getBits_5 (d, 8 + 3);
-    //uint8_t   CN  = getBits_1 (d, 8 + 0);
+    uint8_t extension   = getPackedBits(d, 8 + 3, 5);
+    //uint8_t   CN  = getPackedBits(d, 8 + 0, 1);
 
     switch (extension) {
         case 0: FIG0Extension0 (d); break;
@@ -111,20 +113,22 @@ void FIBProcessor::FIG0Extension0 (uint8_t *d)
     uint8_t     changeflag;
     uint16_t    highpart, lowpart;
     int16_t     occurrenceChange;
-    uint8_t CN  = getBits_1 (d, 8 + 0);
+    uint8_t CN  = getPackedBits(d, 8 + 0, 1);
     (void)CN;
 
-    ensembleId  = getBits(d, 16, 16);
+    ensembleId  = getPackedBits(d, 16, 16);
 
-    changeflag  = getBits_2 (d, 16 + 16);
+    changeflag  = getPackedBits(d, 16 + 16, 2);
     if (changeflag == 0)
         return;
 
-    highpart        = getBits_5 (d, 16 + 19) % 20;
+    changeCount++;
+
+    highpart        = getPackedBits(d, 16 + 19, 5) % 20;
     (void)highpart;
-    lowpart         = getBits_8 (d, 16 + 24) % 250;
+    lowpart         = getPackedBits(d, 16 + 24, 8) % 250;
     (void)lowpart;
-    occurrenceChange    = getBits_8 (d, 16 + 32);
+    occurrenceChange    = getPackedBits(d, 16 + 32, 8);
     (void)occurrenceChange;
 
     //  if (changeflag == 1) {
@@ -148,9 +152,9 @@ void FIBProcessor::FIG0Extension0 (uint8_t *d)
 void FIBProcessor::FIG0Extension1 (uint8_t *d)
 {
     int16_t used    = 2;        // offset in bytes
-    int16_t Length  = getBits_5 (d, 3);
-    uint8_t PD_bit  = getBits_1 (d, 8 + 2);
-    //uint8_t   CN  = getBits_1 (d, 8 + 0);
+    int16_t Length  = getPackedBits(d, 3, 5);
+    uint8_t PD_bit  = getPackedBits(d, 8 + 2, 1);
+    //uint8_t   CN  = getPackedBits(d, 8 + 0, 1);
 
     while (used < Length - 1)
         used = HandleFIG0Extension1 (d, used, PD_bit);
@@ -163,13 +167,14 @@ int16_t FIBProcessor::HandleFIG0Extension1(
         uint8_t pd)
 {
     int16_t bitOffset = offset * 8;
-    const int16_t subChId   = getBits_6 (d, bitOffset);
-    const int16_t startAdr  = getBits(d, bitOffset + 6, 10);
+    const int16_t subChId   = getPackedBits(d, bitOffset, 6);
+    const int16_t startAdr  = getPackedBits(d, bitOffset + 6, 10);
+    const Subchannel before = subChannels[subChId];
     subChannels[subChId].programmeNotData = pd;
     subChannels[subChId].subChId = subChId;
     subChannels[subChId].startAddr = startAdr;
-    if (getBits_1 (d, bitOffset + 16) == 0) {   // UEP, short form
-        int16_t tableIx = getBits_6 (d, bitOffset + 18);
+    if (getPackedBits(d, bitOffset + 16, 1) == 0) {   // UEP, short form
+        int16_t tableIx = getPackedBits(d, bitOffset + 18, 6);
         auto& ps = subChannels[subChId].protectionSettings;
         ps.uepTableIndex = tableIx;
         ps.shortForm = true;
@@ -181,7 +186,7 @@ int16_t FIBProcessor::HandleFIG0Extension1(
     else {  // EEP, long form
         auto& ps = subChannels[subChId].protectionSettings;
         ps.shortForm  = false;
-        int16_t option = getBits_3(d, bitOffset + 17);
+        int16_t option = getPackedBits(d, bitOffset + 17, 3);
         if (option == 0) {
             ps.eepProfile = EEPProtectionProfile::EEP_A;
         }
@@ -191,7 +196,7 @@ int16_t FIBProcessor::HandleFIG0Extension1(
 
         if (option == 0 or   // EEP-A protection
             option == 1) {   // EEP-B protection
-            int16_t protLevel = getBits_2(d, bitOffset + 20);
+            int16_t protLevel = getPackedBits(d, bitOffset + 20, 2);
             switch (protLevel) {
                 case 0:
                     ps.eepLevel = EEPProtectionLevel::EEP_1;
@@ -212,7 +217,7 @@ int16_t FIBProcessor::HandleFIG0Extension1(
                     break;
             }
 
-            int16_t subChanSize = getBits(d, bitOffset + 22, 10);
+            int16_t subChanSize = getPackedBits(d, bitOffset + 22, 10);
             subChannels[subChId].length = subChanSize;
         }
         else {
@@ -223,15 +228,29 @@ int16_t FIBProcessor::HandleFIG0Extension1(
         bitOffset += 32;
     }
 
+    const Subchannel& after = subChannels[subChId];
+    const auto& ps = after.protectionSettings;
+    const auto& psBefore = before.protectionSettings;
+    if (after.subChId != before.subChId or
+            after.startAddr != before.startAddr or
+            after.length != before.length or
+            after.programmeNotData != before.programmeNotData or
+            ps.shortForm != psBefore.shortForm or
+            ps.uepTableIndex != psBefore.uepTableIndex or
+            ps.eepProfile != psBefore.eepProfile or
+            ps.eepLevel != psBefore.eepLevel) {
+        changeCount++;
+    }
+
     return bitOffset / 8;   // we return bytes
 }
 
 void FIBProcessor::FIG0Extension2 (uint8_t *d)
 {
     int16_t used    = 2;        // offset in bytes
-    int16_t Length  = getBits_5 (d, 3);
-    uint8_t PD_bit  = getBits_1 (d, 8 + 2);
-    uint8_t CN      = getBits_1 (d, 8 + 0);
+    int16_t Length  = getPackedBits(d, 3, 5);
+    uint8_t PD_bit  = getPackedBits(d, 8 + 2, 1);
+    uint8_t CN      = getPackedBits(d, 8 + 0, 1);
 
     while (used < Length) {
         used = HandleFIG0Extension2(d, used, CN, PD_bit);
@@ -255,15 +274,15 @@ int16_t FIBProcessor::HandleFIG0Extension2(
     int16_t     numberofComponents;
 
     if (pd == 1) {      // long Sid
-        ecc = getBits_8(d, lOffset);   (void)ecc;
-        cId = getBits_4(d, lOffset + 1);
-        SId = getBits(d, lOffset, 32);
+        ecc = getPackedBits(d, lOffset, 8);   (void)ecc;
+        cId = getPackedBits(d, lOffset + 1, 4);
+        SId = getPackedBits(d, lOffset, 32);
         lOffset += 32;
     }
     else {
-        cId = getBits_4(d, lOffset);   (void)cId;
-        SId = getBits(d, lOffset + 4, 12);
-        SId = getBits(d, lOffset, 16);
+        cId = getPackedBits(d, lOffset, 4);   (void)cId;
+        SId = getPackedBits(d, lOffset + 4, 12);
+        SId = getPackedBits(d, lOffset, 16);
         lOffset += 16;
     }
 
@@ -309,29 +328,30 @@ int16_t FIBProcessor::HandleFIG0Extension2(
 
     if (findServiceId(SId) == nullptr and serviceRepeatCount[SId] >= 2) {
         services.emplace_back(SId);
+        changeCount++;
     }
 
-    numberofComponents = getBits_4(d, lOffset + 4);
+    numberofComponents = getPackedBits(d, lOffset + 4, 4);
     lOffset += 8;
 
     for (i = 0; i < numberofComponents; i ++) {
-        uint8_t TMid    = getBits_2 (d, lOffset);
+        uint8_t TMid    = getPackedBits(d, lOffset, 2);
         if (TMid == 00)  {  // Audio
-            uint8_t ASCTy   = getBits_6 (d, lOffset + 2);
-            uint8_t SubChId = getBits_6 (d, lOffset + 8);
-            uint8_t PS_flag = getBits_1 (d, lOffset + 14);
+            uint8_t ASCTy   = getPackedBits(d, lOffset + 2, 6);
+            uint8_t SubChId = getPackedBits(d, lOffset + 8, 6);
+            uint8_t PS_flag = getPackedBits(d, lOffset + 14, 1);
             bindAudioService(TMid, SId, i, SubChId, PS_flag, ASCTy);
         }
         else if (TMid == 1) { // MSC stream data
-            uint8_t DSCTy   = getBits_6 (d, lOffset + 2);
-            uint8_t SubChId = getBits_6 (d, lOffset + 8);
-            uint8_t PS_flag = getBits_1 (d, lOffset + 14);
+            uint8_t DSCTy   = getPackedBits(d, lOffset + 2, 6);
+            uint8_t SubChId = getPackedBits(d, lOffset + 8, 6);
+            uint8_t PS_flag = getPackedBits(d, lOffset + 14, 1);
             bindDataStreamService(TMid, SId, i, SubChId, PS_flag, DSCTy);
         }
         else if (TMid == 3) { // MSC packet data
-            int16_t SCId    = getBits (d, lOffset + 2, 12);
-            uint8_t PS_flag = getBits_1 (d, lOffset + 14);
-            uint8_t CA_flag = getBits_1 (d, lOffset + 15);
+            int16_t SCId    = getPackedBits(d, lOffset + 2, 12);
+            uint8_t PS_flag = getPackedBits(d, lOffset + 14, 1);
+            uint8_t CA_flag = getPackedBits(d, lOffset + 15, 1);
             bindPacketService(TMid, SId, i, SCId, PS_flag, CA_flag);
         }
         else {
@@ -349,7 +369,7 @@ int16_t FIBProcessor::HandleFIG0Extension2(
 void FIBProcessor::FIG0Extension3 (uint8_t *d)
 {
     int16_t used    = 2;
-    int16_t Length  = getBits_5 (d, 3);
+    int16_t Length  = getPackedBits(d, 3, 5);
 
     while (used < Length)
         used = HandleFIG0Extension3 (d, used);
@@ -358,13 +378,13 @@ void FIBProcessor::FIG0Extension3 (uint8_t *d)
 //      DSCTy   DataService Component Type
 int16_t FIBProcessor::HandleFIG0Extension3(uint8_t *d, int16_t used)
 {
-    int16_t SCId            = getBits (d, used * 8, 12);
-    //int16_t CAOrgflag       = getBits_1 (d, used * 8 + 15);
-    int16_t DGflag          = getBits_1 (d, used * 8 + 16);
-    int16_t DSCTy           = getBits_6 (d, used * 8 + 18);
-    int16_t SubChId         = getBits_6 (d, used * 8 + 24);
-    int16_t packetAddress   = getBits (d, used * 8 + 30, 10);
-    //uint16_t        CAOrg   = getBits (d, used * 8 + 40, 16);
+    int16_t SCId            = getPackedBits(d, used * 8, 12);
+    //int16_t CAOrgflag       = getPackedBits(d, used * 8 + 15, 1);
+    int16_t DGflag          = getPackedBits(d, used * 8 + 16, 1);
+    int16_t DSCTy           = getPackedBits(d, used * 8 + 18, 6);
+    int16_t SubChId         = getPackedBits(d, used * 8 + 24, 6);
+    int16_t packetAddress   = getPackedBits(d, used * 8 + 30, 10);
+    //uint16_t        CAOrg   = getPackedBits(d, used * 8 + 40, 16);
 
     ServiceComponent *packetComp = findPacketComponent(SCId);
 
@@ -381,7 +401,7 @@ int16_t FIBProcessor::HandleFIG0Extension3(uint8_t *d, int16_t used)
 void FIBProcessor::FIG0Extension5 (uint8_t *d)
 {
     int16_t used    = 2;        // offset in bytes
-    int16_t Length  = getBits_5 (d, 3);
+    int16_t Length  = getPackedBits(d, 3, 5);
 
     while (used < Length) {
         used = HandleFIG0Extension5 (d, used);
@@ -391,20 +411,20 @@ void FIBProcessor::FIG0Extension5 (uint8_t *d)
 int16_t FIBProcessor::HandleFIG0Extension5(uint8_t* d, int16_t offset)
 {
     int16_t loffset = offset * 8;
-    uint8_t lsFlag  = getBits_1 (d, loffset);
+    uint8_t lsFlag  = getPackedBits(d, loffset, 1);
     int16_t subChId, serviceComp, language;
 
     if (lsFlag == 0) {  // short form
-        if (getBits_1 (d, loffset + 1) == 0) {
-            subChId = getBits_6 (d, loffset + 2);
-            language = getBits_8 (d, loffset + 8);
+        if (getPackedBits(d, loffset + 1, 1) == 0) {
+            subChId = getPackedBits(d, loffset + 2, 6);
+            language = getPackedBits(d, loffset + 8, 8);
             subChannels[subChId].language = language;
         }
         loffset += 16;
     }
     else {          // long form
-        serviceComp = getBits (d, loffset + 4, 12);
-        language    = getBits_8 (d, loffset + 16);
+        serviceComp = getPackedBits(d, loffset + 4, 12);
+        language    = getPackedBits(d, loffset + 16, 8);
         loffset += 24;
     }
     (void)serviceComp;
@@ -415,8 +435,8 @@ int16_t FIBProcessor::HandleFIG0Extension5(uint8_t* d, int16_t offset)
 void FIBProcessor::FIG0Extension8 (uint8_t *d)
 {
     int16_t used    = 2;        // offset in bytes
-    int16_t Length  = getBits_5 (d, 3);
-    uint8_t PD_bit  = getBits_1 (d, 8 + 2);
+    int16_t Length  = getPackedBits(d, 3, 5);
+    uint8_t PD_bit  = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length) {
         used = HandleFIG0Extension8 (d, used, PD_bit);
@@ -429,7 +449,7 @@ int16_t FIBProcessor::HandleFIG0Extension8(
         uint8_t pdBit)
 {
     int16_t  lOffset = used * 8;
-    uint32_t SId = getBits(d, lOffset, pdBit == 1 ? 32 : 16);
+    uint32_t SId = getPackedBits(d, lOffset, pdBit == 1 ? 32 : 16);
     uint8_t  lsFlag;
     uint16_t SCIds;
     int16_t  SCid;
@@ -438,21 +458,21 @@ int16_t FIBProcessor::HandleFIG0Extension8(
     uint8_t  extensionFlag;
 
     lOffset += pdBit == 1 ? 32 : 16;
-    extensionFlag   = getBits_1 (d, lOffset);
-    SCIds   = getBits_4 (d, lOffset + 4);
+    extensionFlag   = getPackedBits(d, lOffset, 1);
+    SCIds   = getPackedBits(d, lOffset + 4, 4);
     lOffset += 8;
 
-    lsFlag  = getBits_1 (d, lOffset + 8);
+    lsFlag  = getPackedBits(d, lOffset + 8, 1);
     if (lsFlag == 1) {
-        SCid = getBits (d, lOffset + 4, 12);
+        SCid = getPackedBits(d, lOffset + 4, 12);
         lOffset += 16;
         //           if (findPacketComponent ((SCIds << 4) | SCid) != NULL) {
         //              std::clog << "fib-processor:" << "packet component bestaat !!\n") << std::endl;
         //           }
     }
     else {
-        MSCflag = getBits_1 (d, lOffset + 1);
-        SubChId = getBits_6 (d, lOffset + 2);
+        MSCflag = getPackedBits(d, lOffset + 1, 1);
+        SubChId = getPackedBits(d, lOffset + 2, 6);
         lOffset += 8;
     }
     if (extensionFlag)
@@ -471,19 +491,19 @@ void FIBProcessor::FIG0Extension9(uint8_t *d)
 {
     int16_t offset  = 16;
 
-    dateTime.hourOffset = (getBits_1 (d, offset + 2) == 1) ?
-        -1 * getBits_4 (d, offset + 3):
-        getBits_4 (d, offset + 3);
-    dateTime.minuteOffset = (getBits_1 (d, offset + 7) == 1) ? 30 : 0;
+    dateTime.hourOffset = (getPackedBits(d, offset + 2, 1) == 1) ?
+        -1 * getPackedBits(d, offset + 3, 4):
+        getPackedBits(d, offset + 3, 4);
+    dateTime.minuteOffset = (getPackedBits(d, offset + 7, 1) == 1) ? 30 : 0;
     timeOffsetReceived = true;
 
-    ensembleEcc = getBits(d, offset + 8, 8);
+    ensembleEcc = getPackedBits(d, offset + 8, 8);
 }
 
 void FIBProcessor::FIG0Extension10(uint8_t *fig)
 {
     int16_t     offset = 16;
-    int32_t     mjd = getBits(fig, offset + 1, 17);
+    int32_t     mjd = getPackedBits(fig, offset + 1, 17);
     // Convert Modified Julian Date (according to wikipedia)
     int32_t J   = mjd + 2400001;
     int32_t j   = J + 32044;
@@ -505,13 +525,13 @@ void FIBProcessor::FIG0Extension10(uint8_t *fig)
     dateTime.year = Y;
     dateTime.month = M;
     dateTime.day = D;
-    dateTime.hour = getBits_5(fig, offset + 21);
-    if (getBits_6(fig, offset + 26) != dateTime.minutes)
+    dateTime.hour = getPackedBits(fig, offset + 21, 5);
+    if ((int)getPackedBits(fig, offset + 26, 6) != dateTime.minutes)
         dateTime.seconds =  0;  // handle overflow
 
-    dateTime.minutes = getBits_6(fig, offset + 26);
-    if (fig [offset + 20] == 1) {
-        dateTime.seconds = getBits_6(fig, offset + 32);
+    dateTime.minutes = getPackedBits(fig, offset + 26, 6);
+    if (getPackedBits(fig, offset + 20, 1) == 1) {
+        dateTime.seconds = getPackedBits(fig, offset + 32, 6);
     }
 
     if (timeOffsetReceived) {
@@ -522,8 +542,8 @@ void FIBProcessor::FIG0Extension10(uint8_t *fig)
 void FIBProcessor::FIG0Extension13 (uint8_t *d)
 {
     int16_t used    = 2;        // offset in bytes
-    int16_t Length  = getBits_5 (d, 3);
-    uint8_t PD_bit  = getBits_1 (d, 8 + 2);
+    int16_t Length  = getPackedBits(d, 3, 5);
+    uint8_t PD_bit  = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length) {
         used = HandleFIG0Extension13 (d, used, PD_bit);
@@ -536,19 +556,19 @@ int16_t FIBProcessor::HandleFIG0Extension13(
         uint8_t pdBit)
 {
     int16_t  lOffset = used * 8;
-    uint32_t SId = getBits(d, lOffset, pdBit == 1 ? 32 : 16);
+    uint32_t SId = getPackedBits(d, lOffset, pdBit == 1 ? 32 : 16);
     uint16_t SCIds;
     int16_t  NoApplications;
     int16_t  i;
 
     lOffset     += pdBit == 1 ? 32 : 16;
-    SCIds       = getBits_4 (d, lOffset);
-    NoApplications = getBits_4 (d, lOffset + 4);
+    SCIds       = getPackedBits(d, lOffset, 4);
+    NoApplications = getPackedBits(d, lOffset + 4, 4);
     lOffset += 8;
 
     for (i = 0; i < NoApplications; i++) {
-        int16_t appType = getBits (d, lOffset, 11);
-        int16_t length  = getBits_5 (d, lOffset + 11);
+        int16_t appType = getPackedBits(d, lOffset, 11);
+        int16_t length  = getPackedBits(d, lOffset + 11, 5);
         lOffset += (11 + 5 + 8 * length);
         switch (appType) {
             case 0x000:     // reserved for future use
@@ -580,12 +600,12 @@ int16_t FIBProcessor::HandleFIG0Extension13(
 
 void FIBProcessor::FIG0Extension14 (uint8_t *d)
 {
-    int16_t length = getBits_5 (d, 3); // in Bytes
+    int16_t length = getPackedBits(d, 3, 5); // in Bytes
     int16_t used   = 2; // in Bytes
 
     while (used < length) {
-        int16_t subChId = getBits_6 (d, used * 8);
-        uint8_t fecScheme = getBits_2 (d, used * 8 + 6);
+        int16_t subChId = getPackedBits(d, used * 8, 6);
+        uint8_t fecScheme = getPackedBits(d, used * 8 + 6, 2);
         used = used + 1;
 
         for (int i = 0; i < 64; i++) {
@@ -599,26 +619,26 @@ void FIBProcessor::FIG0Extension14 (uint8_t *d)
 
 void FIBProcessor::FIG0Extension17(uint8_t *d)
 {
-    int16_t length  = getBits_5 (d, 3);
+    int16_t length  = getPackedBits(d, 3, 5);
     int16_t offset  = 16;
     Service *s;
 
     while (offset < length * 8) {
-        uint16_t    SId = getBits (d, offset, 16);
-        bool    L_flag  = getBits_1 (d, offset + 18);
-        bool    CC_flag = getBits_1 (d, offset + 19);
+        uint16_t    SId = getPackedBits(d, offset, 16);
+        bool    L_flag  = getPackedBits(d, offset + 18, 1);
+        bool    CC_flag = getPackedBits(d, offset + 19, 1);
         int16_t type;
         int16_t Language = 0x00;    // init with unknown language
         s = findServiceId(SId);
         if (L_flag) {       // language field present
-            Language = getBits_8 (d, offset + 24);
+            Language = getPackedBits(d, offset + 24, 8);
             if (s) {
                 s->language = Language;
             }
             offset += 8;
         }
 
-        type = getBits_5 (d, offset + 27);
+        type = getPackedBits(d, offset + 27, 5);
         if (s) {
             s->programType = type;
         }
@@ -635,12 +655,12 @@ void FIBProcessor::FIG0Extension18(uint8_t *d)
 {
     int16_t  offset  = 16;       // bits
     uint16_t SId, AsuFlags;
-    int16_t  Length  = getBits_5 (d, 3);
+    int16_t  Length  = getPackedBits(d, 3, 5);
 
     while (offset / 8 < Length - 1 ) {
-        int16_t NumClusters = getBits_5 (d, offset + 35);
-        SId = getBits (d, offset, 16);
-        AsuFlags = getBits (d, offset + 16, 16);
+        int16_t NumClusters = getPackedBits(d, offset + 35, 5);
+        SId = getPackedBits(d, offset, 16);
+        AsuFlags = getPackedBits(d, offset + 16, 16);
         //     std::clog << "fib-processor:" << "Announcement %d for SId %d with %d clusters\n",
         //                      AsuFlags, SId, NumClusters) << std::endl;
         offset += 40 + NumClusters * 8;
@@ -652,23 +672,23 @@ void FIBProcessor::FIG0Extension18(uint8_t *d)
 void FIBProcessor::FIG0Extension19(uint8_t *d)
 {
     int16_t  offset  = 16;       // bits
-    int16_t  Length  = getBits_5 (d, 3);
+    int16_t  Length  = getPackedBits(d, 3, 5);
     uint8_t  region_Id_Lower;
 
     while (offset / 8 < Length - 1) {
-        uint8_t clusterId   = getBits_8 (d, offset);
-        bool    new_flag    = getBits_1(d, offset + 24);
-        bool    region_flag = getBits_1 (d, offset + 25);
-        uint8_t subChId     = getBits_6 (d, offset + 26);
+        uint8_t clusterId   = getPackedBits(d, offset, 8);
+        bool    new_flag    = getPackedBits(d, offset + 24, 1);
+        bool    region_flag = getPackedBits(d, offset + 25, 1);
+        uint8_t subChId     = getPackedBits(d, offset + 26, 6);
 
-        uint16_t aswFlags = getBits (d, offset + 8, 16);
+        uint16_t aswFlags = getPackedBits(d, offset + 8, 16);
         //     std::clog << "fib-processor:" <<
         //            "%s %s Announcement %d for Cluster %2u on SubCh %2u ",
         //                ((new_flag==1)?"new":"old"),
         //                ((region_flag==1)?"regional":""),
         //                aswFlags, clusterId,subChId) << std::endl;
         if (region_flag) {
-            region_Id_Lower = getBits_6 (d, offset + 34);
+            region_Id_Lower = getPackedBits(d, offset + 34, 6);
             offset += 40;
             //           fprintf(stderr,"for region %u",region_Id_Lower);
         }
@@ -693,7 +713,7 @@ void FIBProcessor::FIG0Extension21(uint8_t *d)
 
 void FIBProcessor::FIG0Extension22(uint8_t *d)
 {
-    int16_t Length  = getBits_5 (d, 3);
+    int16_t Length  = getPackedBits(d, 3, 5);
     int16_t offset  = 16;       // on bits
     int16_t used    = 2;
 
@@ -709,12 +729,12 @@ int16_t FIBProcessor::HandleFIG0Extension22(uint8_t *d, int16_t used)
     int16_t mainId;
     int16_t noSubfields;
 
-    mainId  = getBits_7 (d, used * 8 + 1);
+    mainId  = getPackedBits(d, used * 8 + 1, 7);
     (void)mainId;
-    MS  = getBits_1 (d, used * 8);
+    MS  = getPackedBits(d, used * 8, 1);
     if (MS == 0) {      // fixed size
-        int16_t latitudeCoarse = getBits (d, used * 8 + 8, 16);
-        int16_t longitudeCoarse = getBits (d, used * 8 + 24, 16);
+        int16_t latitudeCoarse = getPackedBits(d, used * 8 + 8, 16);
+        int16_t longitudeCoarse = getPackedBits(d, used * 8 + 24, 16);
         //     std::clog << "fib-processor:" << "Id = %d, (%d %d)\n", mainId,
         //                                latitudeCoarse, longitudeCoarse) << std::endl;
         (void)latitudeCoarse;
@@ -723,7 +743,7 @@ int16_t FIBProcessor::HandleFIG0Extension22(uint8_t *d, int16_t used)
     }
     //  MS == 1
 
-    noSubfields = getBits_3 (d, used * 8 + 13);
+    noSubfields = getPackedBits(d, used * 8 + 13, 3);
     //  std::clog << "fib-processor:" << "Id = %d, subfields = %d\n", mainId, noSubfields) << std::endl;
     used += (16 + noSubfields * 48) / 8;
 
@@ -748,9 +768,9 @@ void    FIBProcessor::process_FIG1 (uint8_t *d)
     char        label [17];
     //
     //  from byte 1 we deduce:
-    charSet     = getBits_4 (d, 8);
-    oe      = getBits_1 (d, 8 + 4);
-    extension   = getBits_3 (d, 8 + 5);
+    charSet     = getPackedBits(d, 8, 4);
+    oe      = getPackedBits(d, 8 + 4, 1);
+    extension   = getPackedBits(d, 8 + 5, 3);
     label [16]  = 0x00;
     if (oe == 1) {
         return;
@@ -759,22 +779,24 @@ void    FIBProcessor::process_FIG1 (uint8_t *d)
     switch (extension) {
         case 0: // ensemble label
             {
-                uint32_t EId = getBits(d, 16, 16);
+                uint32_t EId = getPackedBits(d, 16, 16);
                 (void)EId;
             }
             offset  = 32;
             if ((charSet <= 16)) { // EBU Latin based repertoire
                 for (i = 0; i < 16; i ++) {
-                    label[i] = getBits_8 (d, offset);
+                    label[i] = getPackedBits(d, offset, 8);
                     offset += 8;
                 }
                 //           std::clog << "fib-processor:" << "Ensemblename: %16s\n", label) << std::endl;
                 if (!oe) {
                     if (firstTime) {
-                        ensembleLabel.flag = getBits(d, offset, 16);
+                        ensembleLabel.flag = getPackedBits(d, offset, 16);
                         ensembleLabel.raw_label = label;
                         ensembleLabel.setCharset(charSet);
+                        changeCount++;
 
+                        milestones.reached(SyncMilestone::EnsembleLabel);
                         myRadioInterface.onNewEnsembleName(
                                 toUtf8StringUsingCharset(
                                     (const char *)label,
@@ -792,19 +814,20 @@ void    FIBProcessor::process_FIG1 (uint8_t *d)
             break;
 
         case 1: // 16 bit Identifier field for service label
-            SId = getBits(d, 16, 16);
+            SId = getPackedBits(d, 16, 16);
             offset  = 32;
             service = findServiceId(SId);
             if (!service) break;
 
             if (service->serviceLabel.raw_label.empty() && charSet <= 16) {
                 for (i = 0; i < 16; i++) {
-                    label[i] = getBits_8(d, offset);
+                    label[i] = getPackedBits(d, offset, 8);
                     offset += 8;
                 }
-                service->serviceLabel.flag = getBits(d, offset, 16);
+                service->serviceLabel.flag = getPackedBits(d, offset, 16);
                 service->serviceLabel.raw_label = label;
                 service->serviceLabel.setCharset(charSet);
+                changeCount++;
 
                 // std::clog << "fib-processor:" << "FIG1/1: SId = %4x\t%s\n", SId, label) << std::endl;
                 myRadioInterface.onServiceDetected(SId,
@@ -815,35 +838,38 @@ void    FIBProcessor::process_FIG1 (uint8_t *d)
 
         case 3:
             // region label
-            //        region_id = getBits_6 (d, 16 + 2);
+            //        region_id = getPackedBits(d, 16 + 2, 6);
             offset = 24;
             for (i = 0; i < 16; i ++) {
-                label[i] = getBits_8 (d, offset + 8 * i);
+                label[i] = getPackedBits(d, offset + 8 * i, 8);
             }
 
             //        std::clog << "fib-processor:" << "FIG1/3: RegionID = %2x\t%s\n", region_id, label) << std::endl;
             break;
 
         case 4:
-            pd_flag = getBits(d, 16, 1);
-            SCidS   = getBits(d, 20, 4);
+            pd_flag = getPackedBits(d, 16, 1);
+            SCidS   = getPackedBits(d, 20, 4);
             if (pd_flag) {  // 32 bit identifier field for service component label
-                SId = getBits(d, 24, 32);
+                SId = getPackedBits(d, 24, 32);
                 offset  = 56;
             }
             else {  // 16 bit identifier field for service component label
-                SId = getBits(d, 24, 16);
+                SId = getPackedBits(d, 24, 16);
                 offset  = 40;
             }
 
             for (i = 0; i < 16; i ++) {
-                label[i] = getBits_8 (d, offset);
+                label[i] = getPackedBits(d, offset, 8);
                 offset += 8;
             }
 
             component = findComponent(SId, SCidS);
             if (component) {
-                component->componentLabel.flag = getBits(d, offset, 16);
+                if (component->componentLabel.raw_label != label) {
+                    changeCount++;
+                }
+                component->componentLabel.flag = getPackedBits(d, offset, 16);
                 component->componentLabel.setCharset(charSet);
                 component->componentLabel.raw_label = label;
             }
@@ -853,19 +879,20 @@ void    FIBProcessor::process_FIG1 (uint8_t *d)
 
 
         case 5: // 32 bit Identifier field for service label
-            SId = getBits(d, 16, 32);
+            SId = getPackedBits(d, 16, 32);
             offset  = 48;
             service = findServiceId(SId);
             if (!service) break;
 
             if (service->serviceLabel.raw_label.empty() && charSet <= 16) {
                 for (i = 0; i < 16; i ++) {
-                    label[i] = getBits_8(d, offset);
+                    label[i] = getPackedBits(d, offset, 8);
                     offset += 8;
                 }
-                service->serviceLabel.flag = getBits(d, offset, 16);
+                service->serviceLabel.flag = getPackedBits(d, offset, 16);
                 service->serviceLabel.raw_label = label;
                 service->serviceLabel.setCharset(charSet);
+                changeCount++;
 
 #ifdef  MSC_DATA__
                 string l = toUtf8StringUsingCharset(
@@ -877,21 +904,21 @@ void    FIBProcessor::process_FIG1 (uint8_t *d)
             break;
 
         case 6: // XPAD label
-            pd_flag = getBits(d, 16, 1);
-            SCidS   = getBits(d, 20, 4);
+            pd_flag = getPackedBits(d, 16, 1);
+            SCidS   = getPackedBits(d, 20, 4);
             if (pd_flag) {  // 32 bits identifier for XPAD label
-                SId       = getBits(d, 24, 32);
-                XPAD_aid  = getBits(d, 59, 5);
+                SId       = getPackedBits(d, 24, 32);
+                XPAD_aid  = getPackedBits(d, 59, 5);
                 offset    = 64;
             }
             else {  // 16 bit identifier for XPAD label
-                SId       = getBits(d, 24, 16);
-                XPAD_aid  = getBits(d, 43, 5);
+                SId       = getPackedBits(d, 24, 16);
+                XPAD_aid  = getPackedBits(d, 43, 5);
                 offset    = 48;
             }
 
             for (i = 0; i < 16; i ++) {
-                label[i] = getBits_8 (d, offset + 8 * i);
+                label[i] = getPackedBits(d, offset + 8 * i, 8);
             }
 
             //        std::clog << "fib-processor:" << "FIG1/6: SId = %8x\tp/d = %d\t SCidS = %1X\tXPAD_aid = %2u\t%s\n",
@@ -971,6 +998,7 @@ void FIBProcessor::bindAudioService(
         newcomp.PS_flag      = ps_flag;
         newcomp.ASCTy        = ASCTy;
         components.push_back(newcomp);
+        changeCount++;
 
         //  std::clog << "fib-processor:" << "service %8x (comp %d) is audio\n", SId, compnr) << std::endl;
     }
@@ -999,6 +1027,7 @@ void FIBProcessor::bindDataStreamService(
         newcomp.PS_flag      = ps_flag;
         newcomp.DSCTy        = DSCTy;
         components.push_back(newcomp);
+        changeCount++;
 
         //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
     }
@@ -1030,6 +1059,7 @@ void FIBProcessor::bindPacketService(
         newcomp.PS_flag     = ps_flag;
         newcomp.CAflag      = CAflag;
         components.push_back(newcomp);
+        changeCount++;
 
         //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
     }
@@ -1075,6 +1105,7 @@ void FIBProcessor::dropService(uint32_t SId)
     }
 
     std::clog << ss.str() << std::endl;
+    changeCount++;
 }
 
 void FIBProcessor::clearEnsemble()
@@ -1087,6 +1118,7 @@ void FIBProcessor::clearEnsemble()
     timeLastServiceDecrement = std::chrono::steady_clock::now();
 
     firstTime   = true;
+    changeCount++;
 }
 
 std::vector<Service> FIBProcessor::getServiceList() const
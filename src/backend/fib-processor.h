@@ -30,20 +30,28 @@
 #include <unordered_map>
 #include <chrono>
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <cstdint>
 #include <cstdio>
 #include "msc-handler.h"
 #include "radio-controller.h"
+#include "sync-milestones.h"
 
 class FIBProcessor {
     public:
-        FIBProcessor(RadioControllerInterface& mr);
+        FIBProcessor(RadioControllerInterface& mr,
+                SyncMilestoneTracker& milestones);
 
-        // called from the demodulator
+        // called from the demodulator, p points to the 32 packed bytes
+        // of a FIB
         void processFIB(uint8_t *p, uint16_t fib);
         void clearEnsemble();
 
+        // Incremented every time the ensemble organisation or a label
+        // changes, and when FIG0/0 announces a reconfiguration
+        uint32_t getChangeCount() const { return changeCount; }
+
         // Called from the frontend
         uint16_t getEnsembleId() const;
         uint8_t getEnsembleEcc() const;
@@ -54,6 +62,7 @@ class FIBProcessor {
 
     private:
         RadioControllerInterface& myRadioInterface;
+        SyncMilestoneTracker& milestones;
         Service *findServiceId(uint32_t serviceId);
         ServiceComponent *findComponent(uint32_t serviceId, int16_t SCIdS);
         ServiceComponent *findPacketComponent(int16_t SCId);
@@ -129,6 +138,7 @@ class FIBProcessor {
         std::unordered_map<uint32_t, uint8_t> serviceRepeatCount;
         std::chrono::steady_clock::time_point timeLastServiceDecrement;
         bool firstTime = true;
+        std::atomic<uint32_t> changeCount = ATOMIC_VAR_INIT(0);
 };
 
 #endif
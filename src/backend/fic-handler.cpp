@@ -23,9 +23,11 @@
  *
  */
 
+#include <algorithm>
 #include "fic-handler.h"
 #include "msc-handler.h"
 #include "protTables.h"
+#include "tools.h"
 
 //  The 3072 bits of the serial motherword shall be split into
 //  24 blocks of 128 bits each.
@@ -36,6 +38,16 @@
 //  The last 24 bits shall be subjected to puncturing
 //  according to the table X
 
+//  Number of frames, about 10 seconds in mode I, without any change of
+//  the ensemble and without CRC error before the decoding is reduced
+#define FIC_STABLE_FRAMES   100
+//  The services that were not seen for a few seconds are dropped by the
+//  FIB processor, the decimation is therefore limited
+#define FIC_MAX_DECIMATION  10
+//  The 768 decoded bits hold three FIB's of 32 bytes
+#define FIB_SIZE            32
+#define FIBS_PER_BLOCK      3
+
 uint8_t PI_X [24] = {
     1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0,
     1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0
@@ -49,25 +61,31 @@ uint8_t PI_X [24] = {
   *     puncturing.
   *     The data is sent through to the fic processor
   */
-FicHandler::FicHandler(RadioControllerInterface& mr) :
+FicHandler::FicHandler(RadioControllerInterface& mr,
+        SyncMilestoneTracker& milestones,
+        int decimation) :
     Viterbi(768),
-    fibProcessor(mr),
+    fibProcessor(mr, milestones),
     myRadioInterface(mr),
-    bitBuffer_out(768),
-    ofdm_input(2304)
+    milestones(milestones),
+    // A FIG with a corrupt length read by the FIB processor stays
+    // within the zeros after the last FIB
+    ficBytes(FIBS_PER_BLOCK * FIB_SIZE + FIB_SIZE),
+    ofdm_input(2304),
+    decimation(std::min(std::max(decimation, 1), FIC_MAX_DECIMATION))
 {
-    PI_15 = getPCodes(15 - 1);
-    PI_16 = getPCodes(16 - 1);
-    memset(shiftRegister, 1, 9);
-
-    for (int i = 0; i < 768; i++) {
-        PRBS[i] = shiftRegister[8] ^ shiftRegister[4];
-        for (int j = 8; j > 0; j--) {
-            shiftRegister[j] = shiftRegister[j - 1];
-        }
-
-        shiftRegister[0] = PRBS[i];
-    }
+    /**
+     * a block of 2304 bits is considered to be a codeword
+     * In the first step we have 21 blocks with puncturing according to PI_16
+     * In the second step we have 3 blocks with puncturing according to PI_15
+     * each 128 bit block contains 4 subblocks of 32 bits
+     * on which the given puncturing is applied
+     * we have a final block of 24 bits  with puncturing according to PI_X
+     * This block constitues the 6 * 4 bits of the register itself.
+     */
+    schedule.addBlocks(21, getPCodes(16 - 1));
+    schedule.addBlocks(3, getPCodes(15 - 1));
+    schedule.addTail(PI_X);
 }
 
 /**
@@ -91,6 +109,7 @@ void FicHandler::setBitsperBlock(int16_t b)
     }
     index = 0;
     ficno = 0;
+    leaveReducedMode();
 }
 
 /**
@@ -114,9 +133,21 @@ void FicHandler::processFicBlock(int16_t *data, int16_t blkno)
     if (blkno == 1) {
         index = 0;
         ficno = 0;
+        skipFrame = skipNextFrame();
     }
 
     if ((1 <= blkno) && (blkno <= 3)) {
+        if (skipFrame) {
+            //  Only keep track of the position in the frame
+            index += bitsperBlock;
+            while (index >= 2304) {
+                index -= 2304;
+                ficno++;
+                skippedBlocks++;
+            }
+            return;
+        }
+
         for (i = 0; i < bitsperBlock; i ++) {
             ofdm_input[index ++] = data[i];
             if (index >= 2304) {
@@ -134,93 +165,93 @@ void FicHandler::processFicBlock(int16_t *data, int16_t blkno)
 }
 
 /**
- * \brief processFicInput
- * we have a vector of 2304 (0 .. 2303) soft bits that has
- * to be de-punctured and de-conv-ed into a block of 768 bits
- * In this approach we first create the full 3072 block (i.e.
- * we first depuncture, and then we apply the deconvolution
- * In the next coding step, we will combine this function with the
- * one above
+ * \brief skipNextFrame
+ * The FIC repeats the same information over and over. Once the
+ * ensemble did not change for FIC_STABLE_FRAMES frames, decoding one
+ * frame in decimation is enough to keep the ensemble up to date.
+ * The FIG types are only known after the Viterbi decoder, so that
+ * whole frames are skipped. The interval between decoded frames is
+ * random with a mean of decimation frames, so that it does not stay
+ * in step with the repetition cycle of the FIGs.
+ * A change of the ensemble or a CRC error brings back the decoding
+ * of every frame.
  */
-void FicHandler::processFicInput(int16_t *ficblock, int16_t ficno)
+bool FicHandler::skipNextFrame()
 {
-    int16_t input_counter = 0;
-    int16_t i, k;
-    int32_t local         = 0;
-    int16_t viterbiBlock [3072 + 24];
-
-    /**
-     * a block of 2304 bits is considered to be a codeword
-     * In the first step we have 21 blocks with puncturing according to PI_16
-     * each 128 bit block contains 4 subblocks of 32 bits
-     * on which the given puncturing is applied
-     */
-    memset (viterbiBlock, 0, (3072 + 24) * sizeof (int16_t));
-
-    for (i = 0; i < 21; i ++) {
-        for (k = 0; k < 32 * 4; k ++) {
-            if (PI_16 [k % 32] != 0) {
-                viterbiBlock[local] = ficblock[input_counter ++];
-            }
-            local ++;
-        }
+    const uint32_t changeCount = fibProcessor.getChangeCount();
+    if (changeCount != lastChangeCount) {
+        lastChangeCount = changeCount;
+        leaveReducedMode();
+        return false;
     }
 
-    /**
-     * In the second step
-     * we have 3 blocks with puncturing according to PI_15
-     * each 128 bit block contains 4 subblocks of 32 bits
-     * on which the given puncturing is applied
-     */
-    for (i = 0; i < 3; i ++) {
-        for (k = 0; k < 32 * 4; k ++) {
-            if (PI_15 [k % 32] != 0) {
-                viterbiBlock[local] = ficblock[input_counter ++];
-            }
-            local++;
+    if (not reduced) {
+        if (decimation > 1 and ++stableFrames >= FIC_STABLE_FRAMES) {
+            reduced = true;
+            framesUntilDecode = 0;
         }
+        return false;
     }
 
-    /**
-     * we have a final block of 24 bits  with puncturing according to PI_X
-     * This block constitues the 6 * 4 bits of the register itself.
-     */
-    for (k = 0; k < 24; k ++) {
-        if (PI_X [k] != 0) {
-            viterbiBlock[local] = ficblock[input_counter++];
-        }
-        local ++;
+    if (framesUntilDecode > 0) {
+        framesUntilDecode--;
+        return true;
     }
 
+    //  Next decoded frame in 1 to 2 * decimation - 1 frames
+    rng = rng * 1103515245 + 12345;
+    framesUntilDecode = (rng >> 16) % (2 * decimation - 1);
+    return false;
+}
+
+void FicHandler::leaveReducedMode()
+{
+    stableFrames = 0;
+    framesUntilDecode = 0;
+    reduced = false;
+}
+
+/**
+ * \brief processFicInput
+ * we have a vector of 2304 (0 .. 2303) soft bits that has
+ * to be de-punctured and de-conv-ed into a block of 768 bits
+ * The punctured bits are inserted by the Viterbi decoder while it
+ * reads the block, according to the schedule built in the constructor
+ */
+void FicHandler::processFicInput(int16_t *ficblock, int16_t ficno)
+{
+    int16_t i;
+
     /**
-     * Now we have the full word ready for deconvolution
      * deconvolution is according to DAB standard section 11.2
      */
-    deconvolve (viterbiBlock, bitBuffer_out.data());
+    deconvolve (ficblock, schedule, ficBytes.data());
+    decodedBlocks++;
 
     /**
-     * if everything worked as planned, we now have a
-     * 768 bit vector containing three FIB's
+     * if everything worked as planned, we now have
+     * 96 packed bytes containing three FIB's
      *
      * first step: energy dispersal according to the DAB standard
-     * We use a predefined vector PRBS
      */
-    for (i = 0; i < 768; i ++) {
-        bitBuffer_out[i] ^= PRBS[i];
-    }
+    energyDispersal.dedisperse(ficBytes.data(), FIBS_PER_BLOCK * FIB_SIZE);
 
     /**
      * each of the fib blocks is protected by a crc
      * (we know that there are three fib blocks each time we are here
      * we keep track of the successrate
+     * The CRC and the FIB processor work on the packed bytes.
      */
-    for (i = ficno * 3; i < ficno * 3 + 3; i ++) {
-        uint8_t *p = &bitBuffer_out[(i % 3) * 256];
-        crcvalid = check_CRC_bits(p, 256);
-        myRadioInterface.onFIBDecodeSuccess(crcvalid, p);
+    for (i = 0; i < FIBS_PER_BLOCK; i ++) {
+        uint8_t *p = &ficBytes[i * FIB_SIZE];
+        const uint16_t crc = (p[FIB_SIZE - 2] << 8) | p[FIB_SIZE - 1];
+        crcvalid = CalcCRC::CalcCRC_CRC16_CCITT.Calc(p, FIB_SIZE - 2) == crc;
+        myRadioInterface.onFIBDecoded(crcvalid, p);
         if (!crcvalid) {
+            leaveReducedMode();
             continue;
         }
+        milestones.reached(SyncMilestone::FibCrcValid);
         fibProcessor.processFIB(p, ficno);
     }
 }
@@ -240,3 +271,12 @@ bool FicHandler::getIsCrcValid()
     return crcvalid;
 }
 
+fic_decode_stats_t FicHandler::getDecodeStats() const
+{
+    fic_decode_stats_t stats;
+    stats.decoded_blocks = decodedBlocks;
+    stats.skipped_blocks = skippedBlocks;
+    stats.reduced = reduced;
+    return stats;
+}
+
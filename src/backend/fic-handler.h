@@ -28,39 +28,70 @@
 #ifndef __FIC_HANDLER
 #define __FIC_HANDLER
 
+#include <atomic>
 #include <mutex>
 #include <cstdio>
 #include <cstdint>
 #include "viterbi.h"
+#include "energy_dispersal.h"
 #include "fib-processor.h"
 #include "radio-controller.h"
+#include "sync-milestones.h"
+
+/* Number of FIC blocks decoded and skipped since the receiver was
+ * created. */
+struct fic_decode_stats_t {
+    uint64_t decoded_blocks = 0;
+    uint64_t skipped_blocks = 0;
+    // True while only a fraction of the frames is decoded
+    bool reduced = false;
+};
 
 class FicHandler: public Viterbi
 {
     public:
-        FicHandler(RadioControllerInterface& mr);
+        // Once the ensemble has not changed for a while, only one frame
+        // in decimation on average is decoded. 1 decodes every frame.
+        FicHandler(RadioControllerInterface& mr,
+                SyncMilestoneTracker& milestones,
+                int decimation = 1);
         void    processFicBlock(int16_t *data, int16_t blkno);
         void    setBitsperBlock(int16_t b);
         void    clearEnsemble();
         bool    getIsCrcValid();
         int16_t getFicRatio();
+        fic_decode_stats_t getDecodeStats(void) const;
 
         FIBProcessor fibProcessor;
 
     private:
         RadioControllerInterface& myRadioInterface;
+        SyncMilestoneTracker& milestones;
         void        processFicInput(int16_t *ficblock, int16_t ficno);
-        const int8_t *PI_15;
-        const int8_t *PI_16;
-        std::vector<uint8_t> bitBuffer_out;
+        bool        skipNextFrame(void);
+        void        leaveReducedMode(void);
+        // Depuncturing of the 2304 bits of a FIC codeword
+        PunctureSchedule schedule;
+        EnergyDispersal energyDispersal;
+        // The 768 decoded bits, packed
+        std::vector<uint8_t> ficBytes;
         std::vector<int16_t> ofdm_input;
         int16_t     index = 0;
         int16_t     bitsperBlock = 2 * 1536;
         int16_t     ficno = 0;
         int16_t     ficRatio = 0;
-        uint8_t     PRBS[768];
-        uint8_t     shiftRegister[9];
         bool        crcvalid = false;
+
+        // Reduced decoding, decided at the first block of every frame
+        int         decimation;
+        int         stableFrames = 0;
+        int         framesUntilDecode = 0;
+        uint32_t    lastChangeCount = 0;
+        uint32_t    rng = 1;
+        bool        skipFrame = false;
+        std::atomic<bool> reduced = ATOMIC_VAR_INIT(false);
+        std::atomic<uint64_t> decodedBlocks = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> skippedBlocks = ATOMIC_VAR_INIT(0);
 };
 
 #endif
@@ -22,10 +22,15 @@
  *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 #include <algorithm>
+#include <functional>
+#include <chrono>
+#include <iostream>
+#include <ctime>
 #include "dab-constants.h"
 #include "msc-handler.h"
 #include "dab-virtual.h"
 #include "dab-audio.h"
+#include "uep-protection.h"
 
 //  Interface program for processing the MSC.
 //  Merely a dispatcher for the selected service
@@ -34,13 +39,59 @@
 //  a service is selected or not.
 
 #define CUSize  (4 * 16)
+//  Number of CUs in a CIF
+#define CIF_CUS         864
+//  Logical frames of a subchannel waiting to be decoded, about 400 ms
+#define FRAME_SLOTS     16
+//  Decoders of removed subchannels kept for the next ones
+#define IDLE_DECODERS   8
+
+//  CPU time used by the calling thread, in seconds. Falls back to the
+//  elapsed time where there is no per-thread clock.
+static double threadCpuTime()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+#endif
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//  Whether the decoders of a subchannel can decode the other one
+static bool sameDecoding(const Subchannel& a, const Subchannel& b)
+{
+    const auto& pa = a.protectionSettings;
+    const auto& pb = b.protectionSettings;
+    if (a.length != b.length or a.bitrate() != b.bitrate() or
+            pa.shortForm != pb.shortForm) {
+        return false;
+    }
+
+    if (pa.shortForm) {
+        return pa.uepTableIndex == pb.uepTableIndex and
+            pa.uepLevel == pb.uepLevel;
+    }
+    return pa.eepProfile == pb.eepProfile and pa.eepLevel == pb.eepLevel;
+}
+
 //  Note CIF counts from 0 .. 3
 MscHandler::MscHandler(
         const DABParams& p,
-        bool show_crcErrors) :
+        bool show_crcErrors,
+        SyncMilestoneTracker& milestones,
+        const RadioReceiverOptions& rro) :
+    milestones(milestones),
+    batchWaitBlocks(std::max(rro.viterbiBatchWaitBlocks, 0)),
     bitsperBlock(2 * p.K),
     show_crcErrors(show_crcErrors),
-    cifVector(864 * CUSize)
+    softOutputBudget(rro.viterbiSoftOutputBudget),
+    overflowPolicy(rro.frameOverflowPolicy),
+    overflowTimeout(std::max(rro.frameOverflowTimeoutMs, 0)),
+    deinterleaver(CIF_CUS * CUSize),
+    pool(std::max(rro.decoderThreads, 0))
 {
     if (p.dabMode == 4) {  // 2 CIFS per 76 blocks
         numberofblocksperCIF = 36;
@@ -56,6 +107,14 @@ MscHandler::MscHandler(
                 numberofblocksperCIF = 18;
         }
     }
+
+    // Done once per process, the schedules are shared
+    UEPProtection::buildAllSchedules();
+}
+
+MscHandler::~MscHandler()
+{
+    stopProcessing();
 }
 
 bool MscHandler::addSubchannel(
@@ -68,20 +127,39 @@ bool MscHandler::addSubchannel(
 
     // check not already in list
     for (const auto& stream : streams) {
-        if (stream.subCh.subChId == sub.subChId) {
+        if (stream->subCh.subChId == sub.subChId) {
             return true;
         }
     }
 
-    SelectedStream s(handler, ascty, dumpFileName, sub);
+    auto s = std::make_shared<SelectedStream>(
+            handler, ascty, dumpFileName, sub);
 
-    s.dabHandler = std::make_shared<DabAudio>(
+    //  The MSC waits meanwhile
+    const auto t0 = std::chrono::steady_clock::now();
+    auto decoder = dumpFileName.empty() ?
+        takeIdleDecoder(ascty, sub) : nullptr;
+    if (decoder) {
+        decoder->reuse(handler);
+        switchStats.num_reused++;
+        switchStats.reuse_time_s += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - t0).count();
+    }
+    else {
+        decoder = std::make_shared<DabAudio>(
                 ascty,
                 sub.length * CUSize,
                 sub.bitrate(),
                 sub.protectionSettings,
                 handler,
-                dumpFileName);
+                dumpFileName,
+                milestones,
+                softOutputBudget);
+        switchStats.num_created++;
+        switchStats.create_time_s += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - t0).count();
+    }
+    s->dabHandler = decoder;
 
      /* TODO dealing with data
       s.dabHandler = std::make_shared<DabData>(radioInterface,
@@ -96,23 +174,37 @@ bool MscHandler::addSubchannel(
                                   show_crcErrors);
       */
 
-    streams.push_back(std::move(s));
+    const int32_t endBit = (sub.startAddr + sub.length) * CUSize;
+    s->lastBlock = (endBit - 1) / bitsperBlock;
+
+    for (int i = 0; i < FRAME_SLOTS; i++) {
+        auto slot = std::make_unique<FrameSlot>();
+        slot->input.resize(sub.length * CUSize);
+        slot->output.resize(sub.bitrate() * 24 / 8);
+        s->freeSlots.push_back(slot.get());
+        s->slots.push_back(std::move(slot));
+    }
+    s->overflow.queue_capacity = FRAME_SLOTS;
 
-    work_to_be_done = true;
+    streams.push_back(std::move(s));
     return true;
 }
 
 bool MscHandler::removeSubchannel(const Subchannel& sub)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_lock<std::mutex> lock(mutex);
 
     auto it = std::find_if(streams.begin(), streams.end(),
-            [&](const SelectedStream& stream) {
-                return stream.subCh.subChId == sub.subChId;
+            [&](const StreamPtr& stream) {
+                return stream->subCh.subChId == sub.subChId;
             } );
 
     if (it != streams.end()) {
+        StreamPtr stream = *it;
         streams.erase(it);
+        lock.unlock();
+        waitRemoved(stream);
+        keepIdleDecoder(stream);
         return true;
     }
 
@@ -126,18 +218,40 @@ bool MscHandler::removeSubchannel(const Subchannel& sub)
 //
 //  Any change in the selected service will only be active
 //  during te next processMscBlock call.
-void MscHandler::processMscBlock(int16_t *fbits, int16_t blkno)
+//  The blocks are kept even if no service is selected, so that the
+//  frames of a service are complete as soon as it is selected.
+//
+//  The de-interleaver is only used by this thread. The mutex only
+//  guards the list of subchannels.
+void MscHandler::processMscBlock(int16_t *fbits, int16_t blkno,
+        uint32_t blockGeneration)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    //  The frequency changed, the CIFs received before are useless.
+    //  The symbols come in order, so that no older one follows.
+    if (blockGeneration != generation) {
+        generation = blockGeneration;
+        deinterleaver.reset();
+        cifStarted = false;
 
-    if (!work_to_be_done)
-        return;
+        std::lock_guard<std::mutex> batchLock(batchMutex);
+        flushBatch(0, true, {});
+    }
 
     int16_t currentblk = (blkno - 4) % numberofblocksperCIF;
 
     //  and the normal operation is:
-    memcpy(&cifVector[currentblk * bitsperBlock],
+    memcpy(&deinterleaver.currentCif()[currentblk * bitsperBlock],
             fbits, bitsperBlock * sizeof (int16_t));
+    if (currentblk == 0) {
+        cifStarted = true;
+        waitDeadlineSet = false;
+    }
+
+    //  The subchannels that end in this block have their logical frame
+    //  complete, they do not wait for the rest of the CIF
+    if (cifStarted and deinterleaver.isFilled()) {
+        processFrames(currentblk);
+    }
 
     if (currentblk < numberofblocksperCIF - 1)
         return;
@@ -146,22 +260,418 @@ void MscHandler::processMscBlock(int16_t *fbits, int16_t blkno)
     blkCount = 0;
     cifCount = (cifCount + 1) & 03;
 
-    for (auto& stream : streams) {
-        int16_t *myBegin = &cifVector[stream.subCh.startAddr * CUSize];
+    //  The CIF was reset while it was received, its buffer is used
+    //  again for the next one
+    if (not cifStarted)
+        return;
+
+    deinterleaver.push();
+}
 
-        if (stream.dabHandler) {
-            (void)stream.dabHandler->process(myBegin, stream.subCh.length * CUSize);
+//  Hand the logical frames of the subchannels ending in the given block
+//  of the current CIF over to the pool. The mutex is only held to find
+//  the subchannels, not while waiting for one of them or calling its
+//  handler.
+void MscHandler::processFrames(int16_t block)
+{
+    std::vector<StreamPtr> ending;
+    std::vector<LaterFrame> laterFrames;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (const auto& stream : streams) {
+        if (stream->lastBlock == block) {
+            ending.push_back(stream);
+        }
+        else if (stream->lastBlock > block) {
+            LaterFrame later;
+            later.lastBlock = stream->lastBlock;
+            later.bits = stream->subCh.bitrate() * 24;
+            laterFrames.push_back(later);
+        }
+    }
+    lock.unlock();
+    const auto now = std::chrono::steady_clock::now();
+
+    for (const auto& stream : ending) {
+        std::unique_lock<std::mutex> streamLock(stream->mutex);
+        const frame_overflow_stats_t before = stream->overflow;
+        //  A stream removed meanwhile gets no more frames
+        FrameSlot *slot = stream->removed ? nullptr :
+            takeFreeSlot(*stream, streamLock);
+        BatchFrame f;
+        bool batched = false;
+        if (slot) {
+            deinterleaver.deinterleave(stream->subCh.startAddr * CUSize,
+                    slot->input.size(), slot->input.data());
+            slot->decoded = false;
+            slot->complete = now;
+            stream->queue.push_back(slot);
+
+            batched = stream->dabHandler->getViterbiFrame(
+                    slot->input.data(), slot->output.data(), f.frame);
+            if (batched) {
+                slot->state = FrameSlot::State::Viterbi;
+                f.bits = slot->output.size() * 8;
+                f.block = block;
+                f.stream = stream;
+                f.slot = slot;
+            }
+            else {
+                slot->state = FrameSlot::State::Ready;
+                scheduleStream(stream);
+                viterbiBatch.countAlone(1);
+            }
+        }
+        const frame_overflow_stats_t after = stream->overflow;
+        streamLock.unlock();
+
+        if (batched) {
+            //  waitRemoved() only releases the frames already waiting
+            std::lock_guard<std::mutex> batchLock(batchMutex);
+            streamLock.lock();
+            const bool removed = stream->removed;
+            streamLock.unlock();
+            if (removed) {
+                releaseAlone(f);
+            }
+            else {
+                pendingBatch.push_back(std::move(f));
+            }
+        }
+
+        if (after.dropped_frames != before.dropped_frames or
+                after.waits != before.waits) {
+            stream->handler.onFrameOverflow(after);
+        }
+    }
+
+    std::lock_guard<std::mutex> batchLock(batchMutex);
+    flushBatch(block, block == numberofblocksperCIF - 1, laterFrames);
+}
+
+//  Submit the passes the waiting frames fill, and decode the frames that
+//  will not find enough others alone. No frame waits longer than
+//  batchWaitBlocks, or beyond the end of the CIF. Called with the batch
+//  mutex held.
+void MscHandler::flushBatch(int16_t block, bool endOfCif,
+        const std::vector<LaterFrame>& laterFrames)
+{
+    //  The passes take frames of similar lengths
+    std::stable_sort(pendingBatch.begin(), pendingBatch.end(),
+            [](const BatchFrame& a, const BatchFrame& b) {
+                return a.bits > b.bits; });
+
+    const size_t lanes = viterbiBatch.numLanes();
+    auto frameBits = [&](size_t first, size_t n) {
+        std::vector<int32_t> bits;
+        for (size_t i = first; i < first + n; i++) {
+            bits.push_back(pendingBatch[i].bits);
+        }
+        return bits;
+    };
+
+    //  The full passes go at once. A frame too long for the others of
+    //  its pass is decoded alone.
+    while (pendingBatch.size() >= lanes) {
+        const auto bits = frameBits(0, lanes);
+        if (viterbiBatch.worthBatching(bits.data(), bits.size())) {
+            std::vector<BatchFrame> pass(pendingBatch.begin(),
+                    pendingBatch.begin() + lanes);
+            pendingBatch.erase(pendingBatch.begin(),
+                    pendingBatch.begin() + lanes);
+            submitPass(std::move(pass));
         }
         else {
-            throw std::logic_error("No dabHandler!");
+            releaseAlone(pendingBatch.front());
+            pendingBatch.erase(pendingBatch.begin());
+        }
+    }
+
+    if (pendingBatch.empty()) {
+        return;
+    }
+
+    //  Wait while the frames to come before the oldest one has waited
+    //  long enough can complete a pass with them
+    int16_t oldest = block;
+    for (const auto& f : pendingBatch) {
+        oldest = std::min(oldest, f.block);
+    }
+    const int until = oldest + batchWaitBlocks;
+    if (not endOfCif and block < until) {
+        auto candidates = frameBits(0, pendingBatch.size());
+        for (const auto& later : laterFrames) {
+            if (later.lastBlock <= until) {
+                candidates.push_back(later.bits);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                std::greater<int32_t>());
+        candidates.resize(std::min(candidates.size(), lanes));
+        if (viterbiBatch.worthBatching(candidates.data(),
+                    candidates.size())) {
+            return;
         }
     }
+
+    const auto bits = frameBits(0, pendingBatch.size());
+    if (viterbiBatch.worthBatching(bits.data(), bits.size())) {
+        submitPass(std::move(pendingBatch));
+    }
+    else {
+        for (const auto& f : pendingBatch) {
+            releaseAlone(f);
+        }
+    }
+    pendingBatch.clear();
+}
+
+//  Decode the frames together in a task of the pool
+void MscHandler::submitPass(std::vector<BatchFrame>&& pass)
+{
+    std::vector<ViterbiFrame> frames;
+    for (const auto& f : pass) {
+        frames.push_back(f.frame);
+    }
+
+    pool.submit([this, pass, frames]() {
+            const double t0 = threadCpuTime();
+            viterbiBatch.decodeFrames(frames.data(), frames.size());
+            const double share = (threadCpuTime() - t0) / pass.size();
+            for (const auto& f : pass) {
+                std::lock_guard<std::mutex> lock(f.stream->mutex);
+                f.stream->cpuTime += share;
+                f.slot->decoded = true;
+                f.slot->state = FrameSlot::State::Ready;
+                scheduleStream(f.stream);
+            }
+        });
+}
+
+//  The stream decodes the frame with its own Viterbi decoder
+void MscHandler::releaseAlone(const BatchFrame& f)
+{
+    std::lock_guard<std::mutex> lock(f.stream->mutex);
+    f.slot->state = FrameSlot::State::Ready;
+    scheduleStream(f.stream);
+    viterbiBatch.countAlone(1);
+}
+
+//  A slot for the next frame of the stream. When all are in use, the
+//  overflow policy decides whether the oldest frame waiting is dropped,
+//  or whether to wait for the decoder. Returns nullptr if the new frame
+//  must be dropped, or the stream was removed. Called with the mutex of
+//  the stream held.
+MscHandler::FrameSlot *MscHandler::takeFreeSlot(SelectedStream& stream,
+        std::unique_lock<std::mutex>& lock)
+{
+    if (stream.freeSlots.empty()) {
+        switch (overflowPolicy) {
+            case FrameOverflowPolicy::DropNewest:
+                break;
+            case FrameOverflowPolicy::DropOldest:
+                //  The frames being decoded by the batch or by the
+                //  stream cannot be taken away
+                for (auto it = stream.queue.begin();
+                        it != stream.queue.end(); ++it) {
+                    if ((*it)->state == FrameSlot::State::Ready) {
+                        FrameSlot *slot = *it;
+                        stream.queue.erase(it);
+                        stream.overflow.dropped_frames++;
+                        return slot;
+                    }
+                }
+                break;
+            case FrameOverflowPolicy::Block:
+                //  All streams of the CIF share the time to wait, so
+                //  that the symbols do not pile up before the MSC
+                //  thread when several decoders are slow
+                if (not waitDeadlineSet) {
+                    waitDeadline = std::chrono::steady_clock::now() +
+                        overflowTimeout;
+                    waitDeadlineSet = true;
+                }
+                if (std::chrono::steady_clock::now() < waitDeadline) {
+                    stream.overflow.waits++;
+                    stream.frameDone.wait_until(lock, waitDeadline,
+                            [&]() { return not stream.freeSlots.empty() or
+                                    stream.removed; });
+                }
+                break;
+        }
+    }
+
+    if (stream.removed) {
+        return nullptr;
+    }
+
+    if (stream.freeSlots.empty()) {
+        stream.overflow.dropped_frames++;
+        return nullptr;
+    }
+
+    FrameSlot *slot = stream.freeSlots.back();
+    stream.freeSlots.pop_back();
+    return slot;
+}
+
+//  Start a task for the stream if its next frame is ready.
+//  Called with the mutex of the stream held.
+void MscHandler::scheduleStream(const StreamPtr& stream)
+{
+    if (stream->running or stream->queue.empty() or
+            stream->queue.front()->state != FrameSlot::State::Ready) {
+        return;
+    }
+
+    stream->running = true;
+    pool.submit([this, stream]() { decodeStream(stream); });
+}
+
+void MscHandler::decodeStream(const StreamPtr& stream)
+{
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    while (not stream->queue.empty() and
+            stream->queue.front()->state == FrameSlot::State::Ready) {
+        //  Frames behind it can be dropped meanwhile, this one stays at
+        //  the front of the queue
+        FrameSlot *slot = stream->queue.front();
+        slot->state = FrameSlot::State::Decoding;
+
+        const bool removed = stream->removed;
+        lock.unlock();
+        double cpuTime = 0;
+        if (not removed) {
+            const double t0 = threadCpuTime();
+            stream->dabHandler->processFrame(slot->input.data(),
+                    slot->output.data(), slot->decoded);
+            cpuTime = threadCpuTime() - t0;
+        }
+        const double latency = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - slot->complete).count();
+        lock.lock();
+
+        stream->cpuTime += cpuTime;
+        stream->latencySum += latency;
+        stream->maxLatency = std::max(stream->maxLatency, latency);
+        stream->numFrames++;
+        stream->queue.pop_front();
+        stream->freeSlots.push_back(slot);
+        stream->frameDone.notify_all();
+    }
+
+    stream->running = false;
+    stream->frameDone.notify_all();
+}
+
+//  Wait until the frames of a stream that was taken out of the list
+//  went through the pool
+void MscHandler::waitRemoved(const StreamPtr& stream)
+{
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    stream->removed = true;
+    //  The MSC thread may be waiting for a slot
+    stream->frameDone.notify_all();
+    lock.unlock();
+
+    //  Its frames waiting for a batch would wait for the end of the CIF,
+    //  which may never come
+    std::unique_lock<std::mutex> batchLock(batchMutex);
+    for (auto it = pendingBatch.begin(); it != pendingBatch.end(); ) {
+        if (it->stream == stream) {
+            releaseAlone(*it);
+            it = pendingBatch.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    batchLock.unlock();
+
+    lock.lock();
+    while (stream->running or not stream->queue.empty()) {
+        stream->frameDone.wait(lock);
+    }
 }
 
 void MscHandler::stopProcessing()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    std::list<StreamPtr> removed;
+    removed.swap(streams);
+    lock.unlock();
+
+    for (const auto& stream : removed) {
+        waitRemoved(stream);
+        keepIdleDecoder(stream);
+    }
+}
+
+//  The most recently kept decoder for the subchannel, if any.
+//  Called with the mutex held.
+std::shared_ptr<DabAudio> MscHandler::takeIdleDecoder(
+        AudioServiceComponentType ascty, const Subchannel& sub)
+{
+    for (auto it = idleDecoders.begin(); it != idleDecoders.end(); ++it) {
+        if (it->audioType == ascty and sameDecoding(it->subCh, sub)) {
+            auto decoder = std::move(it->decoder);
+            idleDecoders.erase(it);
+            return decoder;
+        }
+    }
+    return nullptr;
+}
+
+//  Keep the decoder of a stream whose frames all went through the pool.
+//  Decoders that wrote a dump file are not kept.
+void MscHandler::keepIdleDecoder(const StreamPtr& stream)
+{
+    auto decoder = std::dynamic_pointer_cast<DabAudio>(stream->dabHandler);
+    if (not decoder or not stream->dumpFileName.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    IdleDecoder idle;
+    idle.audioType = stream->audioType;
+    idle.subCh = stream->subCh;
+    idle.decoder = std::move(decoder);
+    idleDecoders.push_front(std::move(idle));
+    if (idleDecoders.size() > IDLE_DECODERS) {
+        idleDecoders.pop_back();
+    }
+}
+
+std::vector<subchannel_decode_stats_t> MscHandler::getDecodeStats() const
 {
     std::lock_guard<std::mutex> lock(mutex);
-    work_to_be_done = false;
-    streams.clear();
+    std::vector<subchannel_decode_stats_t> stats;
+    for (const auto& stream : streams) {
+        std::lock_guard<std::mutex> streamLock(stream->mutex);
+        subchannel_decode_stats_t s;
+        s.subchannel_id = stream->subCh.subChId;
+        s.num_frames = stream->numFrames;
+        s.overflow = stream->overflow;
+        s.cpu_time_s = stream->cpuTime;
+        s.mean_latency_us = 1e6 * stream->latencySum /
+            std::max<size_t>(stream->numFrames, 1);
+        s.max_latency_us = 1e6 * stream->maxLatency;
+        stats.push_back(s);
+    }
+    return stats;
 }
 
+decoder_pool_stats_t MscHandler::getPoolStats() const
+{
+    return pool.getStats();
+}
+
+ViterbiBatch::Stats MscHandler::getBatchStats() const
+{
+    return viterbiBatch.getStats();
+}
+
+decoder_switch_stats_t MscHandler::getSwitchStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return switchStats;
+}
@@ -30,23 +30,72 @@
 #ifndef MSC_HANDLER
 #define MSC_HANDLER
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <list>
 #include <memory>
 #include <vector>
 #include <cstdio>
 #include <cstdint>
-#include <cstdio>
 #include "dab-constants.h"
-#include "ringbuffer.h"
 #include "radio-controller.h"
+#include "radio-receiver-options.h"
+#include "sync-milestones.h"
+#include "decoder-pool.h"
+#include "time-deinterleaver.h"
+#include "viterbi-batch.h"
 
 class DabVirtual;
+class DabAudio;
+
+struct subchannel_decode_stats_t {
+    int subchannel_id = -1;
+    // Logical frames decoded
+    size_t num_frames = 0;
+    // Frames dropped because the decoder was late, and waits of the MSC
+    frame_overflow_stats_t overflow;
+    // CPU time spent decoding the frames, including the share of the
+    // batch Viterbi passes. A logical frame lasts 24 ms.
+    double cpu_time_s = 0;
+    // Time from the last block of a frame to the end of its decoding
+    double mean_latency_us = 0;
+    double max_latency_us = 0;
+};
 
+struct decoder_switch_stats_t {
+    // Decoders built for a new subchannel, and decoders of a removed
+    // subchannel used again
+    size_t num_created = 0;
+    size_t num_reused = 0;
+    // Time spent getting these decoders ready, while the MSC waits
+    double create_time_s = 0;
+    double reuse_time_s = 0;
+};
+
+/* The subchannels are time de-interleaved together, and their logical
+ * frames are decoded by the threads of a pool. The frame of a subchannel
+ * is handed over as soon as the OFDM symbol holding its last CUs arrives,
+ * without waiting for the end of the CIF. The frames of a subchannel are
+ * decoded one at a time and in order. Frames that can fill enough lanes
+ * of a Viterbi pass together are first decoded together by one task of
+ * the pool. A frame waits for the others of its pass while they can
+ * still end in the same CIF, and is decoded alone otherwise.
+ *
+ * Each subchannel holds up to 16 frames. When its decoder is further
+ * behind, the FrameOverflowPolicy of the options applies.
+ *
+ * The decoders of the last removed subchannels are kept, and used again
+ * for a subchannel with the same audio type, bitrate and protection. A
+ * service switch then does not allocate and initialise them again. */
 class MscHandler
 {
     public:
-        MscHandler(const DABParams& p, bool show_crcErrors);
+        MscHandler(const DABParams& p, bool show_crcErrors,
+                SyncMilestoneTracker& milestones,
+                const RadioReceiverOptions& rro = RadioReceiverOptions());
+        ~MscHandler();
 
         // Stop processing and remove all subchannels
         void stopProcessing(void);
@@ -57,11 +106,34 @@ class MscHandler
                 const std::string& dumpFileName,
                 const Subchannel& sub);
 
+        // When this returns, the handler of the subchannel is not
+        // called any more
         bool removeSubchannel(const Subchannel& sub);
 
+        // One entry per subchannel being decoded
+        std::vector<subchannel_decode_stats_t> getDecodeStats(void) const;
+        decoder_pool_stats_t getPoolStats(void) const;
+        decoder_switch_stats_t getSwitchStats(void) const;
+        ViterbiBatch::Stats getBatchStats(void) const;
+
     private:
         friend class OfdmDecoder;
-        void processMscBlock(int16_t *fbits, int16_t blkno);
+        // The CIFs received so far are forgotten when the generation of
+        // the frequency correction changes
+        void processMscBlock(int16_t *fbits, int16_t blkno,
+                uint32_t generation);
+
+        // A logical frame of a subchannel on its way through the decoder
+        struct FrameSlot {
+            enum class State { Viterbi, Ready, Decoding };
+            State state = State::Ready;
+            // The batch did the Viterbi decoding
+            bool decoded = false;
+            // The last block of the frame was received
+            std::chrono::steady_clock::time_point complete;
+            std::vector<int16_t> input;
+            std::vector<uint8_t> output;
+        };
 
         struct SelectedStream {
             SelectedStream(
@@ -81,19 +153,110 @@ class MscHandler
             const Subchannel subCh;
 
             std::shared_ptr<DabVirtual> dabHandler;
+
+            // Block of the CIF that holds the last bits of the subchannel
+            int lastBlock = 0;
+
+            // The frames are decoded in the order of the queue. The slots
+            // go from the free list to the queue and back, they are not
+            // allocated again.
+            std::mutex mutex;
+            // Notified when a frame was decoded
+            std::condition_variable frameDone;
+            std::vector<std::unique_ptr<FrameSlot> > slots;
+            std::deque<FrameSlot*> queue;
+            std::vector<FrameSlot*> freeSlots;
+            // A task of the pool is decoding the frames
+            bool running = false;
+            bool removed = false;
+
+            size_t numFrames = 0;
+            double cpuTime = 0;
+            double latencySum = 0;
+            double maxLatency = 0;
+            frame_overflow_stats_t overflow;
         };
+        using StreamPtr = std::shared_ptr<SelectedStream>;
 
-        std::mutex mutex;
-        std::list<SelectedStream> streams;
+        // A frame waiting for the Viterbi decoder
+        struct BatchFrame {
+            ViterbiFrame frame;
+            int32_t bits;
+            // Block of the CIF in which the frame was complete
+            int16_t block;
+            StreamPtr stream;
+            FrameSlot *slot;
+        };
+
+        // A frame still to come in the current CIF
+        struct LaterFrame {
+            int16_t lastBlock;
+            int32_t bits;
+        };
+
+        void processFrames(int16_t block);
+        FrameSlot *takeFreeSlot(SelectedStream& stream,
+                std::unique_lock<std::mutex>& lock);
+        void flushBatch(int16_t block, bool endOfCif,
+                const std::vector<LaterFrame>& laterFrames);
+        void submitPass(std::vector<BatchFrame>&& pass);
+        void releaseAlone(const BatchFrame& f);
+        void scheduleStream(const StreamPtr& stream);
+        void decodeStream(const StreamPtr& stream);
+        void waitRemoved(const StreamPtr& stream);
+
+        // The decoder of a removed subchannel, ready for another one
+        struct IdleDecoder {
+            AudioServiceComponentType audioType;
+            Subchannel subCh;
+            std::shared_ptr<DabAudio> decoder;
+        };
+        std::shared_ptr<DabAudio> takeIdleDecoder(
+                AudioServiceComponentType ascty, const Subchannel& sub);
+        void keepIdleDecoder(const StreamPtr& stream);
+
+        SyncMilestoneTracker& milestones;
+
+        // Shared by the subchannels, declared before them
+        ViterbiBatch viterbiBatch;
+
+        // Frames of the current CIF that wait for others of similar
+        // length to fill a batched pass, at most batchWaitBlocks and
+        // until the end of the CIF. Taken before the mutex of a stream.
+        std::mutex batchMutex;
+        std::vector<BatchFrame> pendingBatch;
+        const int batchWaitBlocks;
+
+        // Not held by the MSC thread while it waits for a subchannel,
+        // or calls its handler
+        mutable std::mutex mutex;
+        std::list<StreamPtr> streams;
+        // Most recently removed first
+        std::list<IdleDecoder> idleDecoders;
+        decoder_switch_stats_t switchStats;
 
         const int16_t bitsperBlock;
         int16_t numberofblocksperCIF;
         bool show_crcErrors;
+        float softOutputBudget;
+        FrameOverflowPolicy overflowPolicy;
+        std::chrono::milliseconds overflowTimeout;
+        // Until when the Block policy may wait in the current CIF, set by
+        // the first wait
+        std::chrono::steady_clock::time_point waitDeadline;
+        bool waitDeadlineSet = false;
 
-        std::vector<int16_t> cifVector;
+        TimeDeinterleaver deinterleaver;
         int16_t cifCount = 0; // msc blocks in CIF
         int16_t blkCount = 0;
-        bool work_to_be_done = false;
+        // Generation of the blocks in the de-interleaver
+        uint32_t generation = 0;
+        // All blocks of the CIF being received were written since
+        // the last reset
+        bool cifStarted = false;
+
+        // Declared last, so that its threads are stopped first
+        DecoderPool pool;
 };
 
 #endif
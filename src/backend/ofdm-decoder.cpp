@@ -30,6 +30,23 @@
 #include <cstddef>
 #include "ofdm-decoder.h"
 #include <iostream>
+#include <algorithm>
+#include <functional>
+
+//  Symbols 1 to FIC_SYMBOLS carry the FIC
+#define FIC_SYMBOLS 3
+//  Capacity of the decoder stage queues, in frames
+#define STAGE_QUEUE_FRAMES 2
+
+static int32_t mscBatch(const DABParams& p, int fftBatchSize)
+{
+    //  The batches have to divide the MSC symbols of a frame
+    const int32_t mscSymbols = p.L - 1 - FIC_SYMBOLS;
+    int32_t batch = std::max(1, std::min(fftBatchSize, mscSymbols));
+    while (mscSymbols % batch != 0)
+        batch--;
+    return batch;
+}
 
 /**
  * \brief OfdmDecoder
@@ -42,45 +59,119 @@ OfdmDecoder::OfdmDecoder(
         const DABParams& p,
         RadioControllerInterface& mr,
         FicHandler& ficHandler,
-        MscHandler& mscHandler) :
+        MscHandler& mscHandler,
+        int32_t symbolDistance,
+        int fftBatchSize,
+        int spinCount) :
     params(p),
     radioInterface(mr),
     ficHandler(ficHandler),
     mscHandler(mscHandler),
-    pending_symbols(params.L),
-    phaseReference(params.T_u),
+    symbolQueue(params.L),
+    frameSymbols(params.L),
+    frameGenerations(params.L),
     fft_handler(p.T_u),
     interleaver(p),
-    ibits(2 * params.K)
+    mscBatchSize(mscBatch(p, fftBatchSize)),
+    fic_fft(p.T_u, FIC_SYMBOLS, symbolDistance),
+    msc_fft(p.T_u, mscBatchSize, symbolDistance),
+    batch_input(std::max(FIC_SYMBOLS, mscBatchSize)),
+    demapper(p, interleaver, constellationDecimation),
+    ficStage(STAGE_QUEUE_FRAMES * FIC_SYMBOLS, 2 * p.K),
+    mscStage(STAGE_QUEUE_FRAMES * (p.L - 1 - FIC_SYMBOLS), 2 * p.K)
 {
     T_g = params.T_s - params.T_u;
     fft_buffer = fft_handler.getVector();
+    symbolQueue.setSpinCount(spinCount);
 
     /**
      * When implemented in a thread, the thread controls the
      * reading in of the data and processing the data through
      * functions for handling symbol 0, FIC symbols and MSC symbols.
+     * The FIC and MSC decoding runs in two more threads.
      */
+    ficStage.thread = std::thread(&OfdmDecoder::stagethread, this,
+            std::ref(ficStage));
+    mscStage.thread = std::thread(&OfdmDecoder::stagethread, this,
+            std::ref(mscStage));
     thread = std::thread(&OfdmDecoder::workerthread, this);
 }
 
 OfdmDecoder::~OfdmDecoder()
 {
     running = false;
-    pending_symbols_cv.notify_all();
+    symbolQueue.interrupt();
+    ficStage.queue.interrupt();
+    mscStage.queue.interrupt();
     if (thread.joinable()) {
         thread.join();
     }
+
+    stagesRunning = false;
+    for (auto stage : {&ficStage, &mscStage}) {
+        stage->queue.interrupt();
+        if (stage->thread.joinable()) {
+            stage->thread.join();
+        }
+    }
+}
+
+OfdmDecoder::DecoderStage::DecoderStage(size_t capacity, size_t numBits) :
+    queue(capacity, SoftBits{std::vector<int16_t>(numBits), 0, 0, {}})
+{
+}
+
+decoder_stage_stats_t OfdmDecoder::DecoderStage::getStats() const
+{
+    decoder_stage_stats_t stats;
+    stats.queue_capacity = queue.capacity();
+    stats.queue_depth = queue.size();
+    stats.max_queue_depth = maxDepth.load();
+    stats.num_symbols = numSymbols.load();
+    if (stats.num_symbols > 0) {
+        stats.mean_latency_us =
+            totalLatency_ns.load() / 1e3 / stats.num_symbols;
+    }
+    stats.max_latency_us = maxLatency_ns.load() / 1e3;
+    return stats;
+}
+
+decoder_pipeline_stats_t OfdmDecoder::getPipelineStats() const
+{
+    decoder_pipeline_stats_t stats;
+    stats.fic = ficStage.getStats();
+    stats.msc = mscStage.getStats();
+    return stats;
+}
+
+symbol_queue_stats_t OfdmDecoder::getQueueStats() const
+{
+    symbol_queue_stats_t stats;
+    stats.queue_capacity = symbolQueue.capacity();
+    stats.max_queue_depth = maxQueueDepth.load();
+    stats.overruns = numOverruns.load();
+    stats.discarded_frames = numDiscardedFrames.load();
+    return stats;
 }
 
 void OfdmDecoder::reset()
 {
     running = false;
-    pending_symbols_cv.notify_all();
+    symbolQueue.interrupt();
+    ficStage.queue.interrupt();
+    mscStage.queue.interrupt();
     if (thread.joinable()) {
         thread.join();
     }
 
+    // Give the buffers of the symbols that were not decoded back
+    // to the pool
+    while (PendingSymbol *ps = symbolQueue.readSlot()) {
+        ps->buf.release();
+        symbolQueue.commitRead();
+    }
+
+    running = true;
     thread = std::thread(&OfdmDecoder::workerthread, this);
 }
 
@@ -91,62 +182,140 @@ void OfdmDecoder::reset()
  */
 void OfdmDecoder::workerthread()
 {
-    int currentSym = 0;
+    int received = 0;
+    int decoded = 0;
 
-    running = true;
+    constellationPoints.clear();
+    constellationPoints.reserve(
+            (params.L-1) * params.K / constellationDecimation);
 
     while (running) {
-        std::unique_lock<std::mutex> lock(mutex);
-        pending_symbols_cv.wait_for(lock, std::chrono::milliseconds(100));
-
-        if (currentSym == 0) {
+        PendingSymbol *ps = symbolQueue.waitReadSlot(running);
+        if (ps == nullptr)
+            continue;
+
+        const int sym_ix = ps->sym_ix;
+        const uint32_t generation = ps->generation;
+        SymbolBuffer buf = std::move(ps->buf);
+        symbolQueue.commitRead();
+
+        if (sym_ix != received) {
+            //  Symbols were dropped, the rest of the frame is useless
+            if (received != 0) {
+                numDiscardedFrames++;
+            }
+            for (int i = decoded; i < received; i++) {
+                frameSymbols[i].release();
+            }
+            received = 0;
+            decoded = 0;
             constellationPoints.clear();
-            constellationPoints.reserve(
-                    (params.L-1) * params.K / constellationDecimation);
+
+            if (sym_ix != 0)
+                continue;
         }
 
-        while (num_pending_symbols > 0 && running) {
-            if (currentSym == 0)
+        frameGenerations[received] = generation;
+        frameSymbols[received++] = std::move(buf);
+
+        while (decoded < received) {
+            int32_t numSymbols = 1;
+            if (decoded == 0) {
                 processPRS();
-            else
-                decodeDataSymbol(currentSym);
-
-            currentSym = (currentSym + 1) % (params.L);
-            num_pending_symbols -= 1;
-
-            if (currentSym == 0) {
-                radioInterface.onConstellationPoints(
-                        std::move(constellationPoints));
-                constellationPoints.clear();
-                constellationPoints.reserve(
-                        (params.L-1) * params.K / constellationDecimation);
             }
+            else {
+                //  Wait until the whole batch is there
+                fft::ForwardBatch& fft =
+                    decoded <= FIC_SYMBOLS ? fic_fft : msc_fft;
+                numSymbols = fft.getBatchSize();
+                if (received - decoded < numSymbols)
+                    break;
+
+                decodeDataSymbols(decoded, fft);
+            }
+            decoded += numSymbols;
+        }
+
+        if (decoded == params.L) {
+            received = 0;
+            decoded = 0;
+            radioInterface.onConstellationPoints(
+                    std::move(constellationPoints));
+            constellationPoints.clear();
+            constellationPoints.reserve(
+                    (params.L-1) * params.K / constellationDecimation);
         }
     }
 
+    for (int i = decoded; i < received; i++) {
+        frameSymbols[i].release();
+    }
+
     std::clog << "OFDM-decoder:" <<  "closing down now" << std::endl;
 }
 
+/**
+ * The stage threads take the soft bits of one symbol after the other
+ * from their queue, and hand them over to the fichandler or mschandler.
+ * Since every stage sees all its symbols in order, the handlers still
+ * know where the frames and CIFs start.
+ */
+void OfdmDecoder::stagethread(DecoderStage& stage)
+{
+    while (stagesRunning) {
+        SoftBits *sb = stage.queue.waitReadSlot(stagesRunning);
+        if (sb == nullptr)
+            continue;
+
+        if (sb->sym_ix <= FIC_SYMBOLS)
+            ficHandler.processFicBlock(sb->bits.data(), sb->sym_ix);
+        else
+            mscHandler.processMscBlock(sb->bits.data(), sb->sym_ix,
+                    sb->generation);
+
+        const uint64_t latency = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - sb->timestamp).count();
+        stage.queue.commitRead();
+
+        stage.numSymbols++;
+        stage.totalLatency_ns += latency;
+        if (latency > stage.maxLatency_ns)
+            stage.maxLatency_ns = latency;
+    }
+}
+
 /**
  * We need some functions to enter the ofdmProcessor data
  * in the buffer.
  */
-void OfdmDecoder::pushPRS(std::vector<DSPCOMPLEX> &vi)
+void OfdmDecoder::pushPRS(const SymbolBuffer& vi, uint32_t generation)
 {
-    std::unique_lock<std::mutex> lock(mutex);
+    push(SymbolBuffer(vi), 0, generation);
+}
 
-    pending_symbols[0] = vi;
-    num_pending_symbols++;
-    pending_symbols_cv.notify_one();
+void OfdmDecoder::pushSymbol(SymbolBuffer&& vi, int sym_ix,
+        uint32_t generation)
+{
+    push(std::move(vi), sym_ix, generation);
 }
 
-void OfdmDecoder::pushSymbol(std::vector<DSPCOMPLEX>&& vi, int sym_ix)
+void OfdmDecoder::push(SymbolBuffer&& vi, int sym_ix, uint32_t generation)
 {
-    std::unique_lock<std::mutex> lock(mutex);
+    PendingSymbol *ps = symbolQueue.writeSlot();
+    if (ps == nullptr) {
+        numOverruns++;
+        return;
+    }
+
+    ps->buf = std::move(vi);
+    ps->sym_ix = sym_ix;
+    ps->generation = generation;
+    symbolQueue.commitWrite();
 
-    pending_symbols[sym_ix] = std::move(vi);
-    num_pending_symbols++;
-    pending_symbols_cv.notify_one();
+    const size_t depth = symbolQueue.size();
+    if (depth > maxQueueDepth)
+        maxQueueDepth = depth;
 }
 
 
@@ -162,8 +331,9 @@ void OfdmDecoder::pushSymbol(std::vector<DSPCOMPLEX>&& vi, int sym_ix)
 void OfdmDecoder::processPRS()
 {
     memcpy (fft_buffer,
-            pending_symbols[0].data(),
+            frameSymbols[0].data(),
             params.T_u * sizeof(DSPCOMPLEX));
+    frameSymbols[0].release();
     fft_handler.do_FFT ();
     /**
      * The SNR is determined by looking at a segment of bins
@@ -179,64 +349,67 @@ void OfdmDecoder::processPRS()
      * we are now in the frequency domain, and we keep the carriers
      * as coming from the FFT as phase reference.
      */
-    memcpy(phaseReference.data(), fft_buffer, params.T_u * sizeof (DSPCOMPLEX));
+    demapper.setReference(fft_buffer);
 }
 
 /**
  * For the other symbols, the first step is to go from
  * time to frequency domain, to get the carriers.
+ * This is done for a whole batch of symbols at once, directly
+ * on the symbol buffers, skipping the cyclic prefix.
  *
- * \brief decodeDataSymbol
- * do the transforms and hand over the result to the fichandler or mschandler
+ * \brief decodeDataSymbols
+ * do the transforms and decode the symbols firstSym and following
  */
-void OfdmDecoder::decodeDataSymbol(int32_t sym_ix)
+void OfdmDecoder::decodeDataSymbols(int32_t firstSym, fft::ForwardBatch& fft)
 {
-    memcpy (fft_buffer,
-            pending_symbols[sym_ix].data() + T_g,
-            params.T_u * sizeof (DSPCOMPLEX));
-    //fftlabel:
-    /**
-     * first step: do the FFT
-     */
-    fft_handler.do_FFT();
+    const int32_t n = fft.getBatchSize();
+    for (int32_t i = 0; i < n; i++) {
+        batch_input[i] = frameSymbols[firstSym + i].data() + T_g;
+    }
 
-    /**
-     * a little optimization: we do not interchange the
-     * positive/negative frequencies to their right positions.
-     * The de-interleaving understands this
-     */
+    fft.do_FFT(batch_input.data());
 
-    /**
-     * Note that from here on, we are only interested in the
-     * K useful carriers of the FFT output
-     */
-    for (int16_t i = 0; i < params.K; i ++) {
-        int16_t index = interleaver.mapIn(i);
-        if (index < 0)
-            index += params.T_u;
-        /**
-         * decoding is computing the phase difference between
-         * carriers with the same index in subsequent symbols.
-         * The carrier of a symbols is the reference for the carrier
-         * on the same position in the next symbols
-         */
-        const DSPCOMPLEX r1 = fft_buffer[index] * conj (phaseReference[index]);
-        phaseReference[index] = fft_buffer[index];
-        const DSPFLOAT ab1 = 127.0f / l1_norm(r1);
-        /// split the real and the imaginary part and scale it
-
-        ibits[i]            = -real (r1) * ab1;
-        ibits[params.K + i] = -imag (r1) * ab1;
-
-        if (i % constellationDecimation == 0) {
-            constellationPoints.push_back(r1);
-        }
+    for (int32_t i = 0; i < n; i++) {
+        frameSymbols[firstSym + i].release();
     }
 
-    if (sym_ix < 4)
-        ficHandler.processFicBlock(ibits.data(), sym_ix);
-    else
-        mscHandler.processMscBlock(ibits.data(), sym_ix);
+    for (int32_t i = 0; i < n; i++) {
+        decodeDataSymbol(firstSym + i, fft.getVector(i));
+    }
+}
+
+/**
+ * \brief decodeDataSymbol
+ * map the carriers to soft bits, directly into the queue of the
+ * FIC or MSC stage
+ */
+void OfdmDecoder::decodeDataSymbol(int32_t sym_ix, const DSPCOMPLEX *carriers)
+{
+    /**
+     * decoding is computing the phase difference between
+     * carriers with the same index in subsequent symbols.
+     * The carrier of a symbols is the reference for the carrier
+     * on the same position in the next symbols.
+     * Only the K useful carriers of the FFT output are used
+     */
+    DecoderStage& stage = sym_ix <= FIC_SYMBOLS ? ficStage : mscStage;
+    SoftBits *sb = stage.queue.waitWriteSlot(running);
+    if (sb == nullptr)
+        return;
+
+    const size_t numPoints = constellationPoints.size();
+    constellationPoints.resize(numPoints + params.K / constellationDecimation);
+    demapper.demap(carriers, sb->bits.data(), &constellationPoints[numPoints]);
+
+    sb->sym_ix = sym_ix;
+    sb->generation = frameGenerations[sym_ix];
+    sb->timestamp = std::chrono::steady_clock::now();
+    stage.queue.commitWrite();
+
+    const size_t depth = stage.queue.size();
+    if (depth > stage.maxDepth)
+        stage.maxDepth = depth;
 }
 
 /**
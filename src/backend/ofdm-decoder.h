@@ -27,17 +27,35 @@
 #include <cstddef>
 #include <vector>
 #include <thread>
-#include <condition_variable>
-#include <mutex>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include "fft.h"
+#include "symbol-buffer-pool.h"
+#include "spsc_queue.h"
 #include "dab-constants.h"
 #include "freq-interleaver.h"
+#include "dqpsk-demapper.h"
 #include "radio-controller.h"
 #include "fic-handler.h"
 #include "msc-handler.h"
 
+struct decoder_stage_stats_t {
+    size_t queue_capacity = 0;
+    // Symbols waiting to be decoded, now and at most
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    uint64_t num_symbols = 0;
+    // Time from the end of demapping to the end of decoding
+    double mean_latency_us = 0;
+    double max_latency_us = 0;
+};
+
+struct decoder_pipeline_stats_t {
+    decoder_stage_stats_t fic;
+    decoder_stage_stats_t msc;
+};
+
 class OfdmDecoder
 {
     public:
@@ -45,11 +63,21 @@ class OfdmDecoder
                 const DABParams& p,
                 RadioControllerInterface& mr,
                 FicHandler& ficHandler,
-                MscHandler& mscHandler);
+                MscHandler& mscHandler,
+                int32_t symbolDistance,
+                int fftBatchSize,
+                int spinCount);
         ~OfdmDecoder();
-        void    pushPRS(std::vector<DSPCOMPLEX>& sym);
-        void    pushSymbol(std::vector<DSPCOMPLEX>&& sym, int sym_ix);
+        // The generation of the frequency correction the symbol was
+        // received with is passed on to the MSC
+        void    pushPRS(const SymbolBuffer& sym, uint32_t generation);
+        void    pushSymbol(SymbolBuffer&& sym, int sym_ix,
+                uint32_t generation);
         void    reset();
+
+        decoder_pipeline_stats_t getPipelineStats(void) const;
+        symbol_queue_stats_t getQueueStats(void) const;
+
     private:
         int16_t get_snr(DSPCOMPLEX *);
 
@@ -57,25 +85,77 @@ class OfdmDecoder
         RadioControllerInterface& radioInterface;
         FicHandler& ficHandler;
         MscHandler& mscHandler;
-        std::atomic<bool> running;
+        std::atomic<bool> running = ATOMIC_VAR_INIT(true);
+
+        /* The symbols are handed over from the OFDMProcessor through a
+         * queue that holds one frame. If the worker falls behind, the
+         * producer does not wait but drops the symbol and counts an
+         * overrun, the worker then discards the incomplete frame. */
+        struct PendingSymbol {
+            SymbolBuffer buf;
+            int16_t sym_ix = 0;
+            uint32_t generation = 0;
+        };
+
+        SpscQueue<PendingSymbol> symbolQueue;
+        std::atomic<uint64_t> numOverruns = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> numDiscardedFrames = ATOMIC_VAR_INIT(0);
+        std::atomic<size_t> maxQueueDepth = ATOMIC_VAR_INIT(0);
+        void push(SymbolBuffer&& sym, int sym_ix, uint32_t generation);
 
-        std::condition_variable pending_symbols_cv;
-        std::mutex mutex;
-        int num_pending_symbols = 0;
-        std::vector<std::vector<DSPCOMPLEX> > pending_symbols;
+        // The symbols of the current frame, owned by the worker
+        std::vector<SymbolBuffer> frameSymbols;
+        std::vector<uint32_t> frameGenerations;
 
         std::thread thread;
         void workerthread(void);
         void processPRS();
-        void decodeDataSymbol(int32_t n);
+        void decodeDataSymbols(int32_t firstSym, fft::ForwardBatch& fft);
+        void decodeDataSymbol(int32_t n, const DSPCOMPLEX *carriers);
 
         int32_t T_g;
-        std::vector<DSPCOMPLEX> phaseReference;
         fft::Forward fft_handler;
         DSPCOMPLEX   *fft_buffer;
         FrequencyInterleaver interleaver;
 
-        std::vector<int16_t> ibits;
+        // The FIC symbols are transformed together, the MSC symbols
+        // in batches of mscBatchSize
+        int32_t mscBatchSize;
+        fft::ForwardBatch fic_fft;
+        fft::ForwardBatch msc_fft;
+        std::vector<const DSPCOMPLEX*> batch_input;
+
+        // Holds the phase reference
+        DqpskDemapper demapper;
+
+        /* The soft bits of the FIC and MSC symbols are decoded by one
+         * thread each, which receive them through a queue. */
+        struct SoftBits {
+            std::vector<int16_t> bits;
+            int16_t sym_ix = 0;
+            uint32_t generation = 0;
+            std::chrono::steady_clock::time_point timestamp;
+        };
+
+        struct DecoderStage {
+            DecoderStage(size_t capacity, size_t numBits);
+
+            SpscQueue<SoftBits> queue;
+            std::thread thread;
+
+            std::atomic<size_t> maxDepth = ATOMIC_VAR_INIT(0);
+            std::atomic<uint64_t> numSymbols = ATOMIC_VAR_INIT(0);
+            std::atomic<uint64_t> totalLatency_ns = ATOMIC_VAR_INIT(0);
+            std::atomic<uint64_t> maxLatency_ns = ATOMIC_VAR_INIT(0);
+
+            decoder_stage_stats_t getStats(void) const;
+        };
+
+        std::atomic<bool> stagesRunning = ATOMIC_VAR_INIT(true);
+        DecoderStage ficStage;
+        DecoderStage mscStage;
+        void stagethread(DecoderStage& stage);
+
         int16_t snrCount = 0;
         int16_t snr = 0;
 
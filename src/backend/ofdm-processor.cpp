@@ -33,9 +33,20 @@
 #include <cstddef>
 #include "ofdm-processor.h"
 #include <iostream>
+#include <algorithm>
 //
-#define SEARCH_RANGE        (2 * 36)
-#define CORRELATION_LENGTH  24
+//  Block size and envelope window length for the null symbol search
+#define ACQUISITION_BLOCK   4096
+#define ENVELOPE_WINDOW     50
+//  The null detection thresholds follow sLevel, and are updated
+//  every SCAN_STEP samples
+#define SCAN_STEP           64
+//  The symbol pool holds the frame in the decoder queue, the symbols
+//  the decoder is still working on, the PRS and NULL kept for the
+//  TII decoder and the symbol being written
+#define SYMBOL_POOL_FRAMES 2
+//  onFrequencyCorrectorChange is called N times per second
+#define N   5
 
 /**
   * \brief OFDMProcessor
@@ -56,25 +67,30 @@ OFDMProcessor::OFDMProcessor(
         RadioControllerInterface& ri,
         MscHandler& msc,
         FicHandler& fic,
+        SyncMilestoneTracker& milestones,
         RadioReceiverOptions rro) :
     radioInterface(ri),
     input(inputInterface),
     params(params),
     ficHandler(fic),
+    milestones(milestones),
+    symbolPool(std::max(params.T_s, params.T_null),
+            SYMBOL_POOL_FRAMES * params.L),
     decodeTII(rro.decodeTII),
     tiiDecoder(params, ri),
     T_null(params.T_null),
     T_u(params.T_u),
     T_s(params.T_s),
     T_F(params.T_F),
-    oscillatorTable(INPUT_RATE),
+    oscillator(INPUT_RATE),
+    sLevel(0.00001),
     disableCoarseCorrector(rro.disable_coarse_corrector),
-    freqsyncMethod(rro.freqsyncMethod),
-    ofdmBuffer(params.L * params.T_s),
     phaseRef(params, rro.ofdmProcessorThreshold),
-    ofdmDecoder(params, ri, fic, msc),
-    fft_handler(params.T_u),
-    fft_buffer(fft_handler.getVector())
+    coarseSync(params, phaseRef, rro.freqsyncMethod, rro.coarseSyncThread),
+    ofdmDecoder(params, ri, fic, msc, symbolPool.getSlotDistance(),
+            rro.fftBatchSize, rro.decoderSpinCount),
+    acqBuffer(ACQUISITION_BLOCK),
+    acqEnvelope(ENVELOPE_WINDOW + ACQUISITION_BLOCK)
 {
     /**
      * the class phaseReference will take a number of samples
@@ -90,19 +106,6 @@ OFDMProcessor::OFDMProcessor(
      * map the result on (soft) bits and hand over control for handling
      * the decoded symbols
      */
-
-    for (int i = 0; i < INPUT_RATE; i ++)
-        oscillatorTable[i] = DSPCOMPLEX(cos(2.0 * M_PI * i / INPUT_RATE),
-                sin(2.0 * M_PI * i / INPUT_RATE));
-
-    //  and for the correlation
-    refArg.resize(CORRELATION_LENGTH);
-    for (int i = 0; i < CORRELATION_LENGTH; i ++)  {
-        refArg[i] = arg(phaseRef[(T_u + i) % T_u] *
-                conj(phaseRef[(T_u + i + 1) % T_u]));
-    }
-
-    correlationVector.resize(SEARCH_RANGE + CORRELATION_LENGTH);
 }
 
 OFDMProcessor::~OFDMProcessor()
@@ -119,9 +122,11 @@ void OFDMProcessor::start()
     std::clog << "OFDM-processor:" <<  "start" << std::endl;
     coarseCorrector    = 0;
     fineCorrector      = 0;
-    syncBufferIndex    = 0;
-    sLevel             = 0;
-    localPhase         = 0;
+    correctionGeneration++;
+    sLevel.reset();
+    acqIndex           = 0;
+    acqLength          = 0;
+    oscillator.reset();
     input.restart();
     running            = true;
     threadHandle       = std::thread(&OFDMProcessor::run, this);
@@ -129,57 +134,161 @@ void OFDMProcessor::start()
 
 
 /**
- * \brief getSample
+ * \brief readAcquisitionBlock
  * Profiling shows that getting a sample, together
  * with the frequency shift, is a real performance killer.
- * we therefore distinguish between getting a single sample
- * and getting a vector full of samples
+ * While searching for the null symbol, we therefore fetch
+ * the samples in blocks into the acquisition window, and let
+ * the envelope detection run over the whole block.
+ * Must only be called once the previous block has been consumed.
  */
-
-DSPCOMPLEX OFDMProcessor::getSample (int32_t phase)
+void OFDMProcessor::readAcquisitionBlock(int32_t phase)
 {
-    DSPCOMPLEX temp;
     if (!running)
         throw 21;
-    /// bufferContent is an indicator for the value of ...->Samples ()
-    if (bufferContent == 0) {
+
+    bufferContent = input.getSamplesToRead ();
+    while ((bufferContent == 0) && running) {
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
         bufferContent = input.getSamplesToRead ();
-        while ((bufferContent == 0) && running) {
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
-            bufferContent = input.getSamplesToRead ();
-        }
     }
 
     if (!running)
         throw 20;
-    //
-    //  so here, bufferContent > 0
-    input.getSamples (&temp, 1);
-    bufferContent --;
 
-    //
-    //  OK, we have a sample!!
-    //  first: adjust frequency. We need Hz accuracy
-    localPhase  -= phase;
-    localPhase  = (localPhase + INPUT_RATE) % INPUT_RATE;
-    temp        *= oscillatorTable[localPhase];
-    sLevel      = 0.00001 * l1_norm(temp) + (1 - 0.00001) * sLevel;
-#define N   5
-    sampleCnt   ++;
-    if (++ sampleCnt > INPUT_RATE / N) {
+    //  keep the envelope of the samples still in the sliding window
+    if (acqLength > 0) {
+        std::copy(acqEnvelope.begin() + acqLength,
+                acqEnvelope.begin() + acqLength + ENVELOPE_WINDOW,
+                acqEnvelope.begin());
+    }
+
+    const int32_t n = input.getSamples(acqBuffer.data(),
+            std::min(bufferContent, (int32_t)ACQUISITION_BLOCK));
+    bufferContent -= n;
+
+    oscillator.mix(acqBuffer.data(), n, phase);
+
+    float *envelope = &acqEnvelope[ENVELOPE_WINDOW];
+    for (int32_t i = 0; i < n; i ++)
+        envelope[i] = l1_norm(acqBuffer[i]);
+
+    acqIndex  = 0;
+    acqLength = n;
+
+    sampleCnt += n;
+    if (sampleCnt > INPUT_RATE / N) {
         radioInterface.onFrequencyCorrectorChange(
                 fineCorrector, coarseCorrector);
         sampleCnt = 0;
     }
-    return temp;
 }
 
-void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
+/**
+ * \brief skipSamples
+ * Consume n samples from the acquisition window, only
+ * updating sLevel
+ */
+void OFDMProcessor::skipSamples(int32_t n, int32_t phase)
 {
-    int32_t     i;
+    while (n > 0) {
+        if (acqIndex == acqLength)
+            readAcquisitionBlock(phase);
+
+        const int32_t count = std::min(acqLength - acqIndex, n);
+        sLevel.update(&acqEnvelope[ENVELOPE_WINDOW + acqIndex], count);
+        acqIndex += count;
+        n        -= count;
+    }
+}
+
+/**
+ * \brief primeEnvelope
+ * Consume ENVELOPE_WINDOW samples to get an initial value for
+ * currentStrength, the sum of the envelope over the sliding window.
+ */
+void OFDMProcessor::primeEnvelope(int32_t phase)
+{
+    currentStrength = 0;
+    for (int32_t i = 0; i < ENVELOPE_WINDOW; i ++) {
+        if (acqIndex == acqLength)
+            readAcquisitionBlock(phase);
+
+        const float *e = &acqEnvelope[ENVELOPE_WINDOW + acqIndex];
+        sLevel.update(e, 1);
+        currentStrength += *e;
+        acqIndex ++;
+    }
+}
+
+/**
+ * \brief scanEnvelope
+ * Slide the window over the acquired samples until its average
+ * drops to (lookForDip) or rises above (!lookForDip) level * sLevel.
+ * The samples following the detection point stay in the window
+ * and are handed out by getSamples.
+ * Returns false if the condition was not met within maxSamples.
+ */
+bool OFDMProcessor::scanEnvelope(bool lookForDip, float level,
+        int32_t maxSamples, int32_t phase)
+{
+    int32_t counter = 0;
+    for (;;) {
+        const float *envelope = &acqEnvelope[ENVELOPE_WINDOW];
+        while (acqIndex < acqLength) {
+            //  compare the sum rather than the average over the window
+            const float threshold = level * ENVELOPE_WINDOW * sLevel.get();
+            const int32_t end = std::min(acqLength, acqIndex + SCAN_STEP);
+
+            int32_t i = acqIndex;
+            bool found = false;
+            bool hopeless = false;
+            for (; i < end; i ++) {
+                if (lookForDip ?
+                        currentStrength <= threshold :
+                        currentStrength >= threshold) {
+                    found = true;
+                    break;
+                }
 
+                currentStrength += envelope[i] - envelope[i - ENVELOPE_WINDOW];
+
+                if (++ counter > maxSamples) {
+                    i ++;
+                    hopeless = true;
+                    break;
+                }
+            }
+
+            sLevel.update(&envelope[acqIndex], i - acqIndex);
+            acqIndex = i;
+
+            if (found)
+                return true;
+            if (hopeless)
+                return false;
+        }
+
+        readAcquisitionBlock(phase);
+    }
+}
+
+void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
+{
     if (!running)
         throw 21;
+
+    //  First hand out what is left in the acquisition window,
+    //  these samples were already mixed
+    const int32_t fromWindow = std::min<int32_t>(n, acqLength - acqIndex);
+    std::copy(&acqBuffer[acqIndex], &acqBuffer[acqIndex + fromWindow], v);
+    sLevel.update(&acqEnvelope[ENVELOPE_WINDOW + acqIndex], fromWindow);
+    acqIndex    += fromWindow;
+    v           += fromWindow;
+    n           -= fromWindow;
+    if (n == 0)
+        return;
+
     if (n > bufferContent) {
         bufferContent = input.getSamplesToRead ();
         while ((bufferContent < n) && running) {
@@ -196,12 +305,8 @@ void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
 
     //  OK, we have samples!!
     //  first: adjust frequency. We need Hz accuracy
-    for (i = 0; i < n; i ++) {
-        localPhase  -= phase;
-        localPhase   = (localPhase + INPUT_RATE) % INPUT_RATE;
-        v[i]    *= oscillatorTable[localPhase];
-        sLevel   = 0.00001 * l1_norm(v[i]) + (1 - 0.00001) * sLevel;
-    }
+    oscillator.mix(v, n, phase);
+    sLevel.update(v, n);
 
     sampleCnt += n;
     if (sampleCnt > INPUT_RATE / N) {
@@ -222,12 +327,6 @@ void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
 void OFDMProcessor::run()
 {
     int32_t     startIndex;
-    int32_t     i;
-    int32_t     counter;
-    float       currentStrength;
-    int32_t     syncBufferSize  = 32768;
-    int32_t     syncBufferMask  = syncBufferSize - 1;
-    float       envBuffer   [syncBufferSize];
 
     /*running       = true;
       fineCorrector   = 0;
@@ -236,28 +335,17 @@ void OFDMProcessor::run()
 
         //Initing:
         /// first, we need samples to get a reasonable sLevel
-        sLevel   = 0;
-        for (i = 0; i < T_F / 2; i ++) {
-            l1_norm(getSample (0));
-        }
+        sLevel.reset();
+        skipSamples(T_F / 2, coarseCorrector + fineCorrector);
 notSynced:
         if (scanMode && ++attempts > 5) {
             radioInterface.onSignalPresence(false);
             scanMode  = false;
             attempts  = 0;
         }
-        syncBufferIndex  = 0;
-        currentStrength  = 0;
-
-        //  read in T_s samples for a next attempt;
-        syncBufferIndex = 0;
-        currentStrength  = 0;
-        for (i = 0; i < 50; i ++) {
-            DSPCOMPLEX sample         = getSample (0);
-            envBuffer [syncBufferIndex]   = l1_norm(sample);
-            currentStrength           += envBuffer [syncBufferIndex];
-            syncBufferIndex ++;
-        }
+
+        //  read in ENVELOPE_WINDOW samples for a next attempt;
+        primeEnvelope(coarseCorrector + fineCorrector);
         /**
          * We now have initial values for currentStrength (i.e. the sum
          * over the last 50 samples) and sLevel, the long term average.
@@ -266,45 +354,25 @@ notSynced:
         /**
          * here we start looking for the null level, i.e. a dip
          */
-        counter  = 0;
         radioInterface.onSyncChange(false);
-        while (currentStrength / 50  > 0.50 * sLevel) {
-            DSPCOMPLEX sample =
-                getSample (coarseCorrector + fineCorrector);
-            envBuffer [syncBufferIndex] = l1_norm(sample);
-            //  update the levels
-            currentStrength += envBuffer [syncBufferIndex] -
-                envBuffer [(syncBufferIndex - 50) & syncBufferMask];
-            syncBufferIndex = (syncBufferIndex + 1) & syncBufferMask;
-            counter ++;
-            if (counter > T_F) { // hopeless
-                //           fprintf (stderr, "%f %f\n", currentStrength / 50, sLevel);
-                goto notSynced;
-            }
+        if (!scanEnvelope(true, 0.50, T_F,
+                    coarseCorrector + fineCorrector)) { // hopeless
+            goto notSynced;
         }
         /**
          * It seemed we found a dip that started app 65/100 * 50 samples earlier.
          * We now start looking for the end of the null period.
          */
-        counter  = 0;
         //SyncOnEndNull:
-        while (currentStrength / 50 < 0.75 * sLevel) {
-            DSPCOMPLEX sample = getSample (coarseCorrector + fineCorrector);
-            envBuffer [syncBufferIndex] = l1_norm(sample);
-            //  update the levels
-            currentStrength += envBuffer [syncBufferIndex] -
-                envBuffer [(syncBufferIndex - 50) & syncBufferMask];
-            syncBufferIndex = (syncBufferIndex + 1) & syncBufferMask;
-            counter   ++;
-            //
-            if (counter > T_null + 50) { // hopeless
-                goto notSynced;
-            }
+        if (!scanEnvelope(false, 0.75, T_null + 50,
+                    coarseCorrector + fineCorrector)) { // hopeless
+            goto notSynced;
         }
         /**
          * The end of the null period is identified, probably about 40
          * samples earlier.
          */
+        milestones.reached(SyncMilestone::NullDetected);
 SyncOnPhase:
         /**
          * We now have to find the exact first sample of the non-null period.
@@ -317,11 +385,12 @@ SyncOnPhase:
          * as long as we can be sure that the first sample to be identified
          * is part of the samples read.
          */
-        getSamples(ofdmBuffer.data(), T_u, coarseCorrector + fineCorrector);
+        SymbolBuffer prs = symbolPool.acquire();
+        getSamples(prs.data(), T_u, coarseCorrector + fineCorrector);
         //
         /// and then, call upon the phase synchronizer to verify/compute
         /// the real "first" sample
-        startIndex = phaseRef.findIndex(ofdmBuffer.data(),
+        startIndex = phaseRef.findIndex(prs.data(),
                 impulseResponseBuffer);
         radioInterface.onNewImpulseResponse(std::move(impulseResponseBuffer));
         impulseResponseBuffer.clear();
@@ -329,6 +398,7 @@ SyncOnPhase:
         if (startIndex < 0) { // no sync, try again
             goto notSynced;
         }
+        milestones.reached(SyncMilestone::PrsLocked);
         if (scanMode) {
             radioInterface.onSignalPresence(true);
             scanMode  = false;
@@ -338,9 +408,9 @@ SyncOnPhase:
         /**
          * Once here, we are synchronized, we need to copy the data we
          * used for synchronization for the PRS */
-        memmove(ofdmBuffer.data(), &ofdmBuffer[startIndex],
+        memmove(prs.data(), &prs[startIndex],
                 (params.T_u - startIndex) * sizeof (DSPCOMPLEX));
-        ofdmBufferIndex  = params.T_u - startIndex;
+        const int32_t prsIndex = params.T_u - startIndex;
 
         //Symbol 0: Phase reference symbol symbol
         /**
@@ -350,31 +420,32 @@ SyncOnPhase:
          * We read the missing samples in the ofdm buffer
          */
         radioInterface.onSyncChange(true);
-        getSamples(&ofdmBuffer[ofdmBufferIndex],
-                T_u - ofdmBufferIndex,
+        getSamples(&prs[prsIndex],
+                T_u - prsIndex,
                 coarseCorrector + fineCorrector);
 
-        std::vector<complexf> prs(T_u);
-        std::copy(ofdmBuffer.begin(), ofdmBuffer.begin() + T_u, prs.begin());
-
-        ofdmDecoder.pushPRS(ofdmBuffer);
+        ofdmDecoder.pushPRS(prs, correctionGeneration);
         //  Here we look only at the PRS when we need a coarse
         //  frequency synchronization.
         //  The width is limited to 2 * 35 kHz (i.e. positive and negative)
         if (!disableCoarseCorrector and !ficHandler.getIsCrcValid()) {
-            corseSyncCounter++;
-            int correction = processPRS(ofdmBuffer.data());
-            if (correction != 100) {
-                coarseCorrector += correction * params.carrierDiff;
-                if (abs (coarseCorrector) > kHz(35))
-                    coarseCorrector = 0;
+            //  With the helper thread, the correction is applied at the
+            //  latest at the end of the frame, before the next PRS is
+            //  read. If it is still busy, this PRS is skipped.
+            if (coarseSync.push(prs)) {
+                corseSyncCounter++;
             }
+            applyCoarseCorrection();
         }
         else {
             if(corseSyncCounter) {
                  std::clog << "ofdm-processor: " << "Found coarse frequency offset " << coarseCorrector << " kHz after " << corseSyncCounter << " frames. " << std::endl;
             }
             corseSyncCounter = 0;
+            coarseSync.clear();
+            if (!disableCoarseCorrector) {
+                milestones.reached(SyncMilestone::CoarseCorrected);
+            }
         }
         /**
          * after symbol 0, we will just read in the other (params.L - 1) symbols
@@ -388,12 +459,21 @@ SyncOnPhase:
          */
         DSPCOMPLEX FreqCorr = DSPCOMPLEX(0, 0);
         for (int sym = 1; sym < params.L; sym ++) {
-            std::vector<DSPCOMPLEX> buf(T_s);
+            SymbolBuffer buf = symbolPool.acquire();
             getSamples(buf.data(), T_s, coarseCorrector + fineCorrector);
             for (int i = T_u; i < T_s; i ++)
                 FreqCorr += buf[i] * conj(buf[i - T_u]);
 
-            ofdmDecoder.pushSymbol(std::move(buf), sym);
+            ofdmDecoder.pushSymbol(std::move(buf), sym,
+                    correctionGeneration);
+        }
+
+        applyCoarseCorrection();
+
+        const auto queueStats = ofdmDecoder.getQueueStats();
+        if (queueStats.overruns != lastOverruns) {
+            lastOverruns = queueStats.overruns;
+            radioInterface.onSymbolQueueOverrun(queueStats);
         }
 
         //NewOffset:
@@ -406,24 +486,21 @@ SyncOnPhase:
          * OK,  here we are at the end of the frame
          * Assume everything went well and skip T_null samples
          */
-        syncBufferIndex  = 0;
-        currentStrength  = 0;
 
         // The NULL is interesting to save because it carries the TII.
-        std::vector<DSPCOMPLEX> nullSymbol(T_null);
+        SymbolBuffer nullSymbol = symbolPool.acquire();
         getSamples(nullSymbol.data(), T_null, coarseCorrector + fineCorrector);
         if (decodeTII) {
             tiiDecoder.pushSymbols(nullSymbol, prs);
         }
-        radioInterface.onNewNullSymbol(std::move(nullSymbol));
+        radioInterface.onNewNullSymbol(std::vector<DSPCOMPLEX>(
+                    nullSymbol.begin(), nullSymbol.begin() + T_null));
 
         /**
          * The first sample to be found for the next frame should be T_g
          * samples ahead
          * Here we just check the fineCorrector
          */
-        counter  = 0;
-        //
 
         if (fineCorrector > params.carrierDiff / 2) {
             coarseCorrector += params.carrierDiff;
@@ -450,6 +527,8 @@ void OFDMProcessor::reset()
         running = false;
         threadHandle.join();
     }
+    // The milestones count from the time the input is read again
+    milestones.restart();
     start();
 }
 
@@ -461,6 +540,41 @@ void OFDMProcessor::stop()
 void OFDMProcessor::resetCoarseCorrector()
 {
     coarseCorrector = 0;
+    correctionGeneration++;
+}
+
+void OFDMProcessor::applyCoarseCorrection()
+{
+    int16_t correction;
+    if (coarseSync.getResult(correction) and
+            correction != CoarseFrequencySync::NO_CORRECTION) {
+        const int32_t previous = coarseCorrector;
+        coarseCorrector += correction * params.carrierDiff;
+        if (abs (coarseCorrector) > kHz(35))
+            coarseCorrector = 0;
+
+        //  The CIFs received before are useless, a subchannel must not
+        //  take its logical frames from them. Those still queued are
+        //  recognised by their generation.
+        if (coarseCorrector != previous) {
+            correctionGeneration++;
+        }
+    }
+}
+
+symbol_pool_stats_t OFDMProcessor::getSymbolPoolStats() const
+{
+    return symbolPool.getStats();
+}
+
+symbol_queue_stats_t OFDMProcessor::getSymbolQueueStats() const
+{
+    return ofdmDecoder.getQueueStats();
+}
+
+decoder_pipeline_stats_t OFDMProcessor::getDecoderPipelineStats() const
+{
+    return ofdmDecoder.getPipelineStats();
 }
 
 void OFDMProcessor::setReceiverOptions(const RadioReceiverOptions rro)
@@ -469,7 +583,7 @@ void OFDMProcessor::setReceiverOptions(const RadioReceiverOptions rro)
 
     decodeTII = rro.decodeTII;
     disableCoarseCorrector = rro.disable_coarse_corrector;
-    freqsyncMethod = rro.freqsyncMethod;
+    coarseSync.setMethod(rro.freqsyncMethod);
     phaseRef.setThreshold(rro.ofdmProcessorThreshold);
 
     if (need_reset) {
@@ -481,113 +595,3 @@ void OFDMProcessor::set_scanMode(bool b)
 {
     scanMode = b;
 }
-
-#define RANGE 36
-int16_t OFDMProcessor::processPRS(DSPCOMPLEX *v)
-{
-    int16_t i, j, index = 100;
-
-    memcpy(fft_buffer, v, T_u * sizeof(DSPCOMPLEX));
-    fft_handler.do_FFT();
-
-    switch (freqsyncMethod) {
-        case FreqsyncMethod::GetMiddle:
-            return getMiddle(fft_buffer);
-        case FreqsyncMethod::CorrelatePRS:
-        {
-            //  The "best" approach for computing the coarse frequency
-            //  offset is to look at the spectrum of symbol 0 and relate that
-            //  with the spectrum as it should be, i.e. the refTable
-            //  However, since there might be
-            //  a pretty large phase offset between the incoming data and
-            //  the reference table data, we correlate the
-            //  phase differences between the subsequent carriers rather
-            //  than the values in the segments themselves.
-            //  It seems to work pretty well
-            //
-            //  The phase differences are computed once
-            for (i = 0; i < SEARCH_RANGE + CORRELATION_LENGTH; i ++) {
-                int16_t baseIndex = T_u - SEARCH_RANGE / 2 + i;
-                correlationVector[i] =
-                    arg(fft_buffer[baseIndex % T_u] *
-                    conj(fft_buffer[(baseIndex + 1) % T_u]));
-            }
-
-            float    MMax    = 0;
-            for (i = 0; i < SEARCH_RANGE; i ++) {
-                float sum = 0;
-                for (j = 0; j < CORRELATION_LENGTH; j ++) {
-                    sum += abs(refArg [j] * correlationVector[i + j]);
-                    if (sum > MMax) {
-                        MMax = sum;
-                        index = i;
-                    }
-                }
-            }
-
-            //  Now map the index back to the right carrier
-            return T_u - SEARCH_RANGE / 2 + index - T_u;
-        }
-        case FreqsyncMethod::PatternOfZeros:
-        {
-            //  An alternative way is to look at a special pattern consisting
-            //  of zeros in the row of args between successive carriers.
-            float Mmin   = 1000;
-            for (i = T_u - SEARCH_RANGE / 2; i < T_u + SEARCH_RANGE / 2; i ++) {
-                float a1  =  abs (abs (arg (fft_buffer [(i + 1) % T_u] *
-                                conj (fft_buffer [(i + 2) % T_u])) / M_PI) - 1);
-                float a2  =  abs (abs (arg (fft_buffer [(i + 2) % T_u] *
-                                conj (fft_buffer [(i + 3) % T_u])) / M_PI) - 1);
-                float a3   = abs (arg (fft_buffer [(i + 3) % T_u] *
-                            conj (fft_buffer [(i + 4) % T_u])));
-                float a4   = abs (arg (fft_buffer [(i + 4) % T_u] *
-                            conj (fft_buffer [(i + 5) % T_u])));
-                float a5   = abs (arg (fft_buffer [(i + 5) % T_u] *
-                            conj (fft_buffer [(i + 6) % T_u])));
-                float b1   = abs (abs (arg (fft_buffer [(i + 16 + 1) % T_u] *
-                                conj (fft_buffer [(i + 16 + 3) % T_u])) / M_PI) - 1);
-                float b2   = abs (arg (fft_buffer [(i + 16 + 3) % T_u] *
-                            conj (fft_buffer [(i + 16 + 4) % T_u])));
-                float b3   = abs (arg (fft_buffer [(i + 16 + 4) % T_u] *
-                            conj (fft_buffer [(i + 16 + 5) % T_u])));
-                float b4   = abs (arg (fft_buffer [(i + 16 + 5) % T_u] *
-                            conj (fft_buffer [(i + 16 + 6) % T_u])));
-                float sum = a1 + a2 + a3 + a4 + a5 + b1 + b2 + b3 + b4;
-                if (sum < Mmin) {
-                    Mmin = sum;
-                    index = i;
-                }
-            }
-            return index - T_u;
-        }
-    }
-    throw std::logic_error("Unimplemented freqsyncMethod");
-}
-
-int16_t OFDMProcessor::getMiddle (DSPCOMPLEX *v)
-{
-    int16_t     i;
-    DSPFLOAT    sum = 0;
-    int16_t     maxIndex = 0;
-    DSPFLOAT    oldMax  = 0;
-    //
-    //  basic sum over K carriers that are - most likely -
-    //  in the range
-    //  The range in which the carrier should be is
-    //  T_u / 2 - K / 2 .. T_u / 2 + K / 2
-    //  We first determine an initial sum over params.K carriers
-    for (i = 40; i < params.K + 40; i ++)
-        sum += abs (v [(T_u / 2 + i) % T_u]);
-    //
-    //  Now a moving sum, look for a maximum within a reasonable
-    //  range (around (T_u - K) / 2, the start of the useful frequencies)
-    for (i = 40; i < T_u - (params.K - 40); i ++) {
-        sum -= abs (v [(T_u / 2 + i) % T_u]);
-        sum += abs (v [(T_u / 2 + i + params.K) % T_u]);
-        if (sum > oldMax) {
-            sum = oldMax;
-            maxIndex = i;
-        }
-    }
-    return maxIndex - (T_u - params.K) / 2;
-}
@@ -38,14 +38,18 @@
 #include <atomic>
 #include <vector>
 #include "phasereference.h"
+#include "coarse-sync.h"
 #include "ofdm-decoder.h"
 #include "tii-decoder.h"
 #include "virtual_input.h"
 #include "fft.h"
+#include "nco.h"
+#include "signal_level.h"
 #include "radio-controller.h"
 #include "radio-receiver-options.h"
 #include "fic-handler.h"
 #include "msc-handler.h"
+#include "sync-milestones.h"
 
 class OFDMProcessor
 {
@@ -56,6 +60,7 @@ class OFDMProcessor
                 RadioControllerInterface& ri,
                 MscHandler& msc,
                 FicHandler& fic,
+                SyncMilestoneTracker& milestones,
                 RadioReceiverOptions rro);
         ~OFDMProcessor();
         void reset();
@@ -65,14 +70,20 @@ class OFDMProcessor
         void set_scanMode(bool);
         void start();
 
+        symbol_pool_stats_t getSymbolPoolStats(void) const;
+        symbol_queue_stats_t getSymbolQueueStats(void) const;
+        decoder_pipeline_stats_t getDecoderPipelineStats(void) const;
+
     private:
         std::thread threadHandle;
-        int32_t syncBufferIndex = 0;
         RadioControllerInterface& radioInterface;
         InputInterface& input;
         const DABParams& params;
         FicHandler& ficHandler;
+        SyncMilestoneTracker& milestones;
         std::vector<float> impulseResponseBuffer;
+        // Declared before the decoders, which hold buffers from it
+        SymbolBufferPool symbolPool;
         bool decodeTII;
         TIIDecoder tiiDecoder;
 
@@ -84,38 +95,47 @@ class OFDMProcessor
         int32_t T_F;
         int32_t corseSyncCounter = 0;
 
-        std::vector<DSPCOMPLEX> oscillatorTable;
-
-        int32_t localPhase = 0;
+        NCO oscillator;
 
-        float sLevel = 0;
+        SignalLevel sLevel;
         int32_t sampleCnt = 0;
 
         int16_t fineCorrector = 0;
         int32_t coarseCorrector = 0;
         bool disableCoarseCorrector;
+        // Changes with the coarse frequency and at each start. The
+        // symbols carry it to the MSC, which drops the CIFs of an older
+        // generation still in the queues.
+        uint32_t correctionGeneration = 0;
 
-        FreqsyncMethod freqsyncMethod;
-        std::vector<DSPCOMPLEX> ofdmBuffer;
-        uint32_t ofdmBufferIndex = 0;
         PhaseReference phaseRef;
+        CoarseFrequencySync coarseSync;
         OfdmDecoder ofdmDecoder;
-        std::vector<float> correlationVector;
-        std::vector<float> refArg;
+        uint64_t lastOverruns = 0;
 
         bool scanMode = false;
         int attempts = 0;
 
         int32_t bufferContent = 0;
 
-        fft::Forward fft_handler;
-        DSPCOMPLEX *fft_buffer; // of size T_u
-
-        DSPCOMPLEX getSample(int32_t);
+        /* Block-based acquisition window used while searching for the
+         * null symbol. acqBuffer holds mixed samples, of which those
+         * before acqIndex were already consumed. acqEnvelope holds their
+         * l1 norms, preceded by the envelope of the samples in the
+         * sliding window before acqBuffer[0]. */
+        std::vector<DSPCOMPLEX> acqBuffer;
+        std::vector<float> acqEnvelope;
+        int32_t acqIndex = 0;
+        int32_t acqLength = 0;
+        float currentStrength = 0;
+
+        void readAcquisitionBlock(int32_t);
+        void skipSamples(int32_t, int32_t);
+        void primeEnvelope(int32_t);
+        bool scanEnvelope(bool, float, int32_t, int32_t);
         void getSamples(DSPCOMPLEX *, int16_t, int32_t);
         void run(void);
-        int16_t processPRS(DSPCOMPLEX *v);
-        int16_t getMiddle(DSPCOMPLEX *);
+        void applyCoarseCorrection(void);
 };
 #endif
 
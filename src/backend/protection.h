@@ -32,6 +32,7 @@ class Protection
 {
     public:
         virtual ~Protection() = default;
+        // The decoded bits are packed, as by Viterbi::deconvolve
         virtual bool deconvolve(int16_t *, int32_t, uint8_t *) = 0;
 };
 #endif
@@ -62,6 +62,44 @@ struct tii_measurement_t {
     float getDelayKm(void) const;
 };
 
+/* Counters of the queue that hands the OFDM symbols over to the
+ * decoder thread. */
+struct symbol_queue_stats_t {
+    size_t queue_capacity = 0;
+    size_t max_queue_depth = 0;
+    // Symbols dropped because the decoder did not keep up
+    uint64_t overruns = 0;
+    // Frames that could not be decoded because of dropped symbols
+    uint64_t discarded_frames = 0;
+};
+
+/* Counters of the queue that hands the logical frames of a programme
+ * over to its decoder. */
+struct frame_overflow_stats_t {
+    size_t queue_capacity = 0;
+    // Frames dropped because the decoder did not keep up
+    uint64_t dropped_frames = 0;
+    // Times the MSC thread had to wait for the decoder to free a slot,
+    // with the Block policy only
+    uint64_t waits = 0;
+};
+
+/* Time at which the receiver reached the milestones of the acquisition,
+ * in milliseconds since it was restarted, or -1 if not reached yet.
+ * The audio milestones are relative to the restart as well, but are
+ * cleared every time a programme is selected. */
+struct sync_milestones_t {
+    double null_detected = -1;
+    double prs_locked = -1;
+    // Confirmed at the first PRS after the FIC CRC became valid
+    double coarse_corrected = -1;
+    double fib_crc_valid = -1;
+    double ensemble_label = -1;
+    double programme_selected = -1;
+    double audio_sync = -1;
+    double first_audio = -1;
+};
+
 enum class message_level_t { Information, Error };
 
 /* Definition of the interface all radio controllers must implement.
@@ -93,8 +131,22 @@ class RadioControllerInterface {
         virtual void onNewEnsembleName(const std::string& name) = 0;
         virtual void onDateTimeUpdate(const dab_date_time_t& dateTime) = 0;
 
-        /* For every FIB, tell if the CRC check passed. fib points to a bit-vector with 256 bits of FIB data  */
-        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) = 0;
+        /* For every FIB, tell if the CRC check passed. fib points to the
+         * 32 bytes of the FIB, CRC included. The default implementation
+         * unpacks the FIB and calls onFIBDecodeSuccess. */
+        virtual void onFIBDecoded(bool crcCheckOk, const uint8_t* fib) {
+            uint8_t bits[256];
+            for (int i = 0; i < 256; i++) {
+                bits[i] = (fib[i / 8] >> (7 - i % 8)) & 1;
+            }
+            onFIBDecodeSuccess(crcCheckOk, bits);
+        }
+
+        /* Same as onFIBDecoded, but fib points to a bit-vector with 256 bits
+         * of FIB data. Only called if onFIBDecoded is not overridden. */
+        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) {
+            (void)crcCheckOk; (void)fib;
+        }
 
         /* When a new channel impulse response vector was calculated */
         virtual void onNewImpulseResponse(std::vector<float>&& data) = 0;
@@ -110,6 +162,14 @@ class RadioControllerInterface {
         /* When TII information for a comb/pattern pair is available */
         virtual void onTIIMeasurement(tii_measurement_t&& m) = 0;
 
+        /* When the decoder did not keep up with the OFDM symbols and
+         * some had to be dropped. Called at most once per frame. */
+        virtual void onSymbolQueueOverrun(const symbol_queue_stats_t& stats) = 0;
+
+        /* When a milestone of the acquisition was reached for the first
+         * time since the restart, or since the programme was selected. */
+        virtual void onSyncMilestones(const sync_milestones_t& milestones) = 0;
+
         /* When a information or warning message should be printed */
         virtual void onMessage(message_level_t level, const std::string& text) = 0;
 };
@@ -150,6 +210,11 @@ class ProgrammeHandlerInterface {
          * and effective X-PAD length.
          */
         virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) = 0;
+
+        /* When the decoder did not keep up with the MSC and a logical
+         * frame of the programme had to be dropped, or the MSC had to
+         * wait for it. */
+        virtual void onFrameOverflow(const frame_overflow_stats_t& stats) = 0;
 };
 
 enum class DeviceParam {
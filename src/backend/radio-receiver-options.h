@@ -40,7 +40,14 @@ constexpr int OLD_OFDM_PROCESSOR_THRESHOLD = 3;
 constexpr int DEFAULT_OFDM_PROCESSOR_THRESHOLD = 3;
 constexpr int NEW_OFDM_PROCESSOR_THRESHOLD = -1;
 
-// Configuration for the backend
+// What to do with a logical frame when the decoder of its programme is
+// too far behind, see RadioReceiverOptions::frameOverflowPolicy
+enum class FrameOverflowPolicy { DropNewest = 0, DropOldest = 1, Block = 2 };
+
+// Configuration for the backend. ofdmProcessorThreshold, decodeTII,
+// disable_coarse_corrector and freqsyncMethod can be changed with
+// RadioReceiver::setReceiverOptions while the receiver runs, the other
+// options are only taken into account when the receiver is created.
 struct RadioReceiverOptions {
     // Select the algorithm used in the OFDMProcessor PRS sync logic
     // to place the FFT window for demodulation. Set to 3 for the original
@@ -62,5 +69,52 @@ struct RadioReceiverOptions {
     // Which method to use for the freqsyncmethod used in the coarse corrector.
     // Has no effect when coarse corrector is disabled.
     FreqsyncMethod freqsyncMethod = FreqsyncMethod::PatternOfZeros;
+
+    // Run the coarse frequency search on a helper thread, so that the
+    // thread reading the samples is not delayed by it.
+    bool coarseSyncThread = false;
+
+    // Number of MSC symbols the OFDM decoder transforms in one FFT call.
+    // It is reduced to a divisor of the number of MSC symbols per frame,
+    // 1 transforms the symbols one by one.
+    int fftBatchSize = 18;
+
+    // Number of times the OFDM decoder polls its input queue before it
+    // goes to sleep. Polling reduces the wake-up latency at the cost of
+    // CPU time.
+    int decoderSpinCount = 0;
+
+    // Fraction of the real time the Viterbi decoder of a DAB+ subchannel
+    // may take in soft-output mode. In this mode, the Reed-Solomon decoder
+    // tries the least reliable bytes as erasures when a packet has too many
+    // errors. Above the budget, the soft output is switched off for a while.
+    // 0 disables it.
+    float viterbiSoftOutputBudget = 0;
+
+    // Once the ensemble has not changed for about 10 seconds, decode only
+    // one FIC frame in ficDecimation on average, until the next change or
+    // CRC error. 1 decodes every frame.
+    int ficDecimation = 1;
+
+    // Number of threads decoding the subchannels of the MSC, shared by
+    // all selected services. 0 starts one thread per core.
+    int decoderThreads = 0;
+
+    // Number of OFDM symbols a logical frame may wait for the frames of
+    // other subchannels to fill a batched Viterbi pass. Waiting fills the
+    // passes better but delays the audio, 0 hands every frame over as
+    // soon as its subchannel was received.
+    int viterbiBatchWaitBlocks = 4;
+
+    // The decoder of a programme can be up to 16 logical frames (384 ms)
+    // behind the MSC. Beyond, DropNewest drops the new frame, and
+    // DropOldest the oldest frame not being decoded, which keeps the audio
+    // closer to live. Block lets the MSC thread wait for the decoder
+    // first, at most frameOverflowTimeoutMs per CIF for all programmes
+    // together, then drops the new frame. Meanwhile the symbols are kept
+    // in the queues before the MSC thread; the thread demodulating the
+    // signal never waits for a decoder.
+    FrameOverflowPolicy frameOverflowPolicy = FrameOverflowPolicy::DropNewest;
+    int frameOverflowTimeoutMs = 10;
 };
 
@@ -43,13 +43,15 @@ RadioReceiver::RadioReceiver(
                 RadioReceiverOptions rro,
                 int transmission_mode) :
     params(transmission_mode),
-    mscHandler(params, false),
-    ficHandler(rci),
+    milestones(rci),
+    mscHandler(params, false, milestones, rro),
+    ficHandler(rci, milestones, rro.ficDecimation),
     ofdmProcessor(input,
         params,
         rci,
         mscHandler,
         ficHandler,
+        milestones,
         rro)
 { }
 
@@ -125,6 +127,7 @@ bool RadioReceiver::playProgramme(ProgrammeHandlerInterface& handler,
 
                 if (sc.audioType() == AudioServiceComponentType::DAB ||
                     sc.audioType() == AudioServiceComponentType::DABPlus) {
+                    milestones.selectProgramme();
                     mscHandler.addSubchannel(
                             handler, sc.audioType(), dumpFileName, subch);
                     return true;
@@ -178,3 +181,48 @@ Subchannel RadioReceiver::getSubchannel(const ServiceComponent& sc) const
 {
     return ficHandler.fibProcessor.getSubchannel(sc);
 }
+
+symbol_pool_stats_t RadioReceiver::getSymbolPoolStats() const
+{
+    return ofdmProcessor.getSymbolPoolStats();
+}
+
+symbol_queue_stats_t RadioReceiver::getSymbolQueueStats() const
+{
+    return ofdmProcessor.getSymbolQueueStats();
+}
+
+decoder_pipeline_stats_t RadioReceiver::getDecoderPipelineStats() const
+{
+    return ofdmProcessor.getDecoderPipelineStats();
+}
+
+fic_decode_stats_t RadioReceiver::getFicDecodeStats() const
+{
+    return ficHandler.getDecodeStats();
+}
+
+std::vector<subchannel_decode_stats_t> RadioReceiver::getSubchannelDecodeStats() const
+{
+    return mscHandler.getDecodeStats();
+}
+
+decoder_pool_stats_t RadioReceiver::getDecoderPoolStats() const
+{
+    return mscHandler.getPoolStats();
+}
+
+decoder_switch_stats_t RadioReceiver::getDecoderSwitchStats() const
+{
+    return mscHandler.getSwitchStats();
+}
+
+ViterbiBatch::Stats RadioReceiver::getViterbiBatchStats() const
+{
+    return mscHandler.getBatchStats();
+}
+
+sync_milestones_t RadioReceiver::getSyncMilestones() const
+{
+    return milestones.get();
+}
@@ -40,6 +40,7 @@
 #include "fic-handler.h"
 #include "msc-handler.h"
 #include "ofdm-processor.h"
+#include "sync-milestones.h"
 
 class RadioReceiver {
     public:
@@ -83,6 +84,33 @@ class RadioReceiver {
          */
         Subchannel getSubchannel(const ServiceComponent& sc) const;
 
+        /* Statistics about the symbol buffers passed from the
+         * OFDM processor to the decoders */
+        symbol_pool_stats_t getSymbolPoolStats(void) const;
+
+        /* Overruns of the queue between the OFDM processor and the
+         * OFDM decoder */
+        symbol_queue_stats_t getSymbolQueueStats(void) const;
+
+        /* Queue depth and latency of the FIC and MSC decoding threads */
+        decoder_pipeline_stats_t getDecoderPipelineStats(void) const;
+
+        /* Number of FIC blocks decoded and skipped */
+        fic_decode_stats_t getFicDecodeStats(void) const;
+
+        /* Frames and CPU time of each subchannel being decoded, and
+         * work of the threads decoding them */
+        std::vector<subchannel_decode_stats_t> getSubchannelDecodeStats(void) const;
+        decoder_pool_stats_t getDecoderPoolStats(void) const;
+
+        /* Decoders built and reused when services are selected */
+        decoder_switch_stats_t getDecoderSwitchStats(void) const;
+        ViterbiBatch::Stats getViterbiBatchStats(void) const;
+
+        /* Time taken to reach each step of the acquisition since the
+         * last restart */
+        sync_milestones_t getSyncMilestones(void) const;
+
     private:
         bool playProgramme(ProgrammeHandlerInterface& handler,
                 const Service& s,
@@ -91,6 +119,9 @@ class RadioReceiver {
 
         DABParams params; // Defaults to TM1 parameters
 
+        // Declared before the handlers, which record the milestones
+        SyncMilestoneTracker milestones;
+
         MscHandler mscHandler;
         FicHandler ficHandler;
         OFDMProcessor ofdmProcessor;
@@ -0,0 +1,286 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "rs-syndromes.h"
+#include <algorithm>
+
+#if defined(SIMD_X86)
+#  include <immintrin.h>
+#endif
+#if defined(SIMD_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
+
+// Field generator polynomial of the DAB+ RS code, as given to init_rs_char
+#define GF_POLY 0x11D
+
+static const int NUM_ROOTS = RSSyndromes::NUM_ROOTS;
+static const int CODEWORD_LENGTH = RSSyndromes::CODEWORD_LENGTH;
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    uint16_t r = 0;
+    for (int i = 0; i < 8; i++) {
+        if (b & (1 << i)) {
+            r ^= a << i;
+        }
+    }
+    for (int i = 15; i >= 8; i--) {
+        if (r & (1 << i)) {
+            r ^= GF_POLY << (i - 8);
+        }
+    }
+    return r;
+}
+
+/* All kernels compute, for the codewords i of the superframe,
+ *   s[r][i] = sum over pos of rows[pos * stride + i] * alpha^(r * (119 - pos))
+ * as the loop s[r][i] = s[r][i] * alpha^r + rows[pos * stride + i], and
+ * write the OR of the NUM_ROOTS syndromes to errors[i]. The SIMD kernels
+ * handle whole blocks of lanes, the stride is a multiple of their width. */
+
+static void check_generic(const uint8_t *rows, size_t stride,
+        const uint8_t mulTable[NUM_ROOTS][256], uint8_t *s, uint8_t *errors)
+{
+    std::fill(s, s + NUM_ROOTS * stride, 0);
+
+    for (size_t pos = 0; pos < CODEWORD_LENGTH; pos++) {
+        const uint8_t *row = rows + pos * stride;
+        for (int r = 0; r < NUM_ROOTS; r++) {
+            uint8_t *sr = s + r * stride;
+            for (size_t i = 0; i < stride; i++) {
+                sr[i] = mulTable[r][sr[i]] ^ row[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < stride; i++) {
+        uint8_t e = 0;
+        for (int r = 0; r < NUM_ROOTS; r++) {
+            e |= s[r * stride + i];
+        }
+        errors[i] = e;
+    }
+}
+
+#if defined(SIMD_X86)
+// PSHUFB is not part of SSE2, this kernel is only used if the CPU has SSSE3
+SIMD_TARGET("ssse3")
+static void check_ssse3(const uint8_t *rows, size_t stride,
+        const uint8_t nibbleTable[NUM_ROOTS][2][16], uint8_t *errors)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i lo[NUM_ROOTS];
+    __m128i hi[NUM_ROOTS];
+    for (int r = 0; r < NUM_ROOTS; r++) {
+        lo[r] = _mm_loadu_si128((const __m128i *)nibbleTable[r][0]);
+        hi[r] = _mm_loadu_si128((const __m128i *)nibbleTable[r][1]);
+    }
+
+    for (size_t i = 0; i < stride; i += 16) {
+        __m128i s[NUM_ROOTS];
+        for (int r = 0; r < NUM_ROOTS; r++) {
+            s[r] = _mm_setzero_si128();
+        }
+
+        for (size_t pos = 0; pos < CODEWORD_LENGTH; pos++) {
+            const __m128i row = _mm_loadu_si128(
+                    (const __m128i *)(rows + pos * stride + i));
+            // alpha^0 = 1
+            s[0] = _mm_xor_si128(s[0], row);
+            for (int r = 1; r < NUM_ROOTS; r++) {
+                const __m128i l = _mm_and_si128(s[r], mask);
+                const __m128i h = _mm_and_si128(_mm_srli_epi16(s[r], 4), mask);
+                s[r] = _mm_xor_si128(row, _mm_xor_si128(
+                            _mm_shuffle_epi8(lo[r], l),
+                            _mm_shuffle_epi8(hi[r], h)));
+            }
+        }
+
+        __m128i e = s[0];
+        for (int r = 1; r < NUM_ROOTS; r++) {
+            e = _mm_or_si128(e, s[r]);
+        }
+        _mm_storeu_si128((__m128i *)(errors + i), e);
+    }
+}
+
+SIMD_TARGET("avx2")
+static void check_avx2(const uint8_t *rows, size_t stride,
+        const uint8_t nibbleTable[NUM_ROOTS][2][16], uint8_t *errors)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i lo[NUM_ROOTS];
+    __m256i hi[NUM_ROOTS];
+    for (int r = 0; r < NUM_ROOTS; r++) {
+        lo[r] = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i *)nibbleTable[r][0]));
+        hi[r] = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i *)nibbleTable[r][1]));
+    }
+
+    for (size_t i = 0; i < stride; i += 32) {
+        __m256i s[NUM_ROOTS];
+        for (int r = 0; r < NUM_ROOTS; r++) {
+            s[r] = _mm256_setzero_si256();
+        }
+
+        for (size_t pos = 0; pos < CODEWORD_LENGTH; pos++) {
+            const __m256i row = _mm256_loadu_si256(
+                    (const __m256i *)(rows + pos * stride + i));
+            s[0] = _mm256_xor_si256(s[0], row);
+            for (int r = 1; r < NUM_ROOTS; r++) {
+                const __m256i l = _mm256_and_si256(s[r], mask);
+                const __m256i h = _mm256_and_si256(
+                        _mm256_srli_epi16(s[r], 4), mask);
+                s[r] = _mm256_xor_si256(row, _mm256_xor_si256(
+                            _mm256_shuffle_epi8(lo[r], l),
+                            _mm256_shuffle_epi8(hi[r], h)));
+            }
+        }
+
+        __m256i e = s[0];
+        for (int r = 1; r < NUM_ROOTS; r++) {
+            e = _mm256_or_si256(e, s[r]);
+        }
+        _mm256_storeu_si256((__m256i *)(errors + i), e);
+    }
+}
+#endif
+
+#if defined(SIMD_NEON) && defined(__aarch64__)
+static void check_neon(const uint8_t *rows, size_t stride,
+        const uint8_t nibbleTable[NUM_ROOTS][2][16], uint8_t *errors)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    uint8x16_t lo[NUM_ROOTS];
+    uint8x16_t hi[NUM_ROOTS];
+    for (int r = 0; r < NUM_ROOTS; r++) {
+        lo[r] = vld1q_u8(nibbleTable[r][0]);
+        hi[r] = vld1q_u8(nibbleTable[r][1]);
+    }
+
+    for (size_t i = 0; i < stride; i += 16) {
+        uint8x16_t s[NUM_ROOTS];
+        for (int r = 0; r < NUM_ROOTS; r++) {
+            s[r] = vdupq_n_u8(0);
+        }
+
+        for (size_t pos = 0; pos < CODEWORD_LENGTH; pos++) {
+            const uint8x16_t row = vld1q_u8(rows + pos * stride + i);
+            s[0] = veorq_u8(s[0], row);
+            for (int r = 1; r < NUM_ROOTS; r++) {
+                s[r] = veorq_u8(row, veorq_u8(
+                            vqtbl1q_u8(lo[r], vandq_u8(s[r], mask)),
+                            vqtbl1q_u8(hi[r], vshrq_n_u8(s[r], 4))));
+            }
+        }
+
+        uint8x16_t e = s[0];
+        for (int r = 1; r < NUM_ROOTS; r++) {
+            e = vorrq_u8(e, s[r]);
+        }
+        vst1q_u8(errors + i, e);
+    }
+}
+#endif
+
+RSSyndromes::RSSyndromes(SimdLevel level) :
+    level(simdLevelSupported(level) ? level : SimdLevel::Generic)
+{
+    uint8_t root = 1;
+    for (int r = 0; r < NUM_ROOTS; r++) {
+        for (int x = 0; x < 256; x++) {
+            mulTable[r][x] = gf_mul(x, root);
+        }
+        for (int x = 0; x < 16; x++) {
+            nibbleTable[r][0][x] = gf_mul(x, root);
+            nibbleTable[r][1][x] = gf_mul(x << 4, root);
+        }
+        root = gf_mul(root, 2);
+    }
+
+    switch (this->level) {
+#if defined(SIMD_X86)
+        case SimdLevel::SSE2:
+            lanes = __builtin_cpu_supports("ssse3") ? 16 : 1;
+            break;
+        case SimdLevel::AVX2:
+            lanes = 32;
+            break;
+#endif
+#if defined(SIMD_NEON) && defined(__aarch64__)
+        case SimdLevel::NEON:
+            lanes = 16;
+            break;
+#endif
+        default:
+            lanes = 1;
+            break;
+    }
+}
+
+void RSSyndromes::check(const uint8_t *sf, size_t codewords, uint8_t *errors)
+{
+    // The codewords are padded to whole blocks of lanes with zeros,
+    // whose syndromes are zero
+    const size_t stride = (codewords + lanes - 1) / lanes * lanes;
+    const uint8_t *rows = sf;
+    uint8_t *e = errors;
+    if (stride != codewords) {
+        padded.assign(CODEWORD_LENGTH * stride, 0);
+        for (size_t pos = 0; pos < CODEWORD_LENGTH; pos++) {
+            std::copy(sf + pos * codewords, sf + (pos + 1) * codewords,
+                    padded.begin() + pos * stride);
+        }
+        rows = padded.data();
+        paddedErrors.resize(stride);
+        e = paddedErrors.data();
+    }
+
+    if (lanes == 1) {
+        syndromes.resize(NUM_ROOTS * stride);
+        check_generic(rows, stride, mulTable, syndromes.data(), e);
+    }
+    else {
+        switch (level) {
+#if defined(SIMD_X86)
+            case SimdLevel::SSE2:
+                check_ssse3(rows, stride, nibbleTable, e);
+                break;
+            case SimdLevel::AVX2:
+                check_avx2(rows, stride, nibbleTable, e);
+                break;
+#endif
+#if defined(SIMD_NEON) && defined(__aarch64__)
+            case SimdLevel::NEON:
+                check_neon(rows, stride, nibbleTable, e);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+
+    if (e != errors) {
+        std::copy(e, e + codewords, errors);
+    }
+}
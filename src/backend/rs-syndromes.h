@@ -0,0 +1,68 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __RS_SYNDROMES__
+#define __RS_SYNDROMES__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cpu_features.h"
+
+/* Syndromes of the RS(120, 110) codewords of a DAB+ superframe
+ * (EN 300 401 / TS 102 563), computed for all codewords at once.
+ *
+ * In the superframe, byte pos of codeword i is at pos * codewords + i,
+ * so that a row holds the same byte of all codewords. The syndromes are
+ * evaluated with Horner's scheme over the rows, one codeword per SIMD
+ * lane, the rows being padded to whole blocks of lanes. The
+ * multiplications by the roots of the generator polynomial are done with
+ * lookup tables, per nibble with a byte shuffle in the SIMD kernels. At
+ * the SSE2 level, the shuffle needs SSSE3.
+ *
+ * Only the codewords with a non-zero syndrome need the full decoder. */
+class RSSyndromes {
+    public:
+        static const int NUM_ROOTS = 10;
+        static const int CODEWORD_LENGTH = 120;
+
+        RSSyndromes(SimdLevel level = detectSimdLevel());
+
+        // Set errors[i] to a non-zero value if codeword i of the
+        // superframe sf has a non-zero syndrome, and to zero otherwise
+        void check(const uint8_t *sf, size_t codewords, uint8_t *errors);
+
+        SimdLevel getSimdLevel(void) const { return level; }
+
+    private:
+        SimdLevel level;
+        // Codewords handled together by the kernel
+        size_t lanes;
+
+        // Products of every byte with alpha^i, i < NUM_ROOTS
+        uint8_t mulTable[NUM_ROOTS][256];
+        // Products of the low and the high nibbles with alpha^i
+        uint8_t nibbleTable[NUM_ROOTS][2][16];
+        std::vector<uint8_t> syndromes;
+        std::vector<uint8_t> padded;
+        std::vector<uint8_t> paddedErrors;
+};
+
+#endif
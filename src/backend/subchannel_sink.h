@@ -71,6 +71,10 @@ public:
 	virtual ~SubchannelSink() {}
 
 	virtual void Feed(const uint8_t *data, size_t len) = 0;
+	// reliability of each byte, from a soft-output decoder; lower is less reliable
+	virtual void FeedWithReliability(const uint8_t *data, const uint8_t* /*reliability*/, size_t len) {Feed(data, len);}
+	// forget the data fed so far, to decode another subchannel of the same kind
+	virtual void Reset() = 0;
 	std::string GetUntouchedStreamFileExtension() {return untouched_stream_file_extension;}
 	void AddUntouchedStreamConsumer(UntouchedStreamConsumer* consumer) {
 		std::lock_guard<std::mutex> lock(uscs_mutex);
@@ -0,0 +1,138 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "symbol-buffer-pool.h"
+#include <utility>
+
+#define CACHE_LINE_SIZE 64
+
+SymbolBuffer::SymbolBuffer(const SymbolBuffer& other) :
+    slot(other.slot),
+    length(other.length)
+{
+    if (slot) {
+        slot->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SymbolBuffer::SymbolBuffer(SymbolBuffer&& other) noexcept :
+    slot(other.slot),
+    length(other.length)
+{
+    other.slot = nullptr;
+    other.length = 0;
+}
+
+SymbolBuffer& SymbolBuffer::operator=(const SymbolBuffer& other)
+{
+    if (slot != other.slot) {
+        release();
+        slot = other.slot;
+        length = other.length;
+        if (slot) {
+            slot->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return *this;
+}
+
+SymbolBuffer& SymbolBuffer::operator=(SymbolBuffer&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        std::swap(slot, other.slot);
+        std::swap(length, other.length);
+    }
+    return *this;
+}
+
+SymbolBuffer::~SymbolBuffer()
+{
+    release();
+}
+
+void SymbolBuffer::release()
+{
+    if (slot) {
+        // The last reader has to be done with the data before the
+        // slot can be handed out again.
+        if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1 and
+                slot->heapData) {
+            delete slot;
+        }
+        slot = nullptr;
+        length = 0;
+    }
+}
+
+SymbolBufferPool::SymbolBufferPool(size_t symbolLength, size_t numSlots) :
+    symbolLength(symbolLength),
+    numSlots(numSlots),
+    slots(new SymbolBuffer::Slot[numSlots])
+{
+    // Round the slots up to whole cache lines, so that two threads
+    // never write to the same line
+    const size_t lineSamples = CACHE_LINE_SIZE / sizeof(DSPCOMPLEX);
+    slotDistance = (symbolLength + lineSamples - 1) / lineSamples * lineSamples;
+
+    memory.resize(numSlots * slotDistance * sizeof(DSPCOMPLEX) +
+            CACHE_LINE_SIZE);
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory.data());
+    const uintptr_t aligned =
+        (base + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+
+    for (size_t i = 0; i < numSlots; i++) {
+        slots[i].data =
+            reinterpret_cast<DSPCOMPLEX*>(aligned) + i * slotDistance;
+    }
+}
+
+SymbolBuffer SymbolBufferPool::acquire()
+{
+    numAcquired.fetch_add(1, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < numSlots; i++) {
+        const size_t ix = (nextSlot + i) % numSlots;
+        int expected = 0;
+        if (slots[ix].refs.compare_exchange_strong(expected, 1,
+                    std::memory_order_acquire)) {
+            nextSlot = (ix + 1) % numSlots;
+            return SymbolBuffer(&slots[ix], symbolLength);
+        }
+    }
+
+    numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    auto slot = new SymbolBuffer::Slot;
+    slot->heapData.reset(new DSPCOMPLEX[symbolLength]);
+    slot->data = slot->heapData.get();
+    slot->refs = 1;
+    return SymbolBuffer(slot, symbolLength);
+}
+
+symbol_pool_stats_t SymbolBufferPool::getStats() const
+{
+    symbol_pool_stats_t stats;
+    stats.num_slots = numSlots;
+    stats.num_acquired = numAcquired.load(std::memory_order_relaxed);
+    stats.num_heap_allocations =
+        numHeapAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,115 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __SYMBOL_BUFFER_POOL__
+#define __SYMBOL_BUFFER_POOL__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "dab-constants.h"
+
+struct symbol_pool_stats_t {
+    size_t num_slots = 0;
+    // Number of buffers handed out by acquire()
+    uint64_t num_acquired = 0;
+    // Number of buffers that had to be allocated on the heap
+    // because all slots were still referenced
+    uint64_t num_heap_allocations = 0;
+};
+
+/* Reference-counted handle to one symbol buffer of a SymbolBufferPool.
+ * Copying the handle shares the buffer, the buffer goes back to the
+ * pool when the last handle referring to it is released. */
+class SymbolBuffer
+{
+    public:
+        SymbolBuffer() = default;
+        SymbolBuffer(const SymbolBuffer& other);
+        SymbolBuffer(SymbolBuffer&& other) noexcept;
+        SymbolBuffer& operator=(const SymbolBuffer& other);
+        SymbolBuffer& operator=(SymbolBuffer&& other) noexcept;
+        ~SymbolBuffer();
+
+        void release(void);
+
+        bool empty(void) const { return slot == nullptr; }
+        size_t size(void) const { return length; }
+        DSPCOMPLEX *data(void) const { return slot ? slot->data : nullptr; }
+        DSPCOMPLEX *begin(void) const { return data(); }
+        DSPCOMPLEX *end(void) const { return data() + length; }
+        DSPCOMPLEX& operator[](size_t i) const { return slot->data[i]; }
+
+    private:
+        friend class SymbolBufferPool;
+
+        struct Slot {
+            std::atomic<int> refs = ATOMIC_VAR_INIT(0);
+            DSPCOMPLEX *data = nullptr;
+            // Only set for buffers allocated outside of the pool
+            std::unique_ptr<DSPCOMPLEX[]> heapData;
+        };
+
+        SymbolBuffer(Slot *slot, size_t length) :
+            slot(slot), length(length) {}
+
+        Slot *slot = nullptr;
+        size_t length = 0;
+};
+
+/* Preallocated arena of symbol buffers that the OFDMProcessor fills
+ * and that the OfdmDecoder and the TIIDecoder read from, to avoid
+ * allocating and copying every symbol.
+ *
+ * All slots live in one contiguous, cache-line aligned block. Only one
+ * thread may call acquire(), handles can be released from any thread.
+ * If all slots are still referenced, acquire() falls back to a heap
+ * allocation, which is counted in the statistics.
+ *
+ * The pool must outlive all handles it gave out. */
+class SymbolBufferPool
+{
+    public:
+        SymbolBufferPool(size_t symbolLength, size_t numSlots);
+        SymbolBufferPool(const SymbolBufferPool& other) = delete;
+        SymbolBufferPool& operator=(const SymbolBufferPool& other) = delete;
+
+        SymbolBuffer acquire(void);
+
+        symbol_pool_stats_t getStats(void) const;
+
+        // Distance in samples between the start of two consecutive slots
+        size_t getSlotDistance(void) const { return slotDistance; }
+
+    private:
+        size_t symbolLength;
+        size_t numSlots;
+        size_t slotDistance;
+        std::vector<uint8_t> memory;
+        std::unique_ptr<SymbolBuffer::Slot[]> slots;
+        size_t nextSlot = 0;
+
+        std::atomic<uint64_t> numAcquired = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> numHeapAllocations = ATOMIC_VAR_INIT(0);
+};
+
+#endif
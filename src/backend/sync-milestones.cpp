@@ -0,0 +1,88 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <chrono>
+#include "sync-milestones.h"
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SyncMilestoneTracker::SyncMilestoneTracker(RadioControllerInterface& ri) :
+    radioInterface(ri)
+{
+    restart();
+}
+
+void SyncMilestoneTracker::restart()
+{
+    for (auto& t : times) {
+        t = 0;
+    }
+    origin = now_ns();
+}
+
+void SyncMilestoneTracker::selectProgramme()
+{
+    times[static_cast<size_t>(SyncMilestone::AudioSync)] = 0;
+    times[static_cast<size_t>(SyncMilestone::FirstAudio)] = 0;
+    times[static_cast<size_t>(SyncMilestone::ProgrammeSelected)] = 0;
+    record(SyncMilestone::ProgrammeSelected);
+}
+
+void SyncMilestoneTracker::reached(SyncMilestone m)
+{
+    // Most calls are for milestones that were already reached
+    if (times[static_cast<size_t>(m)].load(std::memory_order_relaxed) == 0) {
+        record(m);
+    }
+}
+
+void SyncMilestoneTracker::record(SyncMilestone m)
+{
+    int64_t expected = 0;
+    if (times[static_cast<size_t>(m)].compare_exchange_strong(
+                expected, now_ns())) {
+        radioInterface.onSyncMilestones(get());
+    }
+}
+
+sync_milestones_t SyncMilestoneTracker::get() const
+{
+    const int64_t t0 = origin;
+    auto ms = [&](SyncMilestone m) {
+        const int64_t t = times[static_cast<size_t>(m)];
+        return t == 0 ? -1.0 : (t - t0) / 1e6;
+    };
+
+    sync_milestones_t milestones;
+    milestones.null_detected = ms(SyncMilestone::NullDetected);
+    milestones.prs_locked = ms(SyncMilestone::PrsLocked);
+    milestones.coarse_corrected = ms(SyncMilestone::CoarseCorrected);
+    milestones.fib_crc_valid = ms(SyncMilestone::FibCrcValid);
+    milestones.ensemble_label = ms(SyncMilestone::EnsembleLabel);
+    milestones.programme_selected = ms(SyncMilestone::ProgrammeSelected);
+    milestones.audio_sync = ms(SyncMilestone::AudioSync);
+    milestones.first_audio = ms(SyncMilestone::FirstAudio);
+    return milestones;
+}
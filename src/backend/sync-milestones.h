@@ -0,0 +1,76 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __SYNC_MILESTONES__
+#define __SYNC_MILESTONES__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "radio-controller.h"
+
+enum class SyncMilestone {
+    NullDetected,       // End of a null symbol found
+    PrsLocked,          // Phase reference found by the correlation
+    CoarseCorrected,    // Coarse frequency search done
+    FibCrcValid,        // First FIB with a valid CRC
+    EnsembleLabel,      // Ensemble label decoded
+    ProgrammeSelected,  // Subchannel of a programme added
+    AudioSync,          // Audio frame (DAB) or superframe (DAB+) sync
+    FirstAudio,         // First PCM samples decoded
+};
+
+/* Records when the receiver reaches the milestones of the acquisition,
+ * on the monotonic clock, relative to the last restart.
+ *
+ * reached() can be called from any thread and for every frame, only
+ * the first call for each milestone is recorded and reported through
+ * RadioControllerInterface::onSyncMilestones. */
+class SyncMilestoneTracker
+{
+    public:
+        SyncMilestoneTracker(RadioControllerInterface& ri);
+        SyncMilestoneTracker(const SyncMilestoneTracker& other) = delete;
+        SyncMilestoneTracker& operator=(const SyncMilestoneTracker& other) = delete;
+
+        // Forget all milestones and count from now
+        void restart(void);
+
+        // Forget the audio milestones and record the ProgrammeSelected one
+        void selectProgramme(void);
+
+        void reached(SyncMilestone m);
+
+        sync_milestones_t get(void) const;
+
+    private:
+        void record(SyncMilestone m);
+
+        RadioControllerInterface& radioInterface;
+
+        static const size_t numMilestones =
+            static_cast<size_t>(SyncMilestone::FirstAudio) + 1;
+
+        // steady_clock times in ns, 0 for not reached
+        std::atomic<int64_t> origin = ATOMIC_VAR_INIT(0);
+        std::array<std::atomic<int64_t>, numMilestones> times;
+};
+
+#endif
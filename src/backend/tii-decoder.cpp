@@ -173,8 +173,8 @@ TIIDecoder::~TIIDecoder()
 }
 
 void TIIDecoder::pushSymbols(
-        const std::vector<complexf>& null,
-        const std::vector<complexf>& prs)
+        const SymbolBuffer& null,
+        const SymbolBuffer& prs)
 {
     unique_lock<mutex> lock(m_state_mutex);
     if (m_state == State::Idle) {
@@ -209,8 +209,8 @@ void TIIDecoder::run()
         // truncate
         size_t null_skip = nullsize - spacing;
 
-        if (m_null.size() != nullsize) {
-            throw out_of_range("NULL length: " + to_string(m_prs.size()) +
+        if (m_null.size() < nullsize) {
+            throw out_of_range("NULL length: " + to_string(m_null.size()) +
                     " vs " + to_string(nullsize));
         }
         copy(m_null.begin() + null_skip, m_null.begin() + null_skip + spacing,
@@ -225,6 +225,10 @@ void TIIDecoder::run()
         copy(m_prs.begin(), m_prs.begin() + spacing, m_fft_prs.getVector());
         m_fft_prs.do_FFT();
 
+        // Give the buffers back to the pool
+        m_null.release();
+        m_prs.release();
+
         /* In TM1, the carriers repeat four times:
          * [-768, -384[
          * [-384, 0[
@@ -312,7 +316,10 @@ void TIIDecoder::run()
         }
 
         lock.lock();
-        m_state = State::Idle;
+        // The destructor may have asked us to stop in the meantime
+        if (m_state == State::NullPrsReady) {
+            m_state = State::Idle;
+        }
         lock.unlock();
     }
 }
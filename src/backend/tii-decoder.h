@@ -29,6 +29,7 @@
 #include <condition_variable>
 #include <complex>
 #include "fft.h"
+#include "symbol-buffer-pool.h"
 #include "radio-controller.h"
 
 using complexf = std::complex<float>;
@@ -69,8 +70,8 @@ class TIIDecoder {
         TIIDecoder& operator=(const TIIDecoder& other) = delete;
 
         void pushSymbols(
-                const std::vector<complexf>& null,
-                const std::vector<complexf>& prs);
+                const SymbolBuffer& null,
+                const SymbolBuffer& prs);
 
     private:
         void run(void);
@@ -79,8 +80,8 @@ class TIIDecoder {
         RadioControllerInterface& m_radioInterface;
         const DABParams& m_params;
 
-        std::vector<complexf> m_null;
-        std::vector<complexf> m_prs;
+        SymbolBuffer m_null;
+        SymbolBuffer m_prs;
 
         std::unordered_map<carrier_t, std::unordered_set<CombPattern> >
             m_cp_per_carrier;
@@ -0,0 +1,74 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "time-deinterleaver.h"
+#include <stdexcept>
+
+//  Bit i of a CIF was sent interleaveMap[i % 16] CIFs after the
+//  other bits of its logical frame
+static const int interleaveMap[16] = {
+    0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+TimeDeinterleaver::TimeDeinterleaver(int32_t cifBits) :
+    cifBits(cifBits),
+    history(NUM_CIFS * cifBits)
+{
+}
+
+int16_t *TimeDeinterleaver::currentCif()
+{
+    return &history[current * cifBits];
+}
+
+void TimeDeinterleaver::push()
+{
+    current = (current + 1) % NUM_CIFS;
+    if (numCifs < NUM_CIFS) {
+        numCifs++;
+    }
+}
+
+void TimeDeinterleaver::deinterleave(int32_t start, int32_t length,
+        int16_t *out) const
+{
+    if (start % 16 != 0 or start + length > cifBits) {
+        throw std::logic_error("Invalid range for the time de-interleaver");
+    }
+
+    //  The bits of the frame completed by the current CIF that were
+    //  sent with a delay d are in the CIF received 15 - d CIFs before it
+    const int16_t *cif[16];
+    for (int r = 0; r < 16; r++) {
+        const int age = NUM_CIFS - 1 - interleaveMap[r];
+        cif[r] = &history[((current + NUM_CIFS - age) % NUM_CIFS) * cifBits +
+            start];
+    }
+
+    for (int32_t i = 0; i < length; i++) {
+        out[i] = cif[i % 16][i];
+    }
+}
+
+void TimeDeinterleaver::reset()
+{
+    current = 0;
+    numCifs = 0;
+}
@@ -0,0 +1,75 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __TIME_DEINTERLEAVER__
+#define __TIME_DEINTERLEAVER__
+
+#include <cstdint>
+#include <vector>
+
+/* Time de-interleaver of the whole MSC, according to the DAB standard
+ * section 12.
+ *
+ * The soft bits of the last 16 CIFs are kept once for all subchannels.
+ * The memory does not depend on the number of subchannels, and a
+ * subchannel selected later gets its first frame in the next CIF.
+ *
+ * The logical frame completed by the CIF being received only needs the
+ * bits of the subchannel in that CIF, the other 15 CIFs are already
+ * there. It can be read as soon as these bits are written, before the
+ * end of the CIF. */
+class TimeDeinterleaver
+{
+    public:
+        static const int NUM_CIFS = 16;
+
+        TimeDeinterleaver(int32_t cifBits);
+        TimeDeinterleaver(const TimeDeinterleaver& other) = delete;
+        TimeDeinterleaver& operator=(const TimeDeinterleaver& other) = delete;
+
+        // The buffer for the soft bits of the CIF being received
+        int16_t *currentCif(void);
+
+        // The CIF in currentCif() is complete, the next one is received
+        void push(void);
+
+        // Once the 15 CIFs before the current one were received, the
+        // logical frames are complete
+        bool isFilled(void) const { return numCifs >= NUM_CIFS - 1; }
+
+        // The bits [start, start + length) of the logical frame completed
+        // by the current CIF, whose bits in that range must be written.
+        // start must be a multiple of 16.
+        void deinterleave(int32_t start, int32_t length, int16_t *out) const;
+
+        // Forget the CIFs received so far
+        void reset(void);
+
+    private:
+        int32_t cifBits;
+        // NUM_CIFS CIFs of cifBits soft bits
+        std::vector<int16_t> history;
+        // Index of the CIF being received
+        int current = 0;
+        // Complete CIFs before the current one
+        int numCifs = 0;
+};
+
+#endif
@@ -20,6 +20,9 @@
  *
  *  The deconvolution for both uep and eep
  */
+#include    <map>
+#include    <mutex>
+#include    <utility>
 #include    "dab-constants.h"
 #include    "uep-protection.h"
 #include    "protTables.h"
@@ -144,97 +147,82 @@ UEPProtection::UEPProtection(
         int16_t bitRate,
         int16_t protLevel) :
     Viterbi(24 * bitRate),
-    outSize(24 * bitRate),
-    viterbiBlock(outSize * 4 + 24)
+    schedule(getSchedule(bitRate, protLevel))
 {
+}
+
+// The schedules of all UEP handlers, by bitrate and protection level.
+// The entries are never removed, the handlers keep references to them.
+static std::mutex schedulesMutex;
+static std::map<std::pair<int16_t, int16_t>, PunctureSchedule> schedules;
+
+static const PunctureSchedule& buildSchedule(
+        int16_t bitRate,
+        int16_t protLevel)
+{
+    const auto key = std::make_pair(bitRate, protLevel);
+    auto it = schedules.find(key);
+    if (it != schedules.end()) {
+        return it->second;
+    }
+
     int16_t index = findIndex (bitRate, protLevel);
     if (index == -1) {
         fprintf(stderr, "UEP: %d (%d) has a problem\n", bitRate, protLevel);
         index = 1;
     }
-    L1  = profileTable[index].L1;
-    L2  = profileTable[index].L2;
-    L3  = profileTable[index].L3;
-    L4  = profileTable[index].L4;
-
-    PI1 = getPCodes(profileTable[index].PI1 -1);
-    PI2 = getPCodes(profileTable[index].PI2 -1);
-    PI3 = getPCodes(profileTable[index].PI3 -1);
-    if ((profileTable[index].PI4 - 1) != -1)
-        PI4 = getPCodes(profileTable[index].PI4 -1);
-    else
-        PI4 = nullptr;
-}
 
-bool UEPProtection::deconvolve(int16_t *v, int32_t size, uint8_t *outBuffer)
-{
-    int16_t i, j;
-    int16_t inputCounter    = 0;
-    int32_t viterbiCounter  = 0;
-    (void)size;         // currently unused
+    PunctureSchedule& schedule = schedules[key];
 
     //  according to the standard we process the logical frame
     //  with a pair of tuples
     //  (L1, PI1), (L2, PI2), (L3, PI3), (L4, PI4)
-
-    /// clear the bits in the viterbiBlock,
-    /// only the non-punctured ones are set
-    memset (viterbiBlock.data(), 0, (outSize * 4 + 24) * sizeof (int16_t));
-
-    for (i = 0; i < L1; i ++) {
-        for (j = 0; j < 128; j ++) {
-            if (PI1[j % 32] != 0) {
-                viterbiBlock[viterbiCounter] = v[inputCounter ++];
-            }
-            viterbiCounter++;
-        }
-    }
-
-    for (i = 0; i < L2; i ++) {
-        for (j = 0; j < 128; j ++) {
-            if (PI2[j % 32] != 0) {
-                viterbiBlock[viterbiCounter] = v[inputCounter ++];
-            }
-            viterbiCounter++;
-        }
-    }
-
-    for (i = 0; i < L3; i ++) {
-        for (j = 0; j < 128; j ++) {
-            if (PI3[j % 32] != 0) {
-                viterbiBlock[viterbiCounter] = v[inputCounter ++];
-            }
-            viterbiCounter++;
-        }
-    }
-
-    for (i = 0; i < L4; i ++) {
-        if (PI4 == nullptr) {
+    const auto& profile = profileTable[index];
+    schedule.addBlocks(profile.L1, getPCodes(profile.PI1 - 1));
+    schedule.addBlocks(profile.L2, getPCodes(profile.PI2 - 1));
+    schedule.addBlocks(profile.L3, getPCodes(profile.PI3 - 1));
+    if (profile.L4 > 0) {
+        if (profile.PI4 == -1) {
             throw std::logic_error("Invalid usage of NULL PI4");
         }
-
-        for (j = 0; j < 128; j ++) {
-            if (PI4[j % 32] != 0) {
-                viterbiBlock[viterbiCounter] = v[inputCounter ++];
-            }
-            viterbiCounter++;
-        }
+        schedule.addBlocks(profile.L4, getPCodes(profile.PI4 - 1));
     }
 
     /**
      * we have a final block of 24 bits  with puncturing according to PI_X
      * This block constitues the 6 * 4 bits of the register itself.
      */
-    for (i = 0; i < 24; i ++) {
-        if (PI_X[i] != 0) {
-            viterbiBlock[viterbiCounter] = v[inputCounter ++];
-        }
-        viterbiCounter++;
+    schedule.addTail(PI_X);
+
+    // Only changes anything with the fallback profile, which does not
+    // match the length of the frame
+    schedule.resize(4 * 24 * bitRate + 24);
+    return schedule;
+}
+
+const PunctureSchedule& UEPProtection::getSchedule(
+        int16_t bitRate,
+        int16_t protLevel)
+{
+    std::lock_guard<std::mutex> lock(schedulesMutex);
+    return buildSchedule(bitRate, protLevel);
+}
+
+void UEPProtection::buildAllSchedules()
+{
+    std::lock_guard<std::mutex> lock(schedulesMutex);
+    for (int i = 0; profileTable[i].bitRate != 0; i++) {
+        buildSchedule(profileTable[i].bitRate, profileTable[i].protLevel);
     }
+}
+
+bool UEPProtection::deconvolve(int16_t *v, int32_t size, uint8_t *outBuffer)
+{
+    (void)size;         // currently unused
 
     /// The actual deconvolution is done by the viterbi decoder
 
-    Viterbi::deconvolve(viterbiBlock.data(), outBuffer);
+    Viterbi::deconvolve(v, schedule, outBuffer);
     return true;
 }
 
@@ -33,17 +33,17 @@ class UEPProtection: public Protection, public Viterbi
     public:
         UEPProtection(int16_t bitRate, int16_t protLevel);
         bool deconvolve(int16_t *v, int32_t size, uint8_t *outBuffer);
+
+        // The schedule of the (L1, PI1) .. (L4, PI4) profile, built on the
+        // first use and shared by all handlers with the same settings
+        static const PunctureSchedule& getSchedule(int16_t bitRate,
+                int16_t protLevel);
+
+        // Build the schedules of all profiles of the table in advance,
+        // so that selecting a service does not need to
+        static void buildAllSchedules(void);
     private:
-        int16_t L1;
-        int16_t L2;
-        int16_t L3;
-        int16_t L4;
-        const int8_t *PI1;
-        const int8_t *PI2;
-        const int8_t *PI3;
-        const int8_t *PI4;
-        int32_t outSize;
-        std::vector<int16_t> viterbiBlock;
+        const PunctureSchedule& schedule;
 };
 
 #endif
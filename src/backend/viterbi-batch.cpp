@@ -0,0 +1,494 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "viterbi-batch.h"
+#include <algorithm>
+
+#if defined(SIMD_X86)
+#  include <immintrin.h>
+#endif
+#if defined(SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
+// Constraint length of the DAB convolutional code
+#define K 7
+#define METRIC_MAX (RATE * 255)
+// The metric of state 0 is subtracted from all metrics every
+// RENORMALIZE_BITS bits. Between two renormalisations the metrics grow by
+// at most RENORMALIZE_BITS * METRIC_MAX, on top of the spread of at most
+// 6 * METRIC_MAX, which stays below the 16-bit limit.
+#define RENORMALIZE_BITS 16
+// Lanes of the widest kernel
+#define MAX_LANES 16
+
+/* The kernels update the path metrics of all lanes for nsteps bits.
+ *
+ * Butterfly i reads states i and i + 32 and writes states 2i and 2i + 1,
+ * as in the Viterbi class. Its branch metric is the sum over the RATE
+ * symbols of either s or 255 - s, depending on the branch table bits,
+ * whose pattern is given in patterns[i]. The metric of the complementary
+ * pattern is METRIC_MAX minus that. The metrics of the 16 patterns are
+ * therefore computed once per bit for all butterflies.
+ *
+ * The soft bits in syms are clipped to 0..255 after adding 127, as in
+ * Viterbi::deconvolve.
+ *
+ * The decisions of butterfly i are packed in a 32-bit word, with the
+ * decision for state 2i + b of lane l at bit
+ *   (l % 8) + 8 * b + 16 * (l / 8)
+ * which is the order the SSE2 and AVX2 pack instructions give. */
+static inline int decision_bit(int lane, int b)
+{
+    return (lane % 8) + 8 * b + 16 * (lane / 8);
+}
+
+#if defined(SIMD_X86)
+SIMD_TARGET("sse2")
+static void update_batch_sse2(const int16_t *syms, int32_t nsteps,
+        const uint8_t *patterns, uint32_t *dec)
+{
+    const int lanes = 8;
+    __m128i metrics[2][NUMSTATES];
+    for (int i = 0; i < NUMSTATES; i++) {
+        metrics[0][i] = _mm_set1_epi16(i == 0 ? 0 : 63);
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i s127 = _mm_set1_epi16(127);
+    const __m128i s255 = _mm_set1_epi16(255);
+    for (int32_t s = 0; s < nsteps; s++) {
+        const __m128i *old_m = metrics[s % 2];
+        __m128i *new_m = metrics[(s + 1) % 2];
+
+        __m128i sym[RATE], inv[RATE];
+        for (int j = 0; j < RATE; j++) {
+            sym[j] = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(
+                            _mm_loadu_si128((const __m128i*)(
+                                    syms + (s * RATE + j) * lanes)),
+                            s127), zero), s255);
+            inv[j] = _mm_sub_epi16(s255, sym[j]);
+        }
+
+        __m128i t01[4], t23[4], bm[16];
+        for (int p = 0; p < 4; p++) {
+            t01[p] = _mm_add_epi16(p & 1 ? inv[0] : sym[0],
+                    p & 2 ? inv[1] : sym[1]);
+            t23[p] = _mm_add_epi16(p & 1 ? inv[2] : sym[2],
+                    p & 2 ? inv[3] : sym[3]);
+        }
+        for (int p = 0; p < 16; p++) {
+            bm[p] = _mm_add_epi16(t01[p & 3], t23[p >> 2]);
+        }
+
+        for (int i = 0; i < NUMSTATES / 2; i++) {
+            const __m128i metric = bm[patterns[i]];
+            const __m128i inv_metric = bm[patterns[i] ^ 15];
+
+            const __m128i m0 = _mm_adds_epi16(old_m[i], metric);
+            const __m128i m1 = _mm_adds_epi16(old_m[i + 32], inv_metric);
+            const __m128i m2 = _mm_adds_epi16(old_m[i], inv_metric);
+            const __m128i m3 = _mm_adds_epi16(old_m[i + 32], metric);
+
+            const __m128i dec0 = _mm_cmpgt_epi16(m0, m1);
+            const __m128i dec1 = _mm_cmpgt_epi16(m2, m3);
+            new_m[2 * i] = _mm_min_epi16(m0, m1);
+            new_m[2 * i + 1] = _mm_min_epi16(m2, m3);
+            dec[s * NUMSTATES / 2 + i] =
+                _mm_movemask_epi8(_mm_packs_epi16(dec0, dec1));
+        }
+
+        if (s % RENORMALIZE_BITS == RENORMALIZE_BITS - 1) {
+            const __m128i norm = new_m[0];
+            for (int i = 0; i < NUMSTATES; i++) {
+                new_m[i] = _mm_sub_epi16(new_m[i], norm);
+            }
+        }
+    }
+}
+
+SIMD_TARGET("avx2")
+static void update_batch_avx2(const int16_t *syms, int32_t nsteps,
+        const uint8_t *patterns, uint32_t *dec)
+{
+    const int lanes = 16;
+    __m256i metrics[2][NUMSTATES];
+    for (int i = 0; i < NUMSTATES; i++) {
+        metrics[0][i] = _mm256_set1_epi16(i == 0 ? 0 : 63);
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i s127 = _mm256_set1_epi16(127);
+    const __m256i s255 = _mm256_set1_epi16(255);
+    for (int32_t s = 0; s < nsteps; s++) {
+        const __m256i *old_m = metrics[s % 2];
+        __m256i *new_m = metrics[(s + 1) % 2];
+
+        __m256i sym[RATE], inv[RATE];
+        for (int j = 0; j < RATE; j++) {
+            sym[j] = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(
+                            _mm256_loadu_si256((const __m256i*)(
+                                    syms + (s * RATE + j) * lanes)),
+                            s127), zero), s255);
+            inv[j] = _mm256_sub_epi16(s255, sym[j]);
+        }
+
+        __m256i t01[4], t23[4], bm[16];
+        for (int p = 0; p < 4; p++) {
+            t01[p] = _mm256_add_epi16(p & 1 ? inv[0] : sym[0],
+                    p & 2 ? inv[1] : sym[1]);
+            t23[p] = _mm256_add_epi16(p & 1 ? inv[2] : sym[2],
+                    p & 2 ? inv[3] : sym[3]);
+        }
+        for (int p = 0; p < 16; p++) {
+            bm[p] = _mm256_add_epi16(t01[p & 3], t23[p >> 2]);
+        }
+
+        for (int i = 0; i < NUMSTATES / 2; i++) {
+            const __m256i metric = bm[patterns[i]];
+            const __m256i inv_metric = bm[patterns[i] ^ 15];
+
+            const __m256i m0 = _mm256_adds_epi16(old_m[i], metric);
+            const __m256i m1 = _mm256_adds_epi16(old_m[i + 32], inv_metric);
+            const __m256i m2 = _mm256_adds_epi16(old_m[i], inv_metric);
+            const __m256i m3 = _mm256_adds_epi16(old_m[i + 32], metric);
+
+            const __m256i dec0 = _mm256_cmpgt_epi16(m0, m1);
+            const __m256i dec1 = _mm256_cmpgt_epi16(m2, m3);
+            new_m[2 * i] = _mm256_min_epi16(m0, m1);
+            new_m[2 * i + 1] = _mm256_min_epi16(m2, m3);
+            dec[s * NUMSTATES / 2 + i] =
+                _mm256_movemask_epi8(_mm256_packs_epi16(dec0, dec1));
+        }
+
+        if (s % RENORMALIZE_BITS == RENORMALIZE_BITS - 1) {
+            const __m256i norm = new_m[0];
+            for (int i = 0; i < NUMSTATES; i++) {
+                new_m[i] = _mm256_sub_epi16(new_m[i], norm);
+            }
+        }
+    }
+}
+#endif
+
+#if defined(SIMD_NEON)
+static void update_batch_neon(const int16_t *syms, int32_t nsteps,
+        const uint8_t *patterns, uint32_t *dec)
+{
+    const int lanes = 8;
+    int16x8_t metrics[2][NUMSTATES];
+    for (int i = 0; i < NUMSTATES; i++) {
+        metrics[0][i] = vdupq_n_s16(i == 0 ? 0 : 63);
+    }
+
+    const uint8_t weights[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t bit_weights = vld1q_u8(weights);
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t s127 = vdupq_n_s16(127);
+    const int16x8_t s255 = vdupq_n_s16(255);
+    for (int32_t s = 0; s < nsteps; s++) {
+        const int16x8_t *old_m = metrics[s % 2];
+        int16x8_t *new_m = metrics[(s + 1) % 2];
+
+        int16x8_t sym[RATE], inv[RATE];
+        for (int j = 0; j < RATE; j++) {
+            sym[j] = vminq_s16(vmaxq_s16(vaddq_s16(
+                            vld1q_s16(syms + (s * RATE + j) * lanes),
+                            s127), zero), s255);
+            inv[j] = vsubq_s16(s255, sym[j]);
+        }
+
+        int16x8_t t01[4], t23[4], bm[16];
+        for (int p = 0; p < 4; p++) {
+            t01[p] = vaddq_s16(p & 1 ? inv[0] : sym[0],
+                    p & 2 ? inv[1] : sym[1]);
+            t23[p] = vaddq_s16(p & 1 ? inv[2] : sym[2],
+                    p & 2 ? inv[3] : sym[3]);
+        }
+        for (int p = 0; p < 16; p++) {
+            bm[p] = vaddq_s16(t01[p & 3], t23[p >> 2]);
+        }
+
+        for (int i = 0; i < NUMSTATES / 2; i++) {
+            const int16x8_t metric = bm[patterns[i]];
+            const int16x8_t inv_metric = bm[patterns[i] ^ 15];
+
+            const int16x8_t m0 = vqaddq_s16(old_m[i], metric);
+            const int16x8_t m1 = vqaddq_s16(old_m[i + 32], inv_metric);
+            const int16x8_t m2 = vqaddq_s16(old_m[i], inv_metric);
+            const int16x8_t m3 = vqaddq_s16(old_m[i + 32], metric);
+
+            new_m[2 * i] = vminq_s16(m0, m1);
+            new_m[2 * i + 1] = vminq_s16(m2, m3);
+
+            // NEON has no movemask, weight the bytes of the decision
+            // masks and add them up instead
+            const uint8x16_t mask = vandq_u8(bit_weights, vcombine_u8(
+                        vmovn_u16(vcgtq_s16(m0, m1)),
+                        vmovn_u16(vcgtq_s16(m2, m3))));
+            const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(mask)));
+            dec[s * NUMSTATES / 2 + i] = (uint32_t)(vgetq_lane_u64(sum, 0) |
+                    (vgetq_lane_u64(sum, 1) << 8));
+        }
+
+        if (s % RENORMALIZE_BITS == RENORMALIZE_BITS - 1) {
+            const int16x8_t norm = new_m[0];
+            for (int i = 0; i < NUMSTATES; i++) {
+                new_m[i] = vsubq_s16(new_m[i], norm);
+            }
+        }
+    }
+}
+#endif
+
+ViterbiBatch::ViterbiBatch(SimdLevel level) :
+    level(simdLevelSupported(level) ? level : SimdLevel::Generic)
+{
+}
+
+size_t ViterbiBatch::numLanes() const
+{
+    switch (level) {
+        case SimdLevel::SSE2: return 8;
+        case SimdLevel::AVX2: return 16;
+        case SimdLevel::NEON: return 8;
+        default: return 1;
+    }
+}
+
+void ViterbiBatch::decodeFrames(const ViterbiFrame *frames, size_t num)
+{
+    std::vector<ViterbiFrame> sorted(frames, frames + num);
+    std::stable_sort(sorted.begin(), sorted.end(),
+            [](const ViterbiFrame& a, const ViterbiFrame& b) {
+                return a.viterbi->frameBits > b.viterbi->frameBits; });
+
+    const size_t lanes = numLanes();
+    for (size_t first = 0; first < num; first += lanes) {
+        const ViterbiFrame *f = sorted.data() + first;
+        const size_t n = std::min(lanes, num - first);
+        if (worthBatching(f, n)) {
+            decodePass(f, n);
+        }
+        else {
+            for (size_t i = 0; i < n; i++) {
+                f[i].viterbi->decode(f[i].input, f[i].schedule, f[i].output);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (worthBatching(f, n)) {
+            stats.frames += n;
+            stats.passes++;
+        }
+        else {
+            stats.alone += n;
+        }
+    }
+}
+
+bool ViterbiBatch::worthBatching(const ViterbiFrame *frames, size_t num) const
+{
+    std::vector<int32_t> frameBits;
+    for (size_t n = 0; n < num; n++) {
+        frameBits.push_back(frames[n].viterbi->frameBits);
+    }
+    return worthBatching(frameBits.data(), num);
+}
+
+bool ViterbiBatch::worthBatching(const int32_t *frameBits, size_t num) const
+{
+    int32_t maxBits = 0;
+    int32_t totalBits = 0;
+    for (size_t n = 0; n < num; n++) {
+        maxBits = std::max(maxBits, frameBits[n]);
+        totalBits += frameBits[n];
+    }
+    return num > 1 and 2 * totalBits >= (int32_t)numLanes() * maxBits;
+}
+
+void ViterbiBatch::countAlone(size_t num)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.alone += num;
+}
+
+void ViterbiBatch::decodePass(const ViterbiFrame *frames, size_t num)
+{
+    const int lanes = numLanes();
+    int16_t maxBits = 0;
+    for (size_t n = 0; n < num; n++) {
+        maxBits = std::max(maxBits, frames[n].viterbi->frameBits);
+    }
+    const int32_t nsteps = maxBits + (K - 1);
+
+    std::unique_ptr<Buffers> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        if (freeBuffers.empty()) {
+            buffers = std::make_unique<Buffers>();
+        }
+        else {
+            buffers = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+
+    auto& symbols = buffers->symbols;
+    auto& decisions = buffers->decisions;
+    symbols.resize(nsteps * RATE * lanes);
+    decisions.resize(nsteps * NUMSTATES / 2);
+
+    // Interleave the soft bits of the lanes, the kernels clip them as
+    // Viterbi::deconvolve does. The padding of the shorter frames and the
+    // unused lanes is never traced back.
+    const int16_t *in[MAX_LANES];
+    int32_t len[MAX_LANES];
+    int32_t minLen = nsteps * RATE;
+    bool punctured = false;
+    for (int l = 0; l < lanes; l++) {
+        // The unused lanes decode a copy of the first frame
+        const auto& f = frames[l < (int)num ? l : 0];
+        in[l] = f.input;
+        len[l] = (f.viterbi->frameBits + (K - 1)) * RATE;
+        minLen = std::min(minLen, len[l]);
+        punctured |= (f.schedule != nullptr);
+    }
+
+    if (punctured) {
+        // Depuncture each frame into its lane, a punctured bit is
+        // a soft bit of 0
+        for (int l = 0; l < lanes; l++) {
+            const auto& f = frames[l < (int)num ? l : 0];
+            const int16_t *src = in[l];
+            int16_t *sym = &symbols[l];
+            if (f.schedule) {
+                for (const auto& run : f.schedule->getRuns()) {
+                    for (int32_t j = 0; j < run.kept; j++, sym += lanes) {
+                        *sym = *src++;
+                    }
+                    for (int32_t j = 0; j < run.punctured; j++, sym += lanes) {
+                        *sym = 0;
+                    }
+                }
+            }
+            else {
+                for (int32_t t = 0; t < len[l]; t++, sym += lanes) {
+                    *sym = src[t];
+                }
+            }
+            for (int32_t t = len[l]; t < nsteps * RATE; t++, sym += lanes) {
+                *sym = 0;
+            }
+        }
+    }
+    else {
+        // Writing the symbols in order is faster than reading the frames
+        // one after the other
+        for (int32_t t = 0; t < minLen; t++) {
+            int16_t *sym = &symbols[t * lanes];
+            for (int l = 0; l < lanes; l++) {
+                sym[l] = in[l][t];
+            }
+        }
+        for (int32_t t = minLen; t < nsteps * RATE; t++) {
+            int16_t *sym = &symbols[t * lanes];
+            for (int l = 0; l < lanes; l++) {
+                sym[l] = t < len[l] ? in[l][t] : 0;
+            }
+        }
+    }
+
+    // All decoders share the same code, take the branch table of the first
+    uint8_t patterns[NUMSTATES / 2];
+    const COMPUTETYPE *branchtab = frames[0].viterbi->Branchtab;
+    for (int i = 0; i < NUMSTATES / 2; i++) {
+        patterns[i] = 0;
+        for (int j = 0; j < RATE; j++) {
+            if (branchtab[j * NUMSTATES / 2 + i]) {
+                patterns[i] |= 1 << j;
+            }
+        }
+    }
+
+    switch (level) {
+#if defined(SIMD_X86)
+        case SimdLevel::SSE2:
+            update_batch_sse2(symbols.data(), nsteps, patterns,
+                    decisions.data());
+            break;
+        case SimdLevel::AVX2:
+            update_batch_avx2(symbols.data(), nsteps, patterns,
+                    decisions.data());
+            break;
+#endif
+#if defined(SIMD_NEON)
+        case SimdLevel::NEON:
+            update_batch_neon(symbols.data(), nsteps, patterns,
+                    decisions.data());
+            break;
+#endif
+        default:
+            break;
+    }
+
+    // Chainback as in Viterbi::chainback_viterbi, from state 0 at the end
+    // of the frame of each lane. The decision for bit b is the decoded
+    // bit b, and it is shifted in as the most significant bit of the
+    // state, and of the byte being packed. All lanes go back together,
+    // so that the decisions of a bit are read from memory only once.
+    uint32_t state[MAX_LANES] = {};
+    uint8_t byte[MAX_LANES] = {};
+    int shift[MAX_LANES][2];
+    int16_t nbits[MAX_LANES];
+    int16_t minBits = maxBits;
+    for (size_t l = 0; l < num; l++) {
+        shift[l][0] = decision_bit(l, 0);
+        shift[l][1] = decision_bit(l, 1);
+        nbits[l] = frames[l].viterbi->frameBits;
+        minBits = std::min(minBits, nbits[l]);
+    }
+
+    for (int32_t b = maxBits - 1; b >= 0; b--) {
+        const uint32_t *d = &decisions[(b + (K - 1)) * NUMSTATES / 2];
+        for (size_t l = 0; l < num; l++) {
+            if (b < minBits or b < nbits[l]) {
+                const uint32_t s = state[l];
+                const uint32_t k = (d[s / 2] >> shift[l][s & 1]) & 1;
+                state[l] = (s >> 1) | (k << (K - 2));
+                byte[l] = (byte[l] >> 1) | (k << 7);
+                if ((b & 7) == 0) {
+                    frames[l].output[b >> 3] = byte[l];
+                }
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    freeBuffers.push_back(std::move(buffers));
+}
+
+ViterbiBatch::Stats ViterbiBatch::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
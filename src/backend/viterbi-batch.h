@@ -0,0 +1,111 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __VITERBI_BATCH__
+#define __VITERBI_BATCH__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "viterbi.h"
+#include "cpu_features.h"
+
+struct ViterbiFrame {
+    // Decoder of the stream, gives the frame length, and decodes
+    // the frame when it is alone in its batch
+    Viterbi *viterbi = nullptr;
+    const int16_t *input = nullptr;
+    // If given, input holds only the transmitted bits
+    const PunctureSchedule *schedule = nullptr;
+    // Packed decoded bits, as written by Viterbi::deconvolve
+    uint8_t *output = nullptr;
+};
+
+/* Viterbi decoder for the frames of several streams at once.
+ *
+ * Each SIMD lane holds the trellis of a different frame, so that all
+ * subchannels of a CIF are decoded in one pass. The frames do not need
+ * to have the same length, the shorter ones are padded, and each lane is
+ * traced back from the end of its own frame. The decoded bits are the
+ * same as with a Viterbi decoding the frame alone.
+ *
+ * A pass over all lanes costs about as much as decoding half as many
+ * frames alone. When the frames would fill less than half of the lanes,
+ * they are decoded one by one with the per-frame kernel instead.
+ *
+ * The MscHandler collects the frames of the subchannels of a CIF and
+ * gives them to decodeFrames(). */
+class ViterbiBatch
+{
+    public:
+        ViterbiBatch(SimdLevel level = detectSimdLevel());
+        ViterbiBatch(const ViterbiBatch& other) = delete;
+        ViterbiBatch& operator=(const ViterbiBatch& other) = delete;
+
+        SimdLevel getSimdLevel(void) const { return level; }
+
+        // Number of frames decoded in one pass
+        size_t numLanes(void) const;
+
+        // Decode the frames on the calling thread, in passes of frames
+        // of similar length
+        void decodeFrames(const ViterbiFrame *frames, size_t num);
+
+        // True if a pass over the frames costs less than decoding them
+        // one by one
+        bool worthBatching(const ViterbiFrame *frames, size_t num) const;
+        bool worthBatching(const int32_t *frameBits, size_t num) const;
+
+        // The caller decoded frames alone, for the statistics
+        void countAlone(size_t num);
+
+        struct Stats {
+            // Frames decoded in batches, and number of batches
+            size_t frames = 0;
+            size_t passes = 0;
+            // Frames decoded alone by their stream
+            size_t alone = 0;
+        };
+        Stats getStats(void) const;
+
+    private:
+        struct Buffers {
+            // Soft bits, [step][RATE][lane]
+            std::vector<int16_t> symbols;
+            // Decision bits of the 32 butterflies, [step][butterfly]
+            std::vector<uint32_t> decisions;
+        };
+
+        void decodePass(const ViterbiFrame *frames, size_t num);
+
+        SimdLevel level;
+
+        mutable std::mutex mutex;
+        Stats stats;
+
+        // Several passes can run at the same time, each one takes
+        // a set of buffers
+        std::mutex buffersMutex;
+        std::vector<std::unique_ptr<Buffers> > freeBuffers;
+};
+
+#endif
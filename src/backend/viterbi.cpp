@@ -21,7 +21,9 @@
 #include    <stdio.h>
 #include    <stdlib.h>
 #include    "viterbi.h"
+#include    <algorithm>
 #include    <cstring>
+#include    <stdexcept>
 
 #ifdef  __MINGW32__
 #  include <intrin.h>
@@ -29,6 +31,13 @@
 #  include <windows.h>
 #endif
 
+#if defined(SIMD_X86)
+#  include <immintrin.h>
+#endif
+#if defined(SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
 //  It took a while to discover that the polynomes we used
 //  in our own "straightforward" implementation was bitreversed!!
 //  The official one is on top.
@@ -43,6 +52,19 @@
 #define PRECISIONSHIFT  0
 #define RENORMALIZE_THRESHOLD   137
 
+//  Streaming mode: the bits are decided TRACEBACK_DEPTH bits after
+//  they were received, about 14 constraint lengths. The trellis
+//  is advanced STREAM_CHUNK bits at a time, each traceback outputs
+//  that many bits.
+#define TRACEBACK_DEPTH 96
+#define STREAM_CHUNK    96
+#define STREAM_RING     (TRACEBACK_DEPTH + STREAM_CHUNK)
+
+//  Soft output: the paths discarded by the decoded path are traced back
+//  over at most SOFT_OUTPUT_WINDOW steps, most of them merge with the
+//  decoded path within a few constraint lengths.
+#define SOFT_OUTPUT_WINDOW  24
+
 /* ADDSHIFT and SUBSHIFT make sure that the thing returned is a byte. */
 #if (K-1<8)
 #define ADDSHIFT (8-(K-1))
@@ -74,31 +96,12 @@ static uint8_t Partab[] =
   1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
   0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0};
 
-//  One could create the table above, i.e. a 256 entry
-//  odd-parity lookup table by the following function
-//  It is now precomputed
-void Viterbi::partab_init()
-{
-    int16_t i,cnt,ti;
-
-    for (i = 0; i < 256; i++){
-        cnt = 0;
-        ti = i;
-        while (ti != 0) {
-            if (ti & 1) cnt++;
-            ti >>= 1;
-        }
-        Partab[i] = cnt & 1;
-    }
-}
-
-int Viterbi::parity(int x)
+static int parity(int x)
 {
     /* Fold down to one byte */
     x ^= (x >> 16);
     x ^= (x >> 8);
-    return Partab[x];
-    //  return parityb(x);
+    return Partab[x & 0xFF];
 }
 
 static inline
@@ -119,11 +122,71 @@ void renormalize(COMPUTETYPE* X, COMPUTETYPE threshold)
     }
 }
 
+void PunctureSchedule::append(bool keep)
+{
+    if (keep) {
+        if (runs.empty() or runs.back().punctured > 0) {
+            runs.push_back({0, 0});
+        }
+        runs.back().kept++;
+        kept++;
+    }
+    else {
+        if (runs.empty()) {
+            runs.push_back({0, 0});
+        }
+        runs.back().punctured++;
+    }
+    bits++;
+}
+
+void PunctureSchedule::addBlocks(int16_t numBlocks, const int8_t *pi)
+{
+    for (int16_t i = 0; i < numBlocks; i++) {
+        for (int j = 0; j < 128; j++) {
+            append(pi[j % 32] != 0);
+        }
+    }
+}
+
+void PunctureSchedule::addTail(const uint8_t *pi)
+{
+    for (int i = 0; i < 24; i++) {
+        append(pi[i] != 0);
+    }
+}
+
+void PunctureSchedule::resize(int32_t numBits)
+{
+    while (bits > numBits) {
+        auto& run = runs.back();
+        const int32_t excess = bits - numBits;
+        if (run.punctured > 0) {
+            const int32_t n = std::min(excess, run.punctured);
+            run.punctured -= n;
+            bits -= n;
+        }
+        else {
+            const int32_t n = std::min(excess, run.kept);
+            run.kept -= n;
+            kept -= n;
+            bits -= n;
+        }
+        if (run.kept == 0 and run.punctured == 0) {
+            runs.pop_back();
+        }
+    }
+    while (bits < numBits) {
+        append(false);
+    }
+}
+
 //  The main use of the viterbi decoder is in handling the FIC blocks
 //  There are (in mode 1) 3 ofdm blocks, giving 4 FIC blocks
-//  There all have a predefined length. In that case we use the
-//  "fast" (i.e. spiral) code, otherwise we use the generic code
-Viterbi::Viterbi(int16_t wordlength)
+//  There all have a predefined length.
+Viterbi::Viterbi(int16_t wordlength, SimdLevel level, bool streaming) :
+    streaming(streaming),
+    level(simdLevelSupported(level) ? level : SimdLevel::Generic)
 {
     int polys[RATE] = POLYS;
     int16_t i, state;
@@ -132,33 +195,30 @@ Viterbi::Viterbi(int16_t wordlength)
 #endif
 
     frameBits = wordlength;
-    //  partab_init ();
 
-    // B I G N O T E    The spiral code uses (wordLength + (K - 1) * sizeof ...
-    // However, the application then crashes, so something is not OK
-    // By doubling the size, the problem disappears. It is not solved though
-    // and not further investigation.
+    // In streaming mode, only a window of the frame is kept
+    const int32_t symbolSteps = streaming ?
+        STREAM_CHUNK : wordlength + (K - 1);
+    const int32_t decisionSteps = streaming ?
+        STREAM_RING : wordlength + (K - 1);
+
+    // The kernels write the decisions of the steps they are given, and
+    // read RATE symbols per step, nothing beyond
 #ifdef __MINGW32__
-    size    = 2 * ((wordlength + (K - 1)) / 8 + 1 + 16) & ~0xF;
-    data    = (uint8_t *)_aligned_malloc (size, 16);
-    size    = 2 * (RATE * (wordlength + (K - 1)) * sizeof(COMPUTETYPE) + 16) & ~0xF;
+    size    = (RATE * symbolSteps * sizeof(COMPUTETYPE) + 16) & ~0xF;
     symbols = (COMPUTETYPE *)_aligned_malloc (size, 16);
-    size    = 2 * (wordlength + (K - 1)) * sizeof (decision_t);
+    size    = decisionSteps * sizeof (decision_t);
     size    = (size + 16) & ~0xF;
-    vp. decisions = (decision_t  *)_aligned_malloc (size, 16);
+    decisions = (decision_t  *)_aligned_malloc (size, 16);
 #else
-    if (posix_memalign ((void**)&data, 16,
-                (wordlength + (K - 1))/ 8 + 1)){
-        printf("Allocation of data array failed\n");
-    }
-        if (posix_memalign ((void**)&symbols, 16,
-                RATE * (wordlength + (K - 1)) * sizeof(COMPUTETYPE))){
+    if (posix_memalign ((void**)&symbols, 16,
+                RATE * symbolSteps * sizeof(COMPUTETYPE))){
         printf("Allocation of symbols array failed\n");
     }
-    if (posix_memalign ((void**)&(vp. decisions),
+    if (posix_memalign ((void**)&decisions,
                 16,
-                2 * (wordlength + (K - 1)) * sizeof (decision_t))){
-        printf ("Allocation of vp decisions failed\n");
+                decisionSteps * sizeof (decision_t))){
+        printf ("Allocation of decisions failed\n");
     }
 #endif
 
@@ -167,90 +227,575 @@ Viterbi::Viterbi(int16_t wordlength)
             Branchtab[i * NUMSTATES / 2 + state] =
                 (polys[i] < 0) ^
                 parity((2 * state) & abs (polys[i])) ? 255 : 0;
+            Branchtab16[i * NUMSTATES / 2 + state] =
+                Branchtab[i * NUMSTATES / 2 + state];
         }
     }
-
-    init_viterbi (&vp, 0);
 }
 
 
 Viterbi::~Viterbi()
 {
 #ifdef  __MINGW32__
-    _aligned_free (vp. decisions);
-    _aligned_free (data);
+    _aligned_free (decisions);
     _aligned_free (symbols);
 #else
-    free (vp. decisions);
-    free (data);
+    free (decisions);
     free (symbols);
 #endif
 }
 
-static int maskTable[] = {128, 64, 32, 16, 8, 4, 2, 1};
+size_t Viterbi::workingSetSize() const
+{
+    if (streaming) {
+        return RATE * STREAM_CHUNK * sizeof(COMPUTETYPE) +
+            STREAM_RING * sizeof(decision_t);
+    }
+    return RATE * (frameBits + (K - 1)) * sizeof(COMPUTETYPE) +
+        (frameBits + (K - 1)) * sizeof(decision_t) +
+        deltas.size() + pathStates.size() + bitReliability.size() +
+        byteReliability.size();
+}
 
-static inline
-uint8_t getbit (uint8_t v, int32_t o)
+void Viterbi::setSoftOutput(bool enable)
 {
-    return  (v & maskTable[o]) ? 1 : 0;
+    if (enable and streaming) {
+        throw std::logic_error("Soft output needs the decisions of the frame");
+    }
+
+    softOutput = enable;
+    if (enable and deltas.empty()) {
+        deltas.resize((frameBits + (K - 1)) * NUMSTATES);
+        pathStates.resize(frameBits + (K - 1));
+        bitReliability.resize(frameBits);
+        byteReliability.resize(frameBits / 8, 255);
+    }
 }
 
-//static
-//uint8_t getbit (uint8_t v, int32_t o) {
-//uint8_t   mask    = 1 << (7 - o);
-//  return  (v & mask) ? 1 : 0;
-//}
-
-// depends: POLYS, RATE, COMPUTETYPE
-//  encode was only used for testing purposes
-//void encode (/*const*/ unsigned char *bytes, COMPUTETYPE *symbols, int nbits) {
-//int   i, k;
-//int   polys[RATE] = POLYS;
-//int   sr = 0;
-//
-//// FIXME: this is slowish
-//// -- remember about the padding!
-//  for (i = 0; i < nbits + (K - 1); i++) {
-//     int b = bytes[i/8];
-//     int j = i % 8;
-//     int bit = (b >> (7-j)) & 1;
-//
-//     sr = (sr << 1) | bit;
-//     for (k = 0; k < RATE; k++)
-//        *(symbols++) = parity(sr & polys[k]);
-//  }
-//}
+/* SIMD versions of update_viterbi_blk_GENERIC.
+ *
+ * The 64 path metrics are kept in registers as 16-bit integers, the
+ * states 0..31 in lo[] and 32..63 in hi[]. They are loaded from metrics
+ * and stored back at the end, so that a frame can be decoded in pieces.
+ * Butterfly i reads states i and
+ * i + 32 and writes states 2i and 2i + 1, the new metrics are therefore
+ * obtained by interleaving the even and odd results.
+ *
+ * Instead of the conditional renormalisation of the generic code, the
+ * metric of state 0 is subtracted from all metrics after every bit. The
+ * decisions only depend on differences between metrics, which are the
+ * same as in the generic code. With K = 7, all states are reachable from
+ * any state in 6 bits, the spread of the metrics is therefore at most
+ * 6 * METRIC_MAX plus the initial bias, and the 16-bit metrics never
+ * saturate. The decoded bits are identical to the generic ones.
+ *
+ * The decision bits are written packed, in state order, as the
+ * generic code does. If deltas is given, the difference between the
+ * metrics of the two paths entering each state is written there too,
+ * 64 bytes per bit in state order, saturated to 255. */
+#define METRIC_MAX (RATE * 255)
+
+#if defined(SIMD_X86)
+SIMD_TARGET("sse2")
+static void update_viterbi_blk_sse2(
+        const int16_t *branchtab,
+        const COMPUTETYPE *syms,
+        int16_t nbits,
+        decision_t *d,
+        int16_t *metrics,
+        uint8_t *deltas)
+{
+    __m128i lo[4], hi[4];
+    __m128i bt[RATE][4];
+    for (int k = 0; k < 4; k++) {
+        lo[k] = _mm_loadu_si128((const __m128i*)(metrics + 8 * k));
+        hi[k] = _mm_loadu_si128((const __m128i*)(metrics + 32 + 8 * k));
+        for (int j = 0; j < RATE; j++) {
+            bt[j][k] = _mm_loadu_si128(
+                    (const __m128i*)(branchtab + j * NUMSTATES / 2 + 8 * k));
+        }
+    }
+
+    const __m128i max = _mm_set1_epi16(METRIC_MAX);
+
+    for (int32_t s = 0; s < nbits; s++) {
+        const COMPUTETYPE *sym = syms + s * RATE;
+        const __m128i s0 = _mm_set1_epi16(sym[0]);
+        const __m128i s1 = _mm_set1_epi16(sym[1]);
+        const __m128i s2 = _mm_set1_epi16(sym[2]);
+        const __m128i s3 = _mm_set1_epi16(sym[3]);
+
+        __m128i nm[8];
+        uint32_t dec[4];
+        for (int k = 0; k < 4; k++) {
+            const __m128i metric = _mm_add_epi16(
+                    _mm_add_epi16(_mm_xor_si128(bt[0][k], s0),
+                        _mm_xor_si128(bt[1][k], s1)),
+                    _mm_add_epi16(_mm_xor_si128(bt[2][k], s2),
+                        _mm_xor_si128(bt[3][k], s3)));
+            const __m128i inv_metric = _mm_sub_epi16(max, metric);
+
+            const __m128i m0 = _mm_adds_epi16(lo[k], metric);
+            const __m128i m1 = _mm_adds_epi16(hi[k], inv_metric);
+            const __m128i m2 = _mm_adds_epi16(lo[k], inv_metric);
+            const __m128i m3 = _mm_adds_epi16(hi[k], metric);
+
+            const __m128i dec0 = _mm_cmpgt_epi16(m0, m1);
+            const __m128i dec1 = _mm_cmpgt_epi16(m2, m3);
+            const __m128i even = _mm_min_epi16(m0, m1);
+            const __m128i odd = _mm_min_epi16(m2, m3);
+
+            nm[2 * k] = _mm_unpacklo_epi16(even, odd);
+            nm[2 * k + 1] = _mm_unpackhi_epi16(even, odd);
+            dec[k] = _mm_movemask_epi8(_mm_packs_epi16(
+                        _mm_unpacklo_epi16(dec0, dec1),
+                        _mm_unpackhi_epi16(dec0, dec1)));
+
+            if (deltas) {
+                const __m128i de = _mm_sub_epi16(_mm_max_epi16(m0, m1), even);
+                const __m128i dodd = _mm_sub_epi16(_mm_max_epi16(m2, m3), odd);
+                _mm_storeu_si128(
+                        (__m128i*)(deltas + s * NUMSTATES + 16 * k),
+                        _mm_packus_epi16(_mm_unpacklo_epi16(de, dodd),
+                            _mm_unpackhi_epi16(de, dodd)));
+            }
+        }
+
+        d[s].w[0] = dec[0] | (dec[1] << 16);
+        d[s].w[1] = dec[2] | (dec[3] << 16);
+
+        const __m128i norm = _mm_shuffle_epi32(
+                _mm_shufflelo_epi16(nm[0], 0), 0);
+        for (int k = 0; k < 4; k++) {
+            lo[k] = _mm_sub_epi16(nm[k], norm);
+            hi[k] = _mm_sub_epi16(nm[4 + k], norm);
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        _mm_storeu_si128((__m128i*)(metrics + 8 * k), lo[k]);
+        _mm_storeu_si128((__m128i*)(metrics + 32 + 8 * k), hi[k]);
+    }
+}
+
+SIMD_TARGET("avx2")
+static void update_viterbi_blk_avx2(
+        const int16_t *branchtab,
+        const COMPUTETYPE *syms,
+        int16_t nbits,
+        decision_t *d,
+        int16_t *metrics,
+        uint8_t *deltas)
+{
+    __m256i lo[2], hi[2];
+    __m256i bt[RATE][2];
+    for (int k = 0; k < 2; k++) {
+        lo[k] = _mm256_loadu_si256((const __m256i*)(metrics + 16 * k));
+        hi[k] = _mm256_loadu_si256((const __m256i*)(metrics + 32 + 16 * k));
+        for (int j = 0; j < RATE; j++) {
+            bt[j][k] = _mm256_loadu_si256(
+                    (const __m256i*)(branchtab + j * NUMSTATES / 2 + 16 * k));
+        }
+    }
+
+    const __m256i max = _mm256_set1_epi16(METRIC_MAX);
+
+    for (int32_t s = 0; s < nbits; s++) {
+        const COMPUTETYPE *sym = syms + s * RATE;
+        const __m256i s0 = _mm256_set1_epi16(sym[0]);
+        const __m256i s1 = _mm256_set1_epi16(sym[1]);
+        const __m256i s2 = _mm256_set1_epi16(sym[2]);
+        const __m256i s3 = _mm256_set1_epi16(sym[3]);
+
+        __m256i nm[4];
+        for (int k = 0; k < 2; k++) {
+            const __m256i metric = _mm256_add_epi16(
+                    _mm256_add_epi16(_mm256_xor_si256(bt[0][k], s0),
+                        _mm256_xor_si256(bt[1][k], s1)),
+                    _mm256_add_epi16(_mm256_xor_si256(bt[2][k], s2),
+                        _mm256_xor_si256(bt[3][k], s3)));
+            const __m256i inv_metric = _mm256_sub_epi16(max, metric);
+
+            const __m256i m0 = _mm256_adds_epi16(lo[k], metric);
+            const __m256i m1 = _mm256_adds_epi16(hi[k], inv_metric);
+            const __m256i m2 = _mm256_adds_epi16(lo[k], inv_metric);
+            const __m256i m3 = _mm256_adds_epi16(hi[k], metric);
+
+            const __m256i dec0 = _mm256_cmpgt_epi16(m0, m1);
+            const __m256i dec1 = _mm256_cmpgt_epi16(m2, m3);
+            const __m256i even = _mm256_min_epi16(m0, m1);
+            const __m256i odd = _mm256_min_epi16(m2, m3);
+
+            // The unpacks work within 128-bit lanes: u_lo holds the
+            // states 0..7 and 16..23 of this group of 32, u_hi 8..15
+            // and 24..31.
+            const __m256i u_lo = _mm256_unpacklo_epi16(even, odd);
+            const __m256i u_hi = _mm256_unpackhi_epi16(even, odd);
+            nm[2 * k] = _mm256_permute2x128_si256(u_lo, u_hi, 0x20);
+            nm[2 * k + 1] = _mm256_permute2x128_si256(u_lo, u_hi, 0x31);
+
+            // Packing lane by lane puts the decisions back in order
+            d[s].w[k] = _mm256_movemask_epi8(_mm256_packs_epi16(
+                        _mm256_unpacklo_epi16(dec0, dec1),
+                        _mm256_unpackhi_epi16(dec0, dec1)));
+
+            if (deltas) {
+                const __m256i de = _mm256_sub_epi16(
+                        _mm256_max_epi16(m0, m1), even);
+                const __m256i dodd = _mm256_sub_epi16(
+                        _mm256_max_epi16(m2, m3), odd);
+                _mm256_storeu_si256(
+                        (__m256i*)(deltas + s * NUMSTATES + 32 * k),
+                        _mm256_packus_epi16(_mm256_unpacklo_epi16(de, dodd),
+                            _mm256_unpackhi_epi16(de, dodd)));
+            }
+        }
+
+        const __m256i norm = _mm256_broadcastw_epi16(
+                _mm256_castsi256_si128(nm[0]));
+        for (int k = 0; k < 2; k++) {
+            lo[k] = _mm256_sub_epi16(nm[k], norm);
+            hi[k] = _mm256_sub_epi16(nm[2 + k], norm);
+        }
+    }
+
+    for (int k = 0; k < 2; k++) {
+        _mm256_storeu_si256((__m256i*)(metrics + 16 * k), lo[k]);
+        _mm256_storeu_si256((__m256i*)(metrics + 32 + 16 * k), hi[k]);
+    }
+}
+#endif
+
+#if defined(SIMD_NEON)
+static void update_viterbi_blk_neon(
+        const int16_t *branchtab,
+        const COMPUTETYPE *syms,
+        int16_t nbits,
+        decision_t *d,
+        int16_t *metrics,
+        uint8_t *deltas)
+{
+    int16x8_t lo[4], hi[4];
+    int16x8_t bt[RATE][4];
+    for (int k = 0; k < 4; k++) {
+        lo[k] = vld1q_s16(metrics + 8 * k);
+        hi[k] = vld1q_s16(metrics + 32 + 8 * k);
+        for (int j = 0; j < RATE; j++) {
+            bt[j][k] = vld1q_s16(branchtab + j * NUMSTATES / 2 + 8 * k);
+        }
+    }
+
+    const int16x8_t max = vdupq_n_s16(METRIC_MAX);
+    const uint8_t weights[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t bit_weights = vld1q_u8(weights);
+
+    for (int32_t s = 0; s < nbits; s++) {
+        const COMPUTETYPE *sym = syms + s * RATE;
+        const int16x8_t s0 = vdupq_n_s16(sym[0]);
+        const int16x8_t s1 = vdupq_n_s16(sym[1]);
+        const int16x8_t s2 = vdupq_n_s16(sym[2]);
+        const int16x8_t s3 = vdupq_n_s16(sym[3]);
+
+        int16x8_t nm[8];
+        uint32_t dec[4];
+        for (int k = 0; k < 4; k++) {
+            const int16x8_t metric = vaddq_s16(
+                    vaddq_s16(veorq_s16(bt[0][k], s0), veorq_s16(bt[1][k], s1)),
+                    vaddq_s16(veorq_s16(bt[2][k], s2), veorq_s16(bt[3][k], s3)));
+            const int16x8_t inv_metric = vsubq_s16(max, metric);
+
+            const int16x8_t m0 = vqaddq_s16(lo[k], metric);
+            const int16x8_t m1 = vqaddq_s16(hi[k], inv_metric);
+            const int16x8_t m2 = vqaddq_s16(lo[k], inv_metric);
+            const int16x8_t m3 = vqaddq_s16(hi[k], metric);
+
+            const int16x8x2_t nmk = vzipq_s16(
+                    vminq_s16(m0, m1), vminq_s16(m2, m3));
+            nm[2 * k] = nmk.val[0];
+            nm[2 * k + 1] = nmk.val[1];
+
+            if (deltas) {
+                const int16x8x2_t dk = vzipq_s16(
+                        vabdq_s16(m0, m1), vabdq_s16(m2, m3));
+                vst1q_u8(deltas + s * NUMSTATES + 16 * k, vcombine_u8(
+                            vqmovun_s16(dk.val[0]), vqmovun_s16(dk.val[1])));
+            }
+
+            // NEON has no movemask, weight the bytes of the decision
+            // masks and add them up instead
+            const uint16x8x2_t deck = vzipq_u16(
+                    vcgtq_s16(m0, m1), vcgtq_s16(m2, m3));
+            const uint8x16_t mask = vandq_u8(bit_weights, vcombine_u8(
+                        vmovn_u16(deck.val[0]), vmovn_u16(deck.val[1])));
+            const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(mask)));
+            dec[k] = (uint32_t)(vgetq_lane_u64(sum, 0) |
+                    (vgetq_lane_u64(sum, 1) << 8));
+        }
+
+        d[s].w[0] = dec[0] | (dec[1] << 16);
+        d[s].w[1] = dec[2] | (dec[3] << 16);
+
+        const int16x8_t norm = vdupq_lane_s16(vget_low_s16(nm[0]), 0);
+        for (int k = 0; k < 4; k++) {
+            lo[k] = vsubq_s16(nm[k], norm);
+            hi[k] = vsubq_s16(nm[4 + k], norm);
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        vst1q_s16(metrics + 8 * k, lo[k]);
+        vst1q_s16(metrics + 32 + 8 * k, hi[k]);
+    }
+}
+#endif
 
 //  Note that our DAB environment maps the softbits to -127 .. 127
 //  we have to map that onto 0 .. 255
 
-void Viterbi::deconvolve(int16_t *input, uint8_t *output)
+void Viterbi::deconvolve(const int16_t *input, uint8_t *output)
+{
+    decode(input, nullptr, output);
+}
+
+void Viterbi::deconvolve(const int16_t *input,
+        const PunctureSchedule& schedule, uint8_t *output)
+{
+    if (schedule.numBits() != (frameBits + (K - 1)) * RATE) {
+        throw std::logic_error("Puncture schedule does not match the frame");
+    }
+    decode(input, &schedule, output);
+}
+
+static inline COMPUTETYPE to_symbol(int16_t softbit)
+{
+    int16_t temp = softbit + 127;
+    if (temp < 0) temp = 0;
+    if (temp > 255) temp = 255;
+    return temp;
+}
+
+/* Reads the symbols of a frame in pieces, and inserts the punctured
+ * bits, which are soft bits of 0. */
+class SymbolReader {
+    public:
+        SymbolReader(const int16_t *input, const PunctureSchedule *schedule) :
+            input(input), schedule(schedule) {}
+
+        void read(COMPUTETYPE *sym, int32_t n)
+        {
+            if (not schedule) {
+                for (int32_t i = 0; i < n; i++) {
+                    *sym++ = to_symbol(*input++);
+                }
+                return;
+            }
+
+            const auto& runs = schedule->getRuns();
+            while (n > 0) {
+                const auto& r = runs[run];
+                if (inRun < r.kept) {
+                    const int32_t m = std::min(n, r.kept - inRun);
+                    for (int32_t i = 0; i < m; i++) {
+                        *sym++ = to_symbol(*input++);
+                    }
+                    inRun += m;
+                    n -= m;
+                }
+                else {
+                    const int32_t m = std::min(n, r.kept + r.punctured - inRun);
+                    std::fill(sym, sym + m, (COMPUTETYPE)127);
+                    sym += m;
+                    inRun += m;
+                    n -= m;
+                }
+                if (inRun == r.kept + r.punctured) {
+                    run++;
+                    inRun = 0;
+                }
+            }
+        }
+
+    private:
+        const int16_t *input;
+        const PunctureSchedule *schedule;
+        size_t run = 0;
+        int32_t inRun = 0;
+};
+
+void Viterbi::decode(const int16_t *input,
+        const PunctureSchedule *schedule, uint8_t *output)
+{
+    SymbolReader reader(input, schedule);
+
+    int16_t metrics[NUMSTATES];
+    std::fill(metrics, metrics + NUMSTATES, 63);
+    metrics[0] = 0;
+
+    if (streaming) {
+        decodeStreaming(reader, metrics, output);
+        return;
+    }
+
+    reader.read(symbols, (frameBits + (K - 1)) * RATE);
+    updateMetrics(symbols, frameBits + (K - 1), decisions, metrics,
+            softOutput ? deltas.data() : nullptr);
+
+    chainback_viterbi (output, frameBits, 0);
+
+    if (softOutput) {
+        rateBytes();
+    }
+}
+
+void Viterbi::updateMetrics(const COMPUTETYPE *syms, int16_t nbits,
+        decision_t *d, int16_t *metrics, uint8_t *deltas)
+{
+    switch (level) {
+#if defined(SIMD_X86)
+        case SimdLevel::SSE2:
+            update_viterbi_blk_sse2 (Branchtab16, syms, nbits, d, metrics,
+                    deltas);
+            break;
+        case SimdLevel::AVX2:
+            update_viterbi_blk_avx2 (Branchtab16, syms, nbits, d, metrics,
+                    deltas);
+            break;
+#endif
+#if defined(SIMD_NEON)
+        case SimdLevel::NEON:
+            update_viterbi_blk_neon (Branchtab16, syms, nbits, d, metrics,
+                    deltas);
+            break;
+#endif
+        default:
+            update_viterbi_blk_GENERIC (syms, nbits, d, metrics, deltas);
+            break;
+    }
+}
+
+/* Soft output as in the SOVA of Hagenauer and Hoeher: every path
+ * discarded by the decoded path is traced back until it merges with it,
+ * the bits where the two paths differ are then at most as reliable as
+ * the difference between their metrics. A byte is as reliable as its
+ * least reliable bit. */
+void Viterbi::rateBytes()
 {
-    uint32_t    i;
+    const int32_t nsteps = frameBits + (K - 1);
+    const decision_t *d = decisions;
+    auto decision = [d](int32_t s, uint32_t state) {
+        return (d[s].w[state / 32] >> (state % 32)) & 1;
+    };
+
+    // The decoded path ends in state 0
+    uint32_t state = 0;
+    for (int32_t s = nsteps - 1; s >= K - 1; s--) {
+        pathStates[s] = state;
+        state = (state >> 1) | (decision(s, state) << (K - 2));
+    }
+
+    std::fill(bitReliability.begin(), bitReliability.end(), 255);
+    for (int32_t s = K - 1; s < nsteps; s++) {
+        const uint32_t merge = pathStates[s];
+        const uint8_t delta = deltas[s * NUMSTATES + merge];
+        if (delta == 255) {
+            continue;
+        }
 
-    init_viterbi (&vp, 0);
-    for (i = 0; i < (uint16_t)(frameBits + (K - 1)) * RATE; i ++) {
-        int16_t temp = input[i] + 127;
-        if (temp < 0) temp = 0;
-        if (temp > 255) temp = 255;
-        symbols[i] = temp;
+        // The discarded path differs in the bit decided at step s
+        uint32_t k = decision(s, merge) ^ 1;
+        uint8_t *rel = &bitReliability[s - (K - 1)];
+        *rel = std::min(*rel, delta);
+        uint32_t other = (merge >> 1) | (k << (K - 2));
+
+        const int32_t first = std::max(K - 1, s - SOFT_OUTPUT_WINDOW);
+        for (int32_t t = s - 1; t >= first and other != pathStates[t]; t--) {
+            k = decision(t, other);
+            if (k != decision(t, pathStates[t])) {
+                rel = &bitReliability[t - (K - 1)];
+                *rel = std::min(*rel, delta);
+            }
+            other = (other >> 1) | (k << (K - 2));
+        }
     }
 
-    update_viterbi_blk_GENERIC (&vp, symbols, frameBits + (K - 1));
+    for (int32_t b = 0; b < frameBits / 8; b++) {
+        byteReliability[b] = *std::min_element(
+                bitReliability.begin() + 8 * b,
+                bitReliability.begin() + 8 * b + 8);
+    }
+}
+
+/* The trellis is advanced by STREAM_CHUNK bits at a time. When the
+ * decisions of TRACEBACK_DEPTH more bits are known, the path ending in
+ * the best state is traced back, and the oldest STREAM_CHUNK bits are
+ * output. At the end of the frame, the path ending in state 0 gives
+ * the rest. */
+void Viterbi::decodeStreaming(SymbolReader& reader, int16_t *metrics,
+        uint8_t *output)
+{
+    const int32_t nsteps = frameBits + (K - 1);
+    // Steps whose decoded bits were output
+    int32_t decided = 0;
+
+    for (int32_t t = 0; t < nsteps; ) {
+        const int16_t n = std::min<int32_t>(STREAM_CHUNK, nsteps - t);
+        reader.read(symbols, n * RATE);
+        updateMetrics(symbols, n, &decisions[t % STREAM_RING], metrics,
+                nullptr);
+        t += n;
+
+        if (t < nsteps and t - decided == STREAM_RING) {
+            uint16_t best = 0;
+            for (uint16_t s = 1; s < NUMSTATES; s++) {
+                if (metrics[s] < metrics[best]) {
+                    best = s;
+                }
+            }
+            traceback(best, t, decided, decided + STREAM_CHUNK, output);
+            decided += STREAM_CHUNK;
+        }
+    }
 
-    chainback_viterbi (&vp, data, frameBits, 0);
+    traceback(0, nsteps, decided, nsteps, output);
+}
 
-    for (i = 0; i < (uint16_t)frameBits; i ++)
-        output[i] = getbit (data[i >> 3], i & 07);
+/* Trace the path ending in state at step end back to step first, and
+ * output the bits of the steps before last. The bit decided at step s
+ * is the data bit s - (K - 1), it is stored in its packed byte without
+ * touching the neighbouring bits, which may belong to another window. */
+void Viterbi::traceback(uint32_t state, int32_t end, int32_t first,
+        int32_t last, uint8_t *output)
+{
+    const decision_t *d = decisions;
+    auto decide = [&](int32_t s) {
+        const decision_t& ds = d[streaming ? s % STREAM_RING : s];
+        const uint32_t k = (ds.w[state / 32] >> (state % 32)) & 1;
+        state = (state >> 1) | (k << (K - 2));
+        return k;
+    };
+
+    int32_t s = end - 1;
+    for (; s >= last; s--) {
+        decide(s);
+    }
+    for (; s >= std::max(first, K - 1); s--) {
+        const int32_t b = s - (K - 1);
+        const uint8_t mask = 0x80 >> (b & 7);
+        output[b >> 3] = decide(s) ? output[b >> 3] | mask :
+            output[b >> 3] & ~mask;
+    }
 }
 
 /* C-language butterfly */
 void Viterbi::BFLY(
         int i,
         int s,
-        COMPUTETYPE * syms,
-        struct v * vp,
-        decision_t * d)
+        const COMPUTETYPE * syms,
+        const COMPUTETYPE *old_metrics,
+        COMPUTETYPE *new_metrics,
+        decision_t * d,
+        uint8_t * delta)
 {
     int32_t j, decision0, decision1;
     COMPUTETYPE metric,m0,m1,m2,m3;
@@ -263,16 +808,21 @@ void Viterbi::BFLY(
     const COMPUTETYPE max =
         ((RATE * ((256 - 1) >> METRICSHIFT)) >> PRECISIONSHIFT);
 
-    m0 = vp->old_metrics->t[i] + metric;
-    m1 = vp->old_metrics->t[i + NUMSTATES / 2] + (max - metric);
-    m2 = vp->old_metrics->t[i] + (max - metric);
-    m3 = vp->old_metrics->t[i + NUMSTATES / 2] + metric;
+    m0 = old_metrics[i] + metric;
+    m1 = old_metrics[i + NUMSTATES / 2] + (max - metric);
+    m2 = old_metrics[i] + (max - metric);
+    m3 = old_metrics[i + NUMSTATES / 2] + metric;
 
     decision0 = ((int32_t)(m0 - m1)) > 0;
     decision1 = ((int32_t)(m2 - m3)) > 0;
 
-    vp->new_metrics->t[2 * i] = decision0 ? m1 : m0;
-    vp->new_metrics->t[2 * i + 1] =  decision1 ? m3 : m2;
+    new_metrics[2 * i] = decision0 ? m1 : m0;
+    new_metrics[2 * i + 1] =  decision1 ? m3 : m2;
+
+    if (delta) {
+        delta[2 * i] = std::min(255, std::abs((int32_t)(m0 - m1)));
+        delta[2 * i + 1] = std::min(255, std::abs((int32_t)(m2 - m3)));
+    }
 
     d->w[i/(sizeof(uint32_t)*8/2)+s*(sizeof(decision_t)/sizeof(uint32_t))] |=
         (decision0|decision1<<1) << ((2*i)&(sizeof(uint32_t)*8-1));
@@ -281,42 +831,53 @@ void Viterbi::BFLY(
 /* Update decoder with a block of demodulated symbols
  * Note that nbits is the number of decoded data bits, not the number
  * of symbols!
+ * The metrics stay well below 2^15 with the renormalisation, they are
+ * kept between the blocks in the 16-bit metrics of the SIMD kernels.
  */
 void Viterbi::update_viterbi_blk_GENERIC(
-        struct v *vp,
-        COMPUTETYPE *syms,
-        int16_t nbits)
+        const COMPUTETYPE *syms,
+        int16_t nbits,
+        decision_t *d,
+        int16_t *metrics,
+        uint8_t *deltas)
 {
-    decision_t *d = (decision_t *)vp->decisions;
     int32_t  s, i;
+    COMPUTETYPE metrics1[NUMSTATES], metrics2[NUMSTATES];
+    COMPUTETYPE *old_metrics = metrics1;
+    COMPUTETYPE *new_metrics = metrics2;
+
+    for (i = 0; i < NUMSTATES; i++) {
+        old_metrics[i] = metrics[i];
+    }
 
     for (s = 0; s < nbits; s++) {
         memset (&d[s], 0, sizeof (decision_t));
     }
 
     for (s = 0; s < nbits; s++) {
-        void *tmp;
         for (i = 0; i < NUMSTATES / 2; i++) {
-            BFLY (i, s, syms, vp, vp->decisions);
+            BFLY (i, s, syms, old_metrics, new_metrics, d,
+                    deltas ? deltas + s * NUMSTATES : nullptr);
         }
 
-        renormalize (vp->new_metrics -> t, RENORMALIZE_THRESHOLD);
+        renormalize (new_metrics, RENORMALIZE_THRESHOLD);
         //     Swap pointers to old and new metrics
-        tmp = vp->old_metrics;
-        vp->old_metrics = vp -> new_metrics;
-        vp->new_metrics = (metric_t *)tmp;
+        std::swap(old_metrics, new_metrics);
+    }
+
+    for (i = 0; i < NUMSTATES; i++) {
+        metrics[i] = old_metrics[i];
     }
 }
 
 //
 /* Viterbi chainback */
 void Viterbi::chainback_viterbi(
-        struct v *vp,
         uint8_t *data, /* Decoded output data */
         int16_t nbits, /* Number of data bits */
         uint16_t endstate) /*Terminal encoder state */
 {
-    decision_t *d = vp->decisions;
+    decision_t *d = decisions;
 
     /* Make room beyond the end of the encoder register so we can
      * accumulate a full byte of decoded data
@@ -337,19 +898,3 @@ void Viterbi::chainback_viterbi(
         data[nbits >> 3] = endstate >> SUBSHIFT;
     }
 }
-
-/* Initialize Viterbi decoder for start of new frame */
-void Viterbi::init_viterbi(struct v *p, int16_t starting_state)
-{
-    struct v *vp = p;
-    int32_t i;
-
-    for (i = 0; i < NUMSTATES; i++)
-        vp->metrics1.t[i] = 63;
-
-    vp->old_metrics = &vp -> metrics1;
-    vp->new_metrics = &vp -> metrics2;
-    /* Bias known start state */
-    vp->old_metrics-> t[starting_state & (NUMSTATES-1)] = 0;
-}
-
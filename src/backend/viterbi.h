@@ -3,8 +3,10 @@
 /*
  *  Viterbi.h according to the SPIRAL project
  */
+#include    <vector>
 #include    "dab-constants.h"
 #include    "MathHelper.h"
+#include    "cpu_features.h"
 
 //  For our particular viterbi decoder, we have
 #define RATE    4
@@ -23,53 +25,125 @@ typedef union {
     uint8_t c[NUMSTATES/8];
 } decision_t __attribute__ ((aligned (16)));
 
-typedef union {
-    COMPUTETYPE t[NUMSTATES];
-} metric_t __attribute__ ((aligned (16)));
-
-/* State info for instance of Viterbi decoder
-*/
-
-struct v {
-    /* path metric buffer 1 */
-    __attribute__ ((aligned (16))) metric_t metrics1;
-    /* path metric buffer 2 */
-    __attribute__ ((aligned (16))) metric_t metrics2;
-    /* Pointers to path metrics, swapped on every bit */
-    metric_t   *old_metrics,*new_metrics;
-    decision_t *decisions;   /* decisions */
+/* Positions of the transmitted bits in the mother code of a frame, as
+ * runs of transmitted bits each followed by a run of punctured bits.
+ * The schedule of a protection profile is built once, depuncturing
+ * a frame is then a sequence of copies and fills. */
+class PunctureSchedule
+{
+    public:
+        struct Run {
+            int32_t kept;
+            int32_t punctured;
+        };
+
+        // Append blocks of 128 bits, punctured per 32 bits with pi
+        void addBlocks(int16_t numBlocks, const int8_t *pi);
+        // Append the 24 bits of the tail, punctured with pi
+        void addTail(const uint8_t *pi);
+        // Cut the schedule, or extend it with punctured bits
+        void resize(int32_t numBits);
+
+        // Number of transmitted soft bits in a frame
+        int32_t numKept(void) const { return kept; }
+        // Number of bits of the mother code
+        int32_t numBits(void) const { return bits; }
+        const std::vector<Run>& getRuns(void) const { return runs; }
+
+    private:
+        void append(bool keep);
+
+        std::vector<Run> runs;
+        int32_t kept = 0;
+        int32_t bits = 0;
 };
 
+class ViterbiBatch;
+class SymbolReader;
+
 class Viterbi
 {
     public:
-        Viterbi(int16_t);
+        // In streaming mode, the bits are traced back over a window of
+        // fixed length while the frame is decoded, instead of once over
+        // the whole frame. The decisions and symbols then need a few
+        // kilobytes instead of growing with the frame length.
+        Viterbi(int16_t wordlength, SimdLevel level = detectSimdLevel(),
+                bool streaming = false);
         ~Viterbi(void);
         Viterbi(const Viterbi& other) = delete;
         Viterbi& operator=(const Viterbi& other) = delete;
-        void deconvolve(int16_t *input, uint8_t *output);
+        // Decode the soft bits of the whole mother code. The frameBits
+        // decoded bits are packed into frameBits / 8 bytes of output,
+        // the first bit in the most significant bit of the first byte.
+        void deconvolve(const int16_t *input, uint8_t *output);
+
+        // Decode the transmitted soft bits of a punctured frame,
+        // the punctured bits are inserted while the input is read.
+        void deconvolve(const int16_t *input,
+                const PunctureSchedule& schedule, uint8_t *output);
+
+        SimdLevel getSimdLevel(void) const { return level; }
+        bool isStreaming(void) const { return streaming; }
+
+        // In soft-output mode, the reliability of every decoded byte is
+        // rated from the metric differences between the decoded path and
+        // the paths it discarded. Not available in streaming mode.
+        void setSoftOutput(bool enable);
+        bool getSoftOutput(void) const { return softOutput; }
+
+        // Reliability of the frameBits / 8 bytes of the last frame decoded
+        // in soft-output mode, lower values are less reliable
+        const uint8_t *getByteReliability(void) const
+            { return byteReliability.data(); }
+
+        // Bytes allocated for the decisions and symbols
+        size_t workingSetSize(void) const;
 
     private:
-        struct v    vp;
+        friend class ViterbiBatch;
+        void decode(const int16_t *input,
+                const PunctureSchedule *schedule, uint8_t *output);
+        void decodeStreaming(SymbolReader& reader, int16_t *metrics,
+                uint8_t *output);
+        void updateMetrics(const COMPUTETYPE *syms, int16_t nbits,
+                decision_t *d, int16_t *metrics, uint8_t *deltas);
+        void traceback(uint32_t state, int32_t end, int32_t first,
+                int32_t last, uint8_t *output);
+        void rateBytes(void);
+
+        bool streaming;
+
+        bool softOutput = false;
+        // Metric differences of the 64 states at every step
+        std::vector<uint8_t> deltas;
+        // States of the decoded path at every step
+        std::vector<uint8_t> pathStates;
+        std::vector<uint8_t> bitReliability;
+        std::vector<uint8_t> byteReliability;
+
+        // The SIMD kernels give the same decisions as the generic
+        // code, which is kept as reference.
+        SimdLevel level;
+        decision_t *decisions;
         COMPUTETYPE Branchtab   [NUMSTATES / 2 * RATE] __attribute__ ((aligned (16)));
-        //  int parityb     (uint8_t);
-        int parity(int x);
-        void partab_init (void);
-        //  uint8_t Partab  [256];
-        void init_viterbi(struct v *, int16_t starting_state);
-
-        void update_viterbi_blk_GENERIC( struct v *vp,
-                                         COMPUTETYPE *syms,
-                                         int16_t nbits);
-
-        void chainback_viterbi( struct v *vp,
-                                uint8_t *data, /* Decoded output data */
+        // Branchtab with 16-bit entries, for the SIMD kernels
+        int16_t Branchtab16 [NUMSTATES / 2 * RATE] __attribute__ ((aligned (16)));
+
+        void update_viterbi_blk_GENERIC( const COMPUTETYPE *syms,
+                                         int16_t nbits,
+                                         decision_t *d,
+                                         int16_t *metrics,
+                                         uint8_t *deltas);
+
+        void chainback_viterbi( uint8_t *data, /* Decoded output data */
                                 int16_t nbits, /* Number of data bits */
                                 uint16_t endstate); /*Terminal encoder state */
 
-        void BFLY( int i, int s, COMPUTETYPE * syms, struct v * vp, decision_t * d);
+        void BFLY( int i, int s, const COMPUTETYPE * syms,
+                   const COMPUTETYPE *old_metrics, COMPUTETYPE *new_metrics,
+                   decision_t * d, uint8_t * delta);
 
-        uint8_t *data;
         COMPUTETYPE *symbols;
         int16_t frameBits;
 };
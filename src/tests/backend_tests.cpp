@@ -36,6 +36,7 @@
 
 #include "radio-receiver.h"
 #include "raw_file.h"
+#include "kernel_tests.h"
 
 class TestRadioInterface : public RadioControllerInterface {
     public:
@@ -47,11 +48,13 @@ class TestRadioInterface : public RadioControllerInterface {
 
         virtual void onNewEnsembleName(const std::string& name) override { (void)name; }
         virtual void onDateTimeUpdate(const dab_date_time_t& dateTime) override { (void)dateTime; }
-        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override { (void)crcCheckOk; (void)fib; }
+        virtual void onFIBDecoded(bool crcCheckOk, const uint8_t* fib) override { (void)crcCheckOk; (void)fib; }
         virtual void onNewImpulseResponse(std::vector<float>&& data) override { (void)data; }
 
         virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
         virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
+        virtual void onSymbolQueueOverrun(const symbol_queue_stats_t& stats) override { (void)stats; }
+        virtual void onSyncMilestones(const sync_milestones_t& milestones) override { (void)milestones; }
         virtual void onMessage(message_level_t level, const std::string& text) override { (void) level; (void)text; }
 
         virtual void onTIIMeasurement(tii_measurement_t&& m) override { (void)m; }
@@ -77,6 +80,7 @@ public:
 
     virtual void onMOT(const std::vector<uint8_t>& data, int subtype) override { (void)data; (void)subtype; }
     virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) override { (void)announced_xpad_len; (void) xpad_len;}
+    virtual void onFrameOverflow(const frame_overflow_stats_t& stats) override { (void)stats; }
 };
 
 class BackendTests : public QObject
@@ -191,6 +195,17 @@ void BackendTests::testDLS()
     QCOMPARE(isOK, true);
 }
 
-QTEST_APPLESS_MAIN(BackendTests)
+int main(int argc, char *argv[])
+{
+    int status = 0;
+
+    BackendTests backendTests;
+    status |= QTest::qExec(&backendTests, argc, argv);
+
+    KernelTests kernelTests;
+    status |= QTest::qExec(&kernelTests, argc, argv);
+
+    return status;
+}
 
 #include "backend_tests.moc"
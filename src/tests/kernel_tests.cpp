@@ -0,0 +1,545 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "kernel_tests.h"
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include "viterbi.h"
+#include "viterbi-batch.h"
+#include "eep-protection.h"
+#include "uep-protection.h"
+#include "protTables.h"
+#include "energy_dispersal.h"
+#include "rs-syndromes.h"
+#include "dabplus_decoder.h"
+#include "MathHelper.h"
+
+// The same frames on every run
+static std::mt19937 random_generator(1);
+
+// The bits of data, convolutionally encoded with the DAB mother code,
+// including the 6 tail bits, and sent through an AWGN channel with the
+// given standard deviation, for soft bits of +-127.
+static std::vector<int16_t> encodeFrame(const std::vector<uint8_t>& data,
+        double stddev)
+{
+    const int polys[RATE] = { 0155, 0117, 0123, 0155 };
+    auto parity = [](int x) {
+        int p = 0;
+        for (; x; x >>= 1) {
+            p ^= x & 1;
+        }
+        return p;
+    };
+
+    std::normal_distribution<double> noise(0.0, stddev);
+
+    const int frameBits = data.size();
+    std::vector<int16_t> softBits(RATE * (frameBits + 6));
+    int sr = 0;
+    for (int i = 0; i < frameBits + 6; i++) {
+        const int b = i < frameBits ? data[i] : 0;
+        sr = (sr << 1) | b;
+        for (int k = 0; k < RATE; k++) {
+            const double s = (parity(sr & polys[k]) ? 127 : -127) +
+                noise(random_generator);
+            softBits[i * RATE + k] = std::max(-127.0, std::min(127.0, s));
+        }
+    }
+    return softBits;
+}
+
+static std::vector<uint8_t> randomBits(int numBits)
+{
+    std::uniform_int_distribution<int> bit(0, 1);
+    std::vector<uint8_t> bits(numBits);
+    for (auto& b : bits) {
+        b = bit(random_generator);
+    }
+    return bits;
+}
+
+// A random frame of frameBits bits, encoded and sent as by encodeFrame
+static std::vector<int16_t> makeCodedFrame(int frameBits, double stddev)
+{
+    return encodeFrame(randomBits(frameBits), stddev);
+}
+
+// The bits packed as by Viterbi::deconvolve
+static std::vector<uint8_t> packBits(const std::vector<uint8_t>& bits)
+{
+    std::vector<uint8_t> packed(bits.size() / 8);
+    for (size_t i = 0; i < bits.size(); i++) {
+        packed[i / 8] |= bits[i] << (7 - i % 8);
+    }
+    return packed;
+}
+
+// The soft bits the puncturing schedule keeps
+static std::vector<int16_t> puncture(const std::vector<int16_t>& softBits,
+        const PunctureSchedule& schedule)
+{
+    std::vector<int16_t> transmitted;
+    size_t i = 0;
+    for (const auto& run : schedule.getRuns()) {
+        transmitted.insert(transmitted.end(), softBits.begin() + i,
+                softBits.begin() + i + run.kept);
+        i += run.kept + run.punctured;
+    }
+    return transmitted;
+}
+
+// Number of bits in which the packed frames a and b differ
+static int countBitDifferences(const std::vector<uint8_t>& a,
+        const std::vector<uint8_t>& b)
+{
+    int differences = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        differences += std::bitset<8>(a[i] ^ b[i]).count();
+    }
+    return differences;
+}
+
+void KernelTests::addSimdLevels()
+{
+    QTest::addColumn<int>("level");
+    for (const auto level : { SimdLevel::Generic, SimdLevel::SSE2,
+            SimdLevel::AVX2, SimdLevel::NEON }) {
+        QTest::newRow(simdLevelName(level)) << (int)level;
+    }
+}
+
+// The level of the data row, the test is skipped if the CPU lacks it
+#define FETCH_SIMD_LEVEL(var) \
+    QFETCH(int, level); \
+    const SimdLevel var = (SimdLevel)level; \
+    if (not simdLevelSupported(var)) { \
+        QSKIP("Not supported by this CPU"); \
+    }
+
+void KernelTests::testViterbiSimd_data()
+{
+    addSimdLevels();
+}
+
+void KernelTests::testViterbiSimd()
+{
+    FETCH_SIMD_LEVEL(simdLevel);
+
+    // FIC, and the MSC of a 64 and a 384 kbps subchannel
+    for (const int16_t frameBits : { 768, 24 * 64, 24 * 384 }) {
+        for (const double stddev : { 40.0, 100.0, 160.0 }) {
+            Viterbi generic(frameBits, SimdLevel::Generic);
+            Viterbi viterbi(frameBits, simdLevel);
+            QVERIFY(viterbi.getSimdLevel() == simdLevel);
+
+            std::vector<uint8_t> reference(frameBits / 8);
+            std::vector<uint8_t> out(frameBits / 8);
+            for (int n = 0; n < 8; n++) {
+                const auto softBits = makeCodedFrame(frameBits, stddev);
+                generic.deconvolve(softBits.data(), reference.data());
+                viterbi.deconvolve(softBits.data(), out.data());
+                QCOMPARE(countBitDifferences(out, reference), 0);
+            }
+        }
+    }
+}
+
+void KernelTests::testStreamingViterbi_data()
+{
+    addSimdLevels();
+}
+
+void KernelTests::testStreamingViterbi()
+{
+    FETCH_SIMD_LEVEL(simdLevel);
+
+    // The streaming decoder decides the bits with a window of limited
+    // length. Its bit error rate must be within the statistical noise of
+    // the decoder tracing back over the whole frame.
+    for (const int16_t frameBits : { 768, 24 * 128, 24 * 384 }) {
+        Viterbi block(frameBits, simdLevel);
+        Viterbi streaming(frameBits, simdLevel, true);
+        std::vector<uint8_t> outBlock(frameBits / 8);
+        std::vector<uint8_t> outStreaming(frameBits / 8);
+
+        for (const double stddev : { 100.0, 140.0, 160.0, 180.0 }) {
+            int errorsBlock = 0;
+            int errorsStreaming = 0;
+            for (int n = 0; n < 50; n++) {
+                const auto bits = randomBits(frameBits);
+                const auto softBits = encodeFrame(bits, stddev);
+                const auto data = packBits(bits);
+                block.deconvolve(softBits.data(), outBlock.data());
+                streaming.deconvolve(softBits.data(), outStreaming.data());
+                errorsBlock += countBitDifferences(outBlock, data);
+                errorsStreaming += countBitDifferences(outStreaming, data);
+            }
+
+            // Three binomial standard deviations of the difference
+            const double tolerance = 3 * std::sqrt(2.0 * errorsBlock) + 1;
+            QVERIFY(std::fabs(errorsStreaming - errorsBlock) <= tolerance);
+        }
+    }
+}
+
+void KernelTests::testViterbiBatch_data()
+{
+    addSimdLevels();
+}
+
+void KernelTests::testViterbiBatch()
+{
+    FETCH_SIMD_LEVEL(simdLevel);
+
+    // Subchannels of the same rate that fill whole passes, and of
+    // different rates, some of them punctured with EEP 3-A
+    const std::vector<std::vector<int> > multiplexes = {
+        { 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128 },
+        { 96, 64, 128, 72, 88, 48, 128, 80, 56, 64, 96, 112, 64, 80, 48 } };
+
+    ViterbiBatch batch(simdLevel);
+    for (const auto& bitrates : multiplexes) {
+        const size_t num = bitrates.size();
+        std::vector<std::unique_ptr<Viterbi> > viterbis;
+        std::vector<std::vector<int16_t> > inputs(num);
+        std::vector<std::vector<uint8_t> > reference(num);
+        std::vector<std::vector<uint8_t> > out(num);
+        std::vector<ViterbiFrame> frames(num);
+        for (size_t n = 0; n < num; n++) {
+            const int16_t frameBits = 24 * bitrates[n];
+            const auto softBits = makeCodedFrame(frameBits, 140.0);
+            reference[n].resize(frameBits / 8);
+            out[n].resize(frameBits / 8);
+
+            if (n % 3 == 2) {
+                const auto& schedule =
+                    EEPProtection::getSchedule(bitrates[n], true, 3);
+                inputs[n] = puncture(softBits, schedule);
+                EEPProtection eep(bitrates[n], true, 3);
+                eep.deconvolve(inputs[n].data(), inputs[n].size(),
+                        reference[n].data());
+                frames[n].schedule = &schedule;
+            }
+            else {
+                inputs[n] = softBits;
+                Viterbi generic(frameBits, SimdLevel::Generic);
+                generic.deconvolve(inputs[n].data(), reference[n].data());
+            }
+
+            viterbis.emplace_back(
+                    std::make_unique<Viterbi>(frameBits, simdLevel));
+            frames[n].viterbi = viterbis[n].get();
+            frames[n].input = inputs[n].data();
+            frames[n].output = out[n].data();
+        }
+
+        batch.decodeFrames(frames.data(), num);
+        for (size_t n = 0; n < num; n++) {
+            QCOMPARE(countBitDifferences(out[n], reference[n]), 0);
+        }
+    }
+
+    // The frames did not all fall back to the per-frame decoder
+    if (batch.numLanes() > 1) {
+        QVERIFY(batch.getStats().passes > 0);
+    }
+}
+
+void KernelTests::testDepunctureSchedule()
+{
+    // The protections insert the punctured bits while decoding. This
+    // must give the bits of scattering the transmitted bits into the
+    // mother code with the PI tables first, the punctured bits being
+    // soft bits of 0.
+    struct Profile {
+        int16_t bitRate;
+        std::unique_ptr<Protection> protection;
+        // (L, PI) pairs of the profile
+        std::vector<std::pair<int16_t, int16_t> > blocks;
+    };
+
+    std::vector<Profile> profiles;
+    profiles.push_back({128, std::unique_ptr<Protection>(
+                new EEPProtection(128, true, 3)),
+            {{6 * 128 / 8 - 3, 8}, {3, 7}}});
+    profiles.push_back({64, std::unique_ptr<Protection>(
+                new EEPProtection(64, false, 1)),
+            {{24 * 64 / 32 - 3, 10}, {3, 9}}});
+    profiles.push_back({128, std::unique_ptr<Protection>(
+                new UEPProtection(128, 3)),
+            {{11, 16}, {22, 9}, {60, 6}, {3, 10}}});
+
+    for (auto& profile : profiles) {
+        const int16_t frameBits = 24 * profile.bitRate;
+
+        std::vector<bool> kept;
+        for (const auto& b : profile.blocks) {
+            const int8_t *pi = getPCodes(b.second - 1);
+            for (int i = 0; i < b.first * 128; i++) {
+                kept.push_back(pi[i % 32] != 0);
+            }
+        }
+        for (int i = 0; i < 24; i++) {
+            kept.push_back(PI_X[i] != 0);
+        }
+
+        Viterbi viterbi(frameBits);
+        std::vector<uint8_t> reference(frameBits / 8);
+        std::vector<uint8_t> out(frameBits / 8);
+        for (int n = 0; n < 8; n++) {
+            const auto softBits = makeCodedFrame(frameBits, 60.0);
+            std::vector<int16_t> transmitted;
+            std::vector<int16_t> viterbiBlock(kept.size(), 0);
+            for (size_t i = 0; i < kept.size(); i++) {
+                if (kept[i]) {
+                    transmitted.push_back(softBits[i]);
+                    viterbiBlock[i] = softBits[i];
+                }
+            }
+
+            viterbi.deconvolve(viterbiBlock.data(), reference.data());
+            profile.protection->deconvolve(transmitted.data(),
+                    transmitted.size(), out.data());
+            QCOMPARE(countBitDifferences(out, reference), 0);
+        }
+    }
+}
+
+void KernelTests::testSoftOutput_data()
+{
+    addSimdLevels();
+}
+
+void KernelTests::testSoftOutput()
+{
+    FETCH_SIMD_LEVEL(simdLevel);
+
+    // The SIMD kernels must rate the bytes exactly as the generic code
+    const int16_t frameBits = 24 * 64;
+    Viterbi generic(frameBits, SimdLevel::Generic);
+    Viterbi viterbi(frameBits, simdLevel);
+    generic.setSoftOutput(true);
+    viterbi.setSoftOutput(true);
+
+    std::vector<uint8_t> reference(frameBits / 8);
+    std::vector<uint8_t> out(frameBits / 8);
+    for (int n = 0; n < 16; n++) {
+        const auto softBits = makeCodedFrame(frameBits, 160.0);
+        generic.deconvolve(softBits.data(), reference.data());
+        viterbi.deconvolve(softBits.data(), out.data());
+        QCOMPARE(countBitDifferences(out, reference), 0);
+
+        const uint8_t *r = generic.getByteReliability();
+        const uint8_t *s = viterbi.getByteReliability();
+        QVERIFY(std::equal(r, r + frameBits / 8, s));
+    }
+}
+
+void KernelTests::testEnergyDispersal_data()
+{
+    addSimdLevels();
+}
+
+void KernelTests::testEnergyDispersal()
+{
+    FETCH_SIMD_LEVEL(simdLevel);
+
+    EnergyDispersal dispersal(simdLevel);
+    QVERIFY(dispersal.getSimdLevel() == simdLevel);
+
+    std::uniform_int_distribution<int> bit(0, 1);
+    for (const int frameBits : { 768, 24 * 64, 24 * 384 }) {
+        // Reference: the PRBS one bit at a time, on unpacked bits
+        std::vector<uint8_t> bits(frameBits);
+        std::vector<uint8_t> packed(frameBits / 8);
+        std::vector<uint8_t> reference(frameBits / 8);
+        uint8_t shiftRegister[9];
+        memset(shiftRegister, 1, 9);
+        for (int i = 0; i < frameBits; i++) {
+            bits[i] = bit(random_generator);
+            const uint8_t prbs = shiftRegister[8] ^ shiftRegister[4];
+            for (int j = 8; j > 0; j--) {
+                shiftRegister[j] = shiftRegister[j - 1];
+            }
+            shiftRegister[0] = prbs;
+
+            packed[i / 8] |= bits[i] << (7 - i % 8);
+            reference[i / 8] |= (bits[i] ^ prbs) << (7 - i % 8);
+        }
+
+        dispersal.dedisperse(packed.data(), packed.size());
+        QCOMPARE(countBitDifferences(packed, reference), 0);
+    }
+}
+
+// Superframes of random RS(120, 110) codewords, with some bytes corrupted
+static std::vector<std::vector<uint8_t> > makeSuperframes(void *rs,
+        int subchIndex, int corrupted)
+{
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> codeword(0, subchIndex - 1);
+    std::uniform_int_distribution<int> position(0, 119);
+
+    std::vector<std::vector<uint8_t> > superframes(50);
+    for (auto& sf : superframes) {
+        sf.resize(120 * subchIndex);
+        for (int i = 0; i < subchIndex; i++) {
+            uint8_t packet[120];
+            for (int pos = 0; pos < 110; pos++) {
+                packet[pos] = byte(random_generator);
+            }
+            encode_rs_char(rs, packet, packet + 110);
+            for (int pos = 0; pos < 120; pos++) {
+                sf[pos * subchIndex + i] = packet[pos];
+            }
+        }
+        for (int e = 0; e < corrupted; e++) {
+            sf[position(random_generator) * subchIndex +
+                codeword(random_generator)] ^= 1 + byte(random_generator) % 255;
+        }
+    }
+    return superframes;
+}
+
+void KernelTests::testRSSyndromes_data()
+{
+    addSimdLevels();
+}
+
+void KernelTests::testRSSyndromes()
+{
+    FETCH_SIMD_LEVEL(simdLevel);
+
+    // The kernels must find exactly the codewords libfec does not accept
+    // as they are
+    RSSyndromes syndromes(simdLevel);
+    QVERIFY(syndromes.getSimdLevel() == simdLevel);
+
+    void *rs = init_rs_char(8, 0x11D, 0, 1, 10, 135);
+    for (const int bitRate : { 48, 96, 192 }) {
+        const int subchIndex = bitRate / 8;
+        for (const int corrupted : { 0, 2, 20 }) {
+            for (const auto& sf : makeSuperframes(rs, subchIndex, corrupted)) {
+                std::vector<uint8_t> errors(subchIndex);
+                syndromes.check(sf.data(), subchIndex, errors.data());
+                for (int i = 0; i < subchIndex; i++) {
+                    uint8_t packet[120];
+                    for (int pos = 0; pos < 120; pos++) {
+                        packet[pos] = sf[pos * subchIndex + i];
+                    }
+                    const bool libfecErrors =
+                        decode_rs_char(rs, packet, nullptr, 0) != 0;
+                    QCOMPARE(errors[i] != 0, libfecErrors);
+                }
+            }
+        }
+    }
+    free_rs_char(rs);
+}
+
+void KernelTests::testRSDecoder()
+{
+    // The RSDecoder runs libfec only on the codewords with errors, it
+    // must correct the superframes as libfec on every codeword does
+    void *rs = init_rs_char(8, 0x11D, 0, 1, 10, 135);
+    RSDecoder rsDecoder;
+    for (const int bitRate : { 48, 96, 192 }) {
+        const int subchIndex = bitRate / 8;
+        const size_t sfLen = 120 * subchIndex;
+        for (const int corrupted : { 0, 2, 20 }) {
+            for (auto sf : makeSuperframes(rs, subchIndex, corrupted)) {
+                std::vector<uint8_t> reference = sf;
+                for (int i = 0; i < subchIndex; i++) {
+                    int corrPos[10];
+                    uint8_t packet[120];
+                    for (int pos = 0; pos < 120; pos++) {
+                        packet[pos] = reference[pos * subchIndex + i];
+                    }
+                    const int count = decode_rs_char(rs, packet, corrPos, 0);
+                    for (int j = 0; j < count; j++) {
+                        const int pos = corrPos[j] - 135;
+                        if (pos >= 0) {
+                            reference[pos * subchIndex + i] = packet[pos];
+                        }
+                    }
+                }
+
+                int corrections = 0;
+                bool uncorrectable = false;
+                rsDecoder.DecodeSuperframe(sf.data(), sfLen, corrections,
+                        uncorrectable);
+                QVERIFY(sf == reference);
+            }
+        }
+    }
+    free_rs_char(rs);
+}
+
+void KernelTests::testFibCrc()
+{
+    // FIBs with a valid CRC, and FIBs with one bit flipped. The CRC over
+    // the packed bytes must agree with the bit by bit CRC over the
+    // unpacked bits, and the packed bit reader with the unpacked one.
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> position(0, 255);
+
+    for (int n = 0; n < 100; n++) {
+        uint8_t fib[32];
+        for (int i = 0; i < 30; i++) {
+            fib[i] = byte(random_generator);
+        }
+        const uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(fib, 30);
+        fib[30] = crc >> 8;
+        fib[31] = crc & 0xFF;
+        if (n % 2) {
+            const int bit = position(random_generator);
+            fib[bit / 8] ^= 0x80 >> (bit % 8);
+        }
+
+        uint8_t fibBits[256];
+        for (int i = 0; i < 256; i++) {
+            fibBits[i] = (fib[i / 8] >> (7 - i % 8)) & 1;
+        }
+
+        const bool packedOk = CalcCRC::CalcCRC_CRC16_CCITT.Calc(fib, 30) ==
+            ((fib[30] << 8) | fib[31]);
+        QCOMPARE(packedOk, n % 2 == 0);
+        QCOMPARE(check_CRC_bits(fibBits, 256), packedOk);
+
+        int bitsMismatches = 0;
+        for (int offset = 0; offset < 256; offset++) {
+            for (int size = 1; size <= 32 and offset + size <= 256; size++) {
+                bitsMismatches += getPackedBits(fib, offset, size) !=
+                    getBits(fibBits, offset, size);
+            }
+        }
+        QCOMPARE(bitsMismatches, 0);
+    }
+}
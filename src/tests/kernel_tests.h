@@ -0,0 +1,54 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __KERNEL_TESTS__
+#define __KERNEL_TESTS__
+
+#include <QtTest>
+
+/* The optimised kernels must give exactly the results of the code they
+ * replace. Each test runs every kernel the CPU supports, the others are
+ * skipped. The throughput is measured by welle-cli -t. */
+class KernelTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testViterbiSimd_data();
+    void testViterbiSimd();
+    void testStreamingViterbi_data();
+    void testStreamingViterbi();
+    void testViterbiBatch_data();
+    void testViterbiBatch();
+    void testDepunctureSchedule();
+    void testSoftOutput_data();
+    void testSoftOutput();
+    void testEnergyDispersal_data();
+    void testEnergyDispersal();
+    void testRSSyndromes_data();
+    void testRSSyndromes();
+    void testRSDecoder();
+    void testFibCrc();
+
+private:
+    void addSimdLevels();
+};
+
+#endif
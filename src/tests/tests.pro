@@ -9,4 +9,8 @@ CONFIG -= app_bundle
 TEMPLATE = app
 
 SOURCES += \  
-    backend_tests.cpp
+    backend_tests.cpp \
+    kernel_tests.cpp
+
+HEADERS += \
+    kernel_tests.h
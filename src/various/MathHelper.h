@@ -219,4 +219,24 @@ static inline uint16_t getBits_8(const uint8_t* d, int16_t offset)
     return res;
 }
 
+// Read size bits, MSB first, starting at bit offset of the packed bytes d.
+// Only the bytes holding these bits are read.
+static inline uint32_t getPackedBits(const uint8_t* d, int32_t offset, uint8_t size)
+{
+    if (size > 32) {
+        throw std::logic_error("getPackedBits called with size>32");
+    }
+
+    const uint8_t *p = d + (offset >> 3);
+    const int shift = offset & 7;
+    const int numBytes = (shift + size + 7) >> 3;
+
+    uint64_t res = 0;
+    for (int i = 0; i < numBytes; i++) {
+        res = (res << 8) | p[i];
+    }
+    res >>= numBytes * 8 - shift - size;
+    return res & ((uint64_t(1) << size) - 1);
+}
+
 #endif // MATHHELPER_H
@@ -0,0 +1,107 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "cpu_features.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+bool simdLevelSupported(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Generic:
+            return true;
+#if defined(SIMD_X86)
+        case SimdLevel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case SimdLevel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(SIMD_NEON)
+        case SimdLevel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Generic: return "generic";
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+static SimdLevel bestSimdLevel()
+{
+    const SimdLevel levels[] = {
+        SimdLevel::AVX2, SimdLevel::NEON, SimdLevel::SSE2 };
+
+    for (const auto l : levels) {
+        if (simdLevelSupported(l)) {
+            return l;
+        }
+    }
+    return SimdLevel::Generic;
+}
+
+SimdLevel detectSimdLevel()
+{
+    static const SimdLevel level = []() {
+        SimdLevel l = bestSimdLevel();
+
+        const char *forced = getenv("WELLE_SIMD");
+        if (forced) {
+            const SimdLevel all[] = {
+                SimdLevel::Generic, SimdLevel::SSE2,
+                SimdLevel::AVX2, SimdLevel::NEON };
+            bool found = false;
+            for (const auto f : all) {
+                if (strcmp(forced, simdLevelName(f)) == 0) {
+                    found = true;
+                    if (simdLevelSupported(f)) {
+                        l = f;
+                    }
+                    else {
+                        std::clog << "cpu-features: " << forced <<
+                            " not supported by this CPU" << std::endl;
+                    }
+                }
+            }
+
+            if (not found) {
+                std::clog << "cpu-features: unknown WELLE_SIMD value " <<
+                    forced << std::endl;
+            }
+        }
+
+        std::clog << "cpu-features: using " << simdLevelName(l) <<
+            " kernels" << std::endl;
+        return l;
+    }();
+
+    return level;
+}
@@ -0,0 +1,54 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __CPU_FEATURES__
+#define __CPU_FEATURES__
+
+// Selection of the SIMD kernels used by the DSP code.
+//
+// On x86, the kernels are compiled with function target attributes,
+// so that the binary still runs on CPUs without AVX2, and the best
+// one is chosen at runtime. NEON kernels are only built with the
+// NEON_KERNELS build option, and when the compiler targets NEON anyway
+// (always the case on aarch64). They have not been verified on ARM
+// yet, src/tests compares them with the generic kernels.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define SIMD_X86 1
+#  define SIMD_TARGET(t) __attribute__((target(t)))
+#endif
+
+#if defined(NEON_KERNELS) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#  define SIMD_NEON 1
+#endif
+
+enum class SimdLevel { Generic, SSE2, AVX2, NEON };
+
+// Returns the best level supported by this CPU. The environment
+// variable WELLE_SIMD=generic|sse2|avx2|neon can be used to force a lower
+// level, e.g. to compare the kernels with each other.
+SimdLevel detectSimdLevel(void);
+
+// Returns true if the kernels for the given level can run on this CPU
+bool simdLevelSupported(SimdLevel level);
+
+const char *simdLevelName(SimdLevel level);
+
+#endif
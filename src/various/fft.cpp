@@ -57,6 +57,61 @@ void Forward::do_FFT()
     FFTW_EXECUTE (plan);
 }
 
+ForwardBatch::ForwardBatch(int32_t fft_size, int32_t batch_size,
+        int32_t distance) :
+    fft_size(fft_size),
+    batch_size(batch_size),
+    distance(distance)
+{
+    const size_t input_size = (batch_size - 1) * distance + fft_size;
+    input = (DSPCOMPLEX *)FFTW_MALLOC(sizeof(DSPCOMPLEX) * input_size);
+    output = (DSPCOMPLEX *)FFTW_MALLOC(
+            sizeof(DSPCOMPLEX) * fft_size * batch_size);
+    memset((void*)input, 0, sizeof(DSPCOMPLEX) * input_size);
+
+    plan = FFTW_PLAN_MANY_DFT(1, &fft_size, batch_size,
+            reinterpret_cast<fftwf_complex*>(input), NULL, 1, distance,
+            reinterpret_cast<fftwf_complex*>(output), NULL, 1, fft_size,
+            FFTW_FORWARD, FFTW_ESTIMATE);
+}
+
+ForwardBatch::~ForwardBatch()
+{
+    FFTW_DESTROY_PLAN(plan);
+    FFTW_FREE(input);
+    FFTW_FREE(output);
+}
+
+DSPCOMPLEX* ForwardBatch::getVector(int32_t i)
+{
+    return output + i * fft_size;
+}
+
+void ForwardBatch::do_FFT(const DSPCOMPLEX * const *in)
+{
+    // The plan can be applied to other arrays only if they have
+    // the same layout and alignment as the ones it was created for
+    bool direct = fftwf_alignment_of((float*)in[0]) ==
+        fftwf_alignment_of((float*)input);
+    for (int32_t i = 1; i < batch_size and direct; i++) {
+        direct = (in[i] == in[0] + i * distance);
+    }
+
+    if (direct) {
+        // Out-of-place complex transforms do not modify their input
+        FFTW_EXECUTE_DFT(plan,
+                reinterpret_cast<fftwf_complex*>(
+                    const_cast<DSPCOMPLEX*>(in[0])),
+                reinterpret_cast<fftwf_complex*>(output));
+    }
+    else {
+        for (int32_t i = 0; i < batch_size; i++) {
+            memcpy(input + i * distance, in[i], fft_size * sizeof(DSPCOMPLEX));
+        }
+        FFTW_EXECUTE(plan);
+    }
+}
+
 Backward::Backward(int32_t fft_size) :
     fft_size(fft_size)
 {
@@ -125,6 +180,37 @@ void Forward::do_FFT()
     memcpy(fin, fout, fft_size * sizeof(DSPCOMPLEX));
 }
 
+ForwardBatch::ForwardBatch(int32_t fft_size, int32_t batch_size,
+        int32_t distance) :
+    fft_size(fft_size),
+    batch_size(batch_size)
+{
+    (void)distance;
+    cfg = kiss_fft_alloc(fft_size, 0, NULL, NULL);
+
+    fout = (DSPCOMPLEX*)malloc(fft_size * batch_size * sizeof(DSPCOMPLEX));
+    memset((void*)fout, 0, fft_size * batch_size * sizeof(DSPCOMPLEX));
+}
+
+ForwardBatch::~ForwardBatch()
+{
+    free(cfg);
+    free(fout);
+}
+
+DSPCOMPLEX* ForwardBatch::getVector(int32_t i)
+{
+    return fout + i * fft_size;
+}
+
+void ForwardBatch::do_FFT(const DSPCOMPLEX * const *in)
+{
+    for (int32_t i = 0; i < batch_size; i++) {
+        kiss_fft(cfg, (const kiss_fft_cpx*)in[i],
+                (kiss_fft_cpx*)(fout + i * fft_size));
+    }
+}
+
 Backward::Backward(int32_t fft_size) :
     fft_size(fft_size)
 {
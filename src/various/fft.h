@@ -42,6 +42,8 @@ namespace fft {
 #  define FFTW_FREE       fftwf_free
 #  define FFTW_PLAN       fftwf_plan
 #  define FFTW_EXECUTE        fftwf_execute
+#  define FFTW_PLAN_MANY_DFT  fftwf_plan_many_dft
+#  define FFTW_EXECUTE_DFT    fftwf_execute_dft
 #  include <fftw3.h>
 
 class Forward {
@@ -58,6 +60,35 @@ class Forward {
         FFTW_PLAN plan;
 };
 
+/* Forward FFTs of a batch of vectors in one call, e.g. all FIC
+ * symbols of a frame.
+ *
+ * The plan expects the input vectors to be spaced by distance samples,
+ * which lets the caller skip the guard interval of symbols stored next
+ * to each other. Input vectors that are not laid out that way are
+ * gathered into an internal buffer first. */
+class ForwardBatch
+{
+    public:
+        ForwardBatch(int32_t fft_size, int32_t batch_size, int32_t distance);
+        ForwardBatch(const ForwardBatch&) = delete;
+        ForwardBatch& operator=(const ForwardBatch&) = delete;
+        ~ForwardBatch(void);
+        int32_t getBatchSize(void) const { return batch_size; }
+        // Result of the transform of in[i]
+        DSPCOMPLEX *getVector(int32_t i);
+        // Transform in[0] .. in[batch_size - 1], which are not modified
+        void do_FFT(const DSPCOMPLEX * const *in);
+
+    private:
+        int32_t fft_size;
+        int32_t batch_size;
+        int32_t distance;
+        DSPCOMPLEX *input;
+        DSPCOMPLEX *output;
+        FFTW_PLAN plan;
+};
+
 class Backward
 {
     public:
@@ -95,6 +126,27 @@ class Forward
         DSPCOMPLEX *fout;
 };
 
+/* Same interface as the FFTW variant. KISS FFT does not support batches,
+ * the vectors are transformed one by one, without being copied. */
+class ForwardBatch
+{
+    public:
+        ForwardBatch(int32_t fft_size, int32_t batch_size, int32_t distance);
+        ForwardBatch(const ForwardBatch&) = delete;
+        ForwardBatch& operator=(const ForwardBatch&) = delete;
+        ~ForwardBatch(void);
+        int32_t getBatchSize(void) const { return batch_size; }
+        DSPCOMPLEX *getVector(int32_t i);
+        void do_FFT(const DSPCOMPLEX * const *in);
+
+    private:
+        int32_t fft_size;
+        int32_t batch_size;
+
+        kiss_fft_cfg cfg;
+        DSPCOMPLEX *fout;
+};
+
 class Backward
 {
     public:
@@ -0,0 +1,238 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "nco.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(SIMD_X86)
+#  include <immintrin.h>
+#endif
+#if defined(SIMD_NEON)
+#  include <arm_neon.h>
+#endif
+
+// Number of samples after which the rotator is re-seeded from
+// the integer phase accumulator.
+#define RENORMALISE_INTERVAL 1024
+
+struct Rotator {
+    DSPCOMPLEX first[8];    // oscillator value for the first 8 samples
+    DSPCOMPLEX step;        // phase increment for 1, 4 and 8 samples
+    DSPCOMPLEX step4;
+    DSPCOMPLEX step8;
+};
+
+static void rotate_generic(DSPCOMPLEX *v, int32_t n, const Rotator& r)
+{
+    DSPCOMPLEX p = r.first[0];
+    for (int32_t i = 0; i < n; i++) {
+        v[i] *= p;
+        p *= r.step;
+    }
+}
+
+#if defined(SIMD_X86)
+// Multiply interleaved complex floats: [re0, im0, re1, im1]
+SIMD_TARGET("sse2")
+static inline __m128 cmul_sse2(__m128 a, __m128 b)
+{
+    const __m128 b_re = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+    const __m128 b_im = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+    const __m128 a_swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m128 sign = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    return _mm_add_ps(_mm_mul_ps(a, b_re),
+            _mm_mul_ps(_mm_mul_ps(a_swapped, b_im), sign));
+}
+
+SIMD_TARGET("sse2")
+static void rotate_sse2(DSPCOMPLEX *v, int32_t n, const Rotator& r)
+{
+    float *f = reinterpret_cast<float*>(v);
+    const float *first = reinterpret_cast<const float*>(r.first);
+
+    // Two independent rotators to hide the multiplication latency
+    __m128 p0 = _mm_loadu_ps(first);
+    __m128 p1 = _mm_loadu_ps(first + 4);
+    const __m128 step = _mm_setr_ps(
+            r.step4.real(), r.step4.imag(), r.step4.real(), r.step4.imag());
+
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(f + 2 * i, cmul_sse2(_mm_loadu_ps(f + 2 * i), p0));
+        _mm_storeu_ps(f + 2 * i + 4,
+                cmul_sse2(_mm_loadu_ps(f + 2 * i + 4), p1));
+        p0 = cmul_sse2(p0, step);
+        p1 = cmul_sse2(p1, step);
+    }
+
+    float last[8];
+    _mm_storeu_ps(last, p0);
+    _mm_storeu_ps(last + 4, p1);
+    for (int32_t k = 0; i < n; i++, k++) {
+        v[i] *= DSPCOMPLEX(last[2 * k], last[2 * k + 1]);
+    }
+}
+
+SIMD_TARGET("avx2")
+static inline __m256 cmul_avx2(__m256 a, __m256 b)
+{
+    const __m256 b_re = _mm256_moveldup_ps(b);
+    const __m256 b_im = _mm256_movehdup_ps(b);
+    const __m256 a_swapped = _mm256_permute_ps(a, 0xB1);
+    return _mm256_addsub_ps(_mm256_mul_ps(a, b_re),
+            _mm256_mul_ps(a_swapped, b_im));
+}
+
+SIMD_TARGET("avx2")
+static void rotate_avx2(DSPCOMPLEX *v, int32_t n, const Rotator& r)
+{
+    float *f = reinterpret_cast<float*>(v);
+    const float *first = reinterpret_cast<const float*>(r.first);
+
+    // Two independent rotators to hide the multiplication latency
+    __m256 p0 = _mm256_loadu_ps(first);
+    __m256 p1 = _mm256_loadu_ps(first + 8);
+    const __m256 step = _mm256_setr_ps(
+            r.step8.real(), r.step8.imag(), r.step8.real(), r.step8.imag(),
+            r.step8.real(), r.step8.imag(), r.step8.real(), r.step8.imag());
+
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(f + 2 * i,
+                cmul_avx2(_mm256_loadu_ps(f + 2 * i), p0));
+        _mm256_storeu_ps(f + 2 * i + 8,
+                cmul_avx2(_mm256_loadu_ps(f + 2 * i + 8), p1));
+        p0 = cmul_avx2(p0, step);
+        p1 = cmul_avx2(p1, step);
+    }
+
+    float last[16];
+    _mm256_storeu_ps(last, p0);
+    _mm256_storeu_ps(last + 8, p1);
+    for (int32_t k = 0; i < n; i++, k++) {
+        v[i] *= DSPCOMPLEX(last[2 * k], last[2 * k + 1]);
+    }
+}
+#endif
+
+#if defined(SIMD_NEON)
+static void rotate_neon(DSPCOMPLEX *v, int32_t n, const Rotator& r)
+{
+    float *f = reinterpret_cast<float*>(v);
+    float32x4x2_t p = vld2q_f32(reinterpret_cast<const float*>(r.first));
+    const float32x4_t s_re = vdupq_n_f32(r.step4.real());
+    const float32x4_t s_im = vdupq_n_f32(r.step4.imag());
+
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t x = vld2q_f32(f + 2 * i);
+        float32x4x2_t y;
+        y.val[0] = vmlsq_f32(vmulq_f32(x.val[0], p.val[0]), x.val[1], p.val[1]);
+        y.val[1] = vmlaq_f32(vmulq_f32(x.val[0], p.val[1]), x.val[1], p.val[0]);
+        vst2q_f32(f + 2 * i, y);
+
+        float32x4x2_t q;
+        q.val[0] = vmlsq_f32(vmulq_f32(p.val[0], s_re), p.val[1], s_im);
+        q.val[1] = vmlaq_f32(vmulq_f32(p.val[0], s_im), p.val[1], s_re);
+        p = q;
+    }
+
+    float last[8];
+    vst2q_f32(last, p);
+    for (int32_t k = 0; i < n; i++, k++) {
+        v[i] *= DSPCOMPLEX(last[2 * k], last[2 * k + 1]);
+    }
+}
+#endif
+
+NCO::NCO(int32_t sampleRate, SimdLevel level) :
+    sampleRate(sampleRate),
+    level(simdLevelSupported(level) ? level : SimdLevel::Generic)
+{
+}
+
+void NCO::reset()
+{
+    phaseAcc = 0;
+}
+
+DSPCOMPLEX NCO::phasor(int64_t p) const
+{
+    p %= sampleRate;
+    if (p < 0)
+        p += sampleRate;
+    const double angle = 2.0 * M_PI * p / sampleRate;
+    return DSPCOMPLEX(cos(angle), sin(angle));
+}
+
+void NCO::mix(DSPCOMPLEX *v, int32_t n, int32_t phase)
+{
+    if (phase != stepPhase) {
+        stepPhase = phase;
+        step[0] = phasor(-(int64_t)phase);
+        step[1] = phasor(-4 * (int64_t)phase);
+        step[2] = phasor(-8 * (int64_t)phase);
+    }
+
+    Rotator r;
+    r.step  = step[0];
+    r.step4 = step[1];
+    r.step8 = step[2];
+
+    while (n > 0) {
+        const int32_t count = std::min(n, RENORMALISE_INTERVAL);
+
+        //  Like with the oscillator table, the phase is advanced
+        //  before the first sample gets multiplied
+        r.first[0] = phasor(phaseAcc - (int64_t)phase);
+        for (int k = 1; k < 8; k++) {
+            r.first[k] = r.first[k - 1] * r.step;
+        }
+
+        switch (level) {
+#if defined(SIMD_X86)
+            case SimdLevel::SSE2:
+                rotate_sse2(v, count, r);
+                break;
+            case SimdLevel::AVX2:
+                rotate_avx2(v, count, r);
+                break;
+#endif
+#if defined(SIMD_NEON)
+            case SimdLevel::NEON:
+                rotate_neon(v, count, r);
+                break;
+#endif
+            default:
+                rotate_generic(v, count, r);
+                break;
+        }
+
+        int64_t p = (phaseAcc - (int64_t)count * phase) % sampleRate;
+        if (p < 0)
+            p += sampleRate;
+        phaseAcc = p;
+
+        v += count;
+        n -= count;
+    }
+}
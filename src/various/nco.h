@@ -0,0 +1,60 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __NCO__
+#define __NCO__
+
+#include "dab-constants.h"
+#include "cpu_features.h"
+
+/* Numerically controlled oscillator used to shift the input signal
+ * in frequency.
+ *
+ * The phase is kept as an integer number of Hz in [0, sampleRate),
+ * exactly like the index into the former oscillator table, so that
+ * the frequency offset stays Hz-accurate. Within a call the oscillator
+ * is a complex rotator, which is re-seeded from the integer phase
+ * every RENORMALISE_INTERVAL samples to keep amplitude and phase
+ * errors from accumulating. */
+class NCO
+{
+    public:
+        NCO(int32_t sampleRate, SimdLevel level = detectSimdLevel());
+
+        // Multiply v[0] .. v[n-1] in place by exp(j 2pi f t) with
+        // f = -phase Hz.
+        void mix(DSPCOMPLEX *v, int32_t n, int32_t phase);
+
+        void reset(void);
+        SimdLevel getSimdLevel(void) const { return level; }
+
+    private:
+        int32_t sampleRate;
+        SimdLevel level;
+        int32_t phaseAcc = 0;
+
+        // Phase increment over 1, 4 and 8 samples for stepPhase
+        int32_t stepPhase = 0;
+        DSPCOMPLEX step[3] = {1, 1, 1};
+
+        DSPCOMPLEX phasor(int64_t p) const;
+};
+
+#endif
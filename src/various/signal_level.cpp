@@ -0,0 +1,85 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "signal_level.h"
+#include "MathHelper.h"
+#include <cmath>
+
+SignalLevel::SignalLevel(float alpha) :
+    alpha(alpha),
+    logBeta(log(1.0 - alpha))
+{
+    for (int l = 0; l < LANES; l++) {
+        laneWeight[l] = exp((LANES - 1 - l) * logBeta);
+    }
+    betaLanes = exp(LANES * logBeta);
+}
+
+void SignalLevel::fold(float partialSum, int32_t n)
+{
+    level = exp(n * logBeta) * level + alpha * partialSum;
+}
+
+void SignalLevel::update(const float *e, int32_t n)
+{
+    float acc[LANES] = {};
+    const int32_t full = n - n % LANES;
+    for (int32_t i = 0; i < full; i += LANES) {
+        for (int l = 0; l < LANES; l++) {
+            acc[l] = acc[l] * betaLanes + e[i + l] * laneWeight[l];
+        }
+    }
+
+    float sum = 0;
+    for (int l = 0; l < LANES; l++) {
+        sum += acc[l];
+    }
+
+    const float beta = 1 - alpha;
+    for (int32_t i = full; i < n; i++) {
+        sum = sum * beta + e[i];
+    }
+
+    fold(sum, n);
+}
+
+void SignalLevel::update(const DSPCOMPLEX *v, int32_t n)
+{
+    float acc[LANES] = {};
+    const int32_t full = n - n % LANES;
+    for (int32_t i = 0; i < full; i += LANES) {
+        for (int l = 0; l < LANES; l++) {
+            acc[l] = acc[l] * betaLanes + l1_norm(v[i + l]) * laneWeight[l];
+        }
+    }
+
+    float sum = 0;
+    for (int l = 0; l < LANES; l++) {
+        sum += acc[l];
+    }
+
+    const float beta = 1 - alpha;
+    for (int32_t i = full; i < n; i++) {
+        sum = sum * beta + l1_norm(v[i]);
+    }
+
+    fold(sum, n);
+}
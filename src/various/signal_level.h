@@ -0,0 +1,64 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __SIGNAL_LEVEL__
+#define __SIGNAL_LEVEL__
+
+#include "dab-constants.h"
+
+/* Long term average of the signal envelope (the l1 norm of the samples),
+ * updated once per block of samples.
+ *
+ * The result is the same as applying
+ *    level = alpha * l1_norm(v[i]) + (1 - alpha) * level
+ * for every sample, but the sum is split over LANES independent partial
+ * sums that are folded into the level in closed form at the end of the
+ * block:
+ *    level = (1 - alpha)^n * level + alpha * sum((1 - alpha)^(n-1-i) * e[i])
+ * This removes the dependency from one sample to the next, and lets the
+ * compiler vectorise the loop. */
+class SignalLevel
+{
+    public:
+        SignalLevel(float alpha);
+
+        void reset(void) { level = 0; }
+        float get(void) const { return level; }
+
+        // Update with the envelope values e[0] .. e[n-1]
+        void update(const float *e, int32_t n);
+
+        // Update with the samples v[0] .. v[n-1]
+        void update(const DSPCOMPLEX *v, int32_t n);
+
+    private:
+        static const int LANES = 16;
+
+        float alpha;
+        double logBeta;             // log(1 - alpha)
+        float level = 0;
+
+        float laneWeight[LANES];    // (1 - alpha)^(LANES - 1 - lane)
+        float betaLanes;            // (1 - alpha)^LANES
+
+        void fold(float partialSum, int32_t n);
+};
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ *    Copyright (C) 2018
+ *    Matthias P. Braendli (matthias.braendli@mpb.li)
+ *
+ *    This file is part of the welle.io.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __SPSC_QUEUE__
+#define __SPSC_QUEUE__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Bounded queue for a single producer and a single consumer thread.
+ *
+ * The slots are allocated once. The producer fills the slot returned
+ * by writeSlot() in place and publishes it with commitWrite(), the
+ * consumer reads the slot returned by readSlot() and gives it back
+ * with commitRead(). None of these take a lock.
+ *
+ * The waitWriteSlot() and waitReadSlot() variants block until a slot is
+ * available, or until keepWaiting becomes false and interrupt() is
+ * called. They first poll the queue spinCount times, and then sleep on
+ * a condition variable. The mutex is only taken by a thread that is
+ * about to sleep, and by the other side when it has to wake it up. */
+template <class T>
+class SpscQueue
+{
+    public:
+        SpscQueue(size_t capacity, const T& init = T()) :
+            slots(capacity, init) {}
+        SpscQueue(const SpscQueue& other) = delete;
+        SpscQueue& operator=(const SpscQueue& other) = delete;
+
+        size_t capacity(void) const { return slots.size(); }
+
+        void setSpinCount(int count) { spinCount = count; }
+
+        size_t size(void) const {
+            return tail.load(std::memory_order_acquire) -
+                head.load(std::memory_order_acquire);
+        }
+
+        // Producer side. Returns nullptr if the queue is full.
+        T *writeSlot(void) {
+            const size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_seq_cst) == slots.size()) {
+                return nullptr;
+            }
+            return &slots[t % slots.size()];
+        }
+
+        void commitWrite(void) {
+            tail.fetch_add(1, std::memory_order_seq_cst);
+            wake(readerWaiting);
+        }
+
+        T *waitWriteSlot(const std::atomic<bool>& keepWaiting) {
+            return wait(writerWaiting, keepWaiting, [this]() {
+                    return writeSlot(); });
+        }
+
+        // Consumer side. Returns nullptr if the queue is empty.
+        T *readSlot(void) {
+            const size_t h = head.load(std::memory_order_relaxed);
+            if (tail.load(std::memory_order_seq_cst) == h) {
+                return nullptr;
+            }
+            return &slots[h % slots.size()];
+        }
+
+        void commitRead(void) {
+            head.fetch_add(1, std::memory_order_seq_cst);
+            wake(writerWaiting);
+        }
+
+        T *waitReadSlot(const std::atomic<bool>& keepWaiting) {
+            return wait(readerWaiting, keepWaiting, [this]() {
+                    return readSlot(); });
+        }
+
+        // Wake up the waiting threads, so that they can check keepWaiting
+        void interrupt(void) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_all();
+        }
+
+        // Drop all elements. Must only be called by the consumer.
+        void flush(void) {
+            head.store(tail.load(std::memory_order_acquire),
+                    std::memory_order_seq_cst);
+            wake(writerWaiting);
+        }
+
+    private:
+        std::vector<T> slots;
+        std::atomic<size_t> head = ATOMIC_VAR_INIT(0);
+        std::atomic<size_t> tail = ATOMIC_VAR_INIT(0);
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<bool> readerWaiting = ATOMIC_VAR_INIT(false);
+        std::atomic<bool> writerWaiting = ATOMIC_VAR_INIT(false);
+        int spinCount = 0;
+
+        void wake(std::atomic<bool>& waiting) {
+            // Pairs with the store and the check in wait(): either the
+            // waiting thread sees our update, or we see its flag.
+            if (waiting.load(std::memory_order_seq_cst)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+
+        template <class Get>
+        T *wait(std::atomic<bool>& waiting,
+                const std::atomic<bool>& keepWaiting, Get get) {
+            T *slot = get();
+            for (int i = 0; slot == nullptr and i < spinCount; i++) {
+                std::this_thread::yield();
+                slot = get();
+            }
+            if (slot) {
+                return slot;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            waiting.store(true, std::memory_order_seq_cst);
+            cv.wait(lock, [&]() {
+                    slot = get();
+                    return slot != nullptr or not keepWaiting; });
+            waiting.store(false, std::memory_order_relaxed);
+            return slot;
+        }
+};
+
+#endif
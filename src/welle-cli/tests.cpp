@@ -32,15 +32,36 @@
 
 #include "tests.h"
 #include "backend/radio-receiver.h"
+#include "various/nco.h"
+#include "various/fft.h"
+#include "backend/symbol-buffer-pool.h"
+#include "backend/dqpsk-demapper.h"
+#include "backend/coarse-sync.h"
+#include "backend/eep-protection.h"
+#include "backend/uep-protection.h"
+#include "backend/protTables.h"
+#include "backend/viterbi.h"
+#include "backend/viterbi-batch.h"
+#include "backend/dabplus_decoder.h"
+#include "backend/energy_dispersal.h"
+#include "backend/rs-syndromes.h"
+#include "backend/tools.h"
+#include "various/MathHelper.h"
 #include "raw_file.h"
 #include <algorithm>
+#include <bitset>
 #include <numeric>
 #include <random>
 #include <condition_variable>
 #include <deque>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 
 using namespace std;
 
@@ -114,6 +135,56 @@ class ChannelSimulator : public CVirtualInput
             { return parentInput->getDescription() + " with ChannelSimulator"; }
 };
 
+// Plays samples from memory, as fast as they are read, or at the
+// sample rate
+class MemoryInput : public CVirtualInput
+{
+    private:
+        const vector<DSPCOMPLEX>& samples;
+        atomic<size_t> position = ATOMIC_VAR_INIT(0);
+        bool realTime;
+        chrono::steady_clock::time_point start;
+
+    public:
+        MemoryInput(const vector<DSPCOMPLEX>& samples, bool realTime = false) :
+            samples(samples), realTime(realTime) {}
+
+        size_t getPosition(void) const { return position; }
+
+        virtual CDeviceID getID(void) { return CDeviceID::RAWFILE; }
+        virtual void setFrequency(int frequency) { (void)frequency; }
+        virtual int getFrequency(void) const { return 0; }
+        virtual bool restart(void) { return true; }
+        virtual void stop(void) {}
+        virtual void reset(void) {}
+
+        virtual int32_t getSamples(DSPCOMPLEX* buffer, int32_t size)
+        {
+            const size_t pos = position;
+            if (realTime) {
+                if (pos == 0) {
+                    start = chrono::steady_clock::now();
+                }
+                this_thread::sleep_until(start + chrono::microseconds(
+                            (int64_t)((pos + size) * 1e6 / INPUT_RATE)));
+            }
+            const size_t n = min<size_t>(size, samples.size() - pos);
+            copy(samples.begin() + pos, samples.begin() + pos + n, buffer);
+            position = pos + n;
+            return n;
+        }
+
+        virtual vector<DSPCOMPLEX> getSpectrumSamples(int size)
+            { (void)size; return {}; }
+        virtual int32_t getSamplesToRead(void)
+            { return samples.size() - position; }
+        virtual float getGain() const { return 0; }
+        virtual float setGain(int gain) { (void)gain; return 0; }
+        virtual int getGainCount(void) { return 0; }
+        virtual void setAgc(bool agc) { (void)agc; }
+        virtual std::string getDescription(void) { return "Memory"; }
+};
+
 class TestRadioInterface : public RadioControllerInterface {
     private:
         struct FILEDeleter{ void operator()(FILE* fd){ if (fd) fclose(fd); }};
@@ -154,7 +225,17 @@ class TestRadioInterface : public RadioControllerInterface {
         }
 
         virtual void onDateTimeUpdate(const dab_date_time_t& dateTime) override { (void)dateTime; }
-        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override { (void)crcCheckOk; (void)fib; }
+        virtual void onFIBDecoded(bool crcCheckOk, const uint8_t* fib) override
+        {
+            (void)fib;
+            if (crcCheckOk) {
+                fib_crc_ok = true;
+                num_fibs_ok++;
+            }
+            else {
+                num_fib_errors++;
+            }
+        }
         virtual void onNewImpulseResponse(std::vector<float>&& data) override
         {
             if (data.size() != 2048) {
@@ -167,6 +248,16 @@ class TestRadioInterface : public RadioControllerInterface {
 
         virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
         virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
+        virtual void onSymbolQueueOverrun(const symbol_queue_stats_t& stats) override
+        {
+            num_overrun_reports++;
+            (void)stats;
+        }
+        virtual void onSyncMilestones(const sync_milestones_t& m) override
+        {
+            num_milestone_reports++;
+            (void)m;
+        }
         virtual void onMessage(message_level_t level, const std::string& text) override
         {
             switch (level) {
@@ -182,6 +273,11 @@ class TestRadioInterface : public RadioControllerInterface {
         virtual void onTIIMeasurement(tii_measurement_t&& m) override { (void)m; }
         size_t num_syncs = 0;
         size_t num_desyncs = 0;
+        size_t num_overrun_reports = 0;
+        atomic<size_t> num_milestone_reports = ATOMIC_VAR_INIT(0);
+        atomic<bool> fib_crc_ok = ATOMIC_VAR_INIT(false);
+        atomic<size_t> num_fibs_ok = ATOMIC_VAR_INIT(0);
+        atomic<size_t> num_fib_errors = ATOMIC_VAR_INIT(0);
         chrono::steady_clock::time_point first_sync_time;
 };
 
@@ -224,6 +320,20 @@ class   TestProgrammeHandler: public ProgrammeHandlerInterface {
         virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) override {
             cout << "X-PAD length mismatch, expected: " << announced_xpad_len << " got: " << xpad_len << endl;
         }
+
+        virtual void onFrameOverflow(const frame_overflow_stats_t& stats) override {
+            lock_guard<mutex> lock(overflowMutex);
+            overflow = stats;
+        }
+
+        frame_overflow_stats_t getOverflow() {
+            lock_guard<mutex> lock(overflowMutex);
+            return overflow;
+        }
+
+    private:
+        mutex overflowMutex;
+        frame_overflow_stats_t overflow;
 };
 
 Tests::Tests(std::unique_ptr<CVirtualInput>& interface, RadioReceiverOptions rro) :
@@ -277,6 +387,41 @@ void Tests::test_with_noise_iteration(double stddev)
     cerr << "rsErrorStats (" << tph.rsErrorStats.size() << ") : " <<
         std::accumulate(tph.rsErrorStats.begin(), tph.rsErrorStats.end(), 0)
         << endl;
+    const auto poolStats = rx.getSymbolPoolStats();
+    cerr << "Symbol buffers (" << poolStats.num_slots << " slots) : " <<
+        poolStats.num_acquired << " acquired, " <<
+        poolStats.num_heap_allocations << " heap allocations" << endl;
+    const auto queueStats = rx.getSymbolQueueStats();
+    cerr << "Symbol queue (max " << queueStats.max_queue_depth << "/" <<
+        queueStats.queue_capacity << ") : " << queueStats.overruns <<
+        " overruns, " << queueStats.discarded_frames <<
+        " discarded frames, " << ri.num_overrun_reports << " reports" << endl;
+    const auto m = rx.getSyncMilestones();
+    cerr << "Milestones (ms, " << ri.num_milestone_reports << " reports) : " <<
+        "null " << m.null_detected <<
+        ", PRS " << m.prs_locked <<
+        ", coarse " << m.coarse_corrected <<
+        ", FIB " << m.fib_crc_valid <<
+        ", label " << m.ensemble_label <<
+        ", programme " << m.programme_selected <<
+        ", audio sync " << m.audio_sync <<
+        ", first audio " << m.first_audio << endl;
+    const auto pipelineStats = rx.getDecoderPipelineStats();
+    for (const auto& stage : {make_pair("FIC", pipelineStats.fic),
+                make_pair("MSC", pipelineStats.msc)}) {
+        cerr << stage.first << " stage: " << stage.second.num_symbols <<
+            " symbols, queue depth " << stage.second.queue_depth <<
+            " (max " << stage.second.max_queue_depth << "/" <<
+            stage.second.queue_capacity << "), latency mean " <<
+            stage.second.mean_latency_us << " us, max " <<
+            stage.second.max_latency_us << " us" << endl;
+    }
+    const auto ficStats = rx.getFicDecodeStats();
+    const auto ficBlocks = ficStats.decoded_blocks + ficStats.skipped_blocks;
+    cerr << "FIC blocks : " << ficStats.decoded_blocks << " decoded, " <<
+        ficStats.skipped_blocks << " skipped (" <<
+        (ficBlocks ? 100.0 * ficStats.skipped_blocks / ficBlocks : 0) <<
+        " %), " << rx.getServiceList().size() << " services" << endl;
     cerr << endl;
 }
 
@@ -356,6 +501,1513 @@ void Tests::test_multipath(int test_id)
     fclose(fd);
 }
 
+void Tests::benchmark_oscillator()
+{
+    // Compare the NCO kernels against the oscillator table lookup
+    // the OFDMProcessor used before, on blocks of T_s samples.
+    const int32_t blockSize = 2552;
+    const int numBlocks = 2000;
+    const int32_t phase = -12345;
+
+    vector<DSPCOMPLEX> input(blockSize);
+    normal_distribution<float> distr(0.0, 1.0);
+    for (auto& s : input) {
+        s = DSPCOMPLEX(distr(random_generator), distr(random_generator));
+    }
+
+    vector<DSPCOMPLEX> oscillatorTable(INPUT_RATE);
+    for (int i = 0; i < INPUT_RATE; i++) {
+        oscillatorTable[i] = DSPCOMPLEX(cos(2.0 * M_PI * i / INPUT_RATE),
+                sin(2.0 * M_PI * i / INPUT_RATE));
+    }
+
+    auto run_table = [&](vector<DSPCOMPLEX>& v, int32_t& localPhase) {
+        for (int32_t i = 0; i < blockSize; i++) {
+            localPhase -= phase;
+            localPhase = (localPhase + INPUT_RATE) % INPUT_RATE;
+            v[i] *= oscillatorTable[localPhase];
+        }
+    };
+
+    auto rate = [&](chrono::steady_clock::duration d) {
+        const double s = chrono::duration<double>(d).count();
+        return (double)blockSize * numBlocks / s / 1e6;
+    };
+
+    vector<DSPCOMPLEX> buf(blockSize);
+    int32_t localPhase = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int b = 0; b < numBlocks; b++) {
+        copy(input.begin(), input.end(), buf.begin());
+        run_table(buf, localPhase);
+    }
+    auto t1 = chrono::steady_clock::now();
+    cerr << "Oscillator table: " << rate(t1 - t0) << " MS/s" << endl;
+
+    const SimdLevel levels[] = {
+        SimdLevel::Generic, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+    for (const auto level : levels) {
+        if (not simdLevelSupported(level)) {
+            continue;
+        }
+
+        NCO nco(INPUT_RATE, level);
+
+        // Accuracy, relative to the table, over all blocks
+        vector<DSPCOMPLEX> ref(blockSize);
+        localPhase = 0;
+        float maxError = 0;
+        for (int b = 0; b < numBlocks; b++) {
+            copy(input.begin(), input.end(), buf.begin());
+            copy(input.begin(), input.end(), ref.begin());
+            run_table(ref, localPhase);
+            nco.mix(buf.data(), blockSize, phase);
+            for (int32_t i = 0; i < blockSize; i++) {
+                maxError = max(maxError, abs(buf[i] - ref[i]) / abs(ref[i]));
+            }
+        }
+
+        t0 = chrono::steady_clock::now();
+        for (int b = 0; b < numBlocks; b++) {
+            copy(input.begin(), input.end(), buf.begin());
+            nco.mix(buf.data(), blockSize, phase);
+        }
+        t1 = chrono::steady_clock::now();
+        cerr << "NCO " << simdLevelName(level) << ": " << rate(t1 - t0) <<
+            " MS/s, max relative error " << maxError << endl;
+    }
+}
+
+void Tests::benchmark_fft()
+{
+    // Transform the 72 MSC symbols of TM1 frames stored in a symbol
+    // buffer pool, one by one like before, and in batches.
+    DABParams params(1);
+    const int32_t T_g = params.T_s - params.T_u;
+    const int32_t numSymbols = 72;
+    const int numFrames = 200;
+
+    SymbolBufferPool pool(params.T_s, numSymbols);
+    vector<SymbolBuffer> symbols;
+    normal_distribution<float> distr(0.0, 1.0);
+    for (int32_t i = 0; i < numSymbols; i++) {
+        symbols.push_back(pool.acquire());
+        for (auto& s : symbols.back()) {
+            s = DSPCOMPLEX(distr(random_generator), distr(random_generator));
+        }
+    }
+
+    auto rate = [&](chrono::steady_clock::duration d) {
+        const double s = chrono::duration<double>(d).count();
+        return (double)numSymbols * numFrames / s;
+    };
+
+    fft::Forward single(params.T_u);
+    vector<DSPCOMPLEX> ref(numSymbols * params.T_u);
+    auto t0 = chrono::steady_clock::now();
+    for (int f = 0; f < numFrames; f++) {
+        for (int32_t i = 0; i < numSymbols; i++) {
+            memcpy(single.getVector(), symbols[i].data() + T_g,
+                    params.T_u * sizeof(DSPCOMPLEX));
+            single.do_FFT();
+            if (f == 0) {
+                copy(single.getVector(), single.getVector() + params.T_u,
+                        ref.begin() + i * params.T_u);
+            }
+        }
+    }
+    auto t1 = chrono::steady_clock::now();
+    cerr << "FFT single: " << rate(t1 - t0) << " symbols/s" << endl;
+
+    const int32_t batchSizes[] = { 3, 8, 18, 72 };
+    for (const auto batchSize : batchSizes) {
+        fft::ForwardBatch batch(params.T_u, batchSize, pool.getSlotDistance());
+        vector<const DSPCOMPLEX*> input(batchSize);
+
+        float maxError = 0;
+        t0 = chrono::steady_clock::now();
+        for (int f = 0; f < numFrames; f++) {
+            for (int32_t first = 0; first < numSymbols; first += batchSize) {
+                for (int32_t i = 0; i < batchSize; i++) {
+                    input[i] = symbols[first + i].data() + T_g;
+                }
+                batch.do_FFT(input.data());
+
+                if (f == 0) {
+                    for (int32_t i = 0; i < batchSize; i++) {
+                        for (int32_t k = 0; k < params.T_u; k++) {
+                            maxError = max(maxError, abs(batch.getVector(i)[k] -
+                                        ref[(first + i) * params.T_u + k]));
+                        }
+                    }
+                }
+            }
+        }
+        t1 = chrono::steady_clock::now();
+        cerr << "FFT batch " << batchSize << ": " << rate(t1 - t0) <<
+            " symbols/s, max error " << maxError << endl;
+    }
+}
+
+void Tests::benchmark_demapper()
+{
+    // Compare the demapper kernels against the per-carrier loop
+    // the OfdmDecoder used before, on random TM1 symbols.
+    DABParams params(1);
+    FrequencyInterleaver interleaver(params);
+    const int numSymbols = 20000;
+    const int numDistinct = 16;
+
+    normal_distribution<float> distr(0.0, 1.0);
+    vector<vector<DSPCOMPLEX> > symbols(numDistinct);
+    for (auto& sym : symbols) {
+        sym.resize(params.T_u);
+        for (auto& s : sym) {
+            s = DSPCOMPLEX(distr(random_generator), distr(random_generator));
+        }
+    }
+
+    auto rate = [&](chrono::steady_clock::duration d) {
+        const double s = chrono::duration<double>(d).count();
+        return s / numSymbols * 1e9;
+    };
+
+    vector<int16_t> ref_bits(2 * params.K);
+    vector<DSPCOMPLEX> phaseReference(symbols[0]);
+    auto t0 = chrono::steady_clock::now();
+    for (int n = 0; n < numSymbols; n++) {
+        const auto& c = symbols[n % numDistinct];
+        for (int16_t i = 0; i < params.K; i ++) {
+            int16_t index = interleaver.mapIn(i);
+            if (index < 0)
+                index += params.T_u;
+            const DSPCOMPLEX r1 = c[index] * conj (phaseReference[index]);
+            phaseReference[index] = c[index];
+            const DSPFLOAT ab1 = 127.0f / l1_norm(r1);
+            ref_bits[i]            = -real (r1) * ab1;
+            ref_bits[params.K + i] = -imag (r1) * ab1;
+        }
+    }
+    auto t1 = chrono::steady_clock::now();
+    cerr << "Demapper loop: " << rate(t1 - t0) << " ns/symbol" << endl;
+
+    const SimdLevel levels[] = {
+        SimdLevel::Generic, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+    for (const auto level : levels) {
+        if (not simdLevelSupported(level)) {
+            continue;
+        }
+
+        DqpskDemapper demapper(params, interleaver,
+                OfdmDecoder::constellationDecimation, level);
+        if (demapper.getSimdLevel() != level) {
+            continue;
+        }
+
+        vector<int16_t> bits(2 * params.K);
+        demapper.setReference(symbols[0].data());
+        t0 = chrono::steady_clock::now();
+        for (int n = 0; n < numSymbols; n++) {
+            demapper.demap(symbols[n % numDistinct].data(), bits.data());
+        }
+        t1 = chrono::steady_clock::now();
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < bits.size(); i++) {
+            if (bits[i] != ref_bits[i]) {
+                mismatches++;
+            }
+        }
+        cerr << "Demapper " << simdLevelName(level) << ": " <<
+            rate(t1 - t0) << " ns/symbol, " << mismatches <<
+            " soft bits differ from the loop" << endl;
+    }
+}
+
+void Tests::benchmark_coarse_sync()
+{
+    // Compare the coarse frequency search against the per-offset loops
+    // the OFDMProcessor used before, on synthetic phase reference symbols
+    // with a known offset. Unlike in the OFDMProcessor, where they
+    // resolved to the integer abs(), the loops use std::abs on floats.
+    DABParams params(1);
+    const int32_t T_u = params.T_u;
+    const int numDistinct = 64;
+    const int numRuns = 20000;
+    const int searchRange = 2 * 36;
+    const int correlationLength = 24;
+
+    PhaseReference phaseRef(params, DEFAULT_OFDM_PROCESSOR_THRESHOLD);
+    fft::Backward ifft(T_u);
+    normal_distribution<float> noise(0.0, 0.3);
+    uniform_int_distribution<int> offsets(-30, 30);
+    uniform_real_distribution<float> phases(-M_PI, M_PI);
+
+    vector<vector<DSPCOMPLEX> > prs(numDistinct);
+    vector<int> prsOffset(numDistinct);
+    for (int n = 0; n < numDistinct; n++) {
+        prsOffset[n] = offsets(random_generator);
+        const DSPCOMPLEX rotation = polar(1.0f, phases(random_generator));
+        DSPCOMPLEX *spectrum = ifft.getVector();
+        for (int32_t k = 0; k < T_u; k++) {
+            spectrum[k] = phaseRef[(k - prsOffset[n] + T_u) % T_u] *
+                rotation + DSPCOMPLEX(noise(random_generator),
+                        noise(random_generator));
+        }
+        ifft.do_IFFT();
+        prs[n].assign(spectrum, spectrum + T_u);
+    }
+
+    vector<float> refArg(correlationLength);
+    for (int i = 0; i < correlationLength; i++)  {
+        refArg[i] = arg(phaseRef[(T_u + i) % T_u] *
+                conj(phaseRef[(T_u + i + 1) % T_u]));
+    }
+
+    fft::Forward fft(T_u);
+    DSPCOMPLEX *v = fft.getVector();
+    vector<float> correlationVector(searchRange + correlationLength);
+    auto correlateLoop = [&](const vector<DSPCOMPLEX>& p) {
+        copy(p.begin(), p.end(), v);
+        fft.do_FFT();
+        int index = 100;
+        for (int i = 0; i < searchRange + correlationLength; i++) {
+            int baseIndex = T_u - searchRange / 2 + i;
+            correlationVector[i] = arg(v[baseIndex % T_u] *
+                    conj(v[(baseIndex + 1) % T_u]));
+        }
+        float MMax = 0;
+        for (int i = 0; i < searchRange; i++) {
+            float sum = 0;
+            for (int j = 0; j < correlationLength; j++) {
+                sum += abs(refArg[j] * correlationVector[i + j]);
+                if (sum > MMax) {
+                    MMax = sum;
+                    index = i;
+                }
+            }
+        }
+        return index - searchRange / 2;
+    };
+
+    auto patternLoop = [&](const vector<DSPCOMPLEX>& p) {
+        copy(p.begin(), p.end(), v);
+        fft.do_FFT();
+        int index = 100;
+        float Mmin = 1000;
+        auto d = [&](int a, int b) {
+            return abs(arg(v[a % T_u] * conj(v[b % T_u])));
+        };
+        for (int i = T_u - searchRange / 2; i < T_u + searchRange / 2; i++) {
+            float sum = abs(d(i + 1, i + 2) / M_PI - 1) +
+                abs(d(i + 2, i + 3) / M_PI - 1) +
+                d(i + 3, i + 4) + d(i + 4, i + 5) + d(i + 5, i + 6) +
+                abs(d(i + 17, i + 19) / M_PI - 1) +
+                d(i + 19, i + 20) + d(i + 20, i + 21) + d(i + 21, i + 22);
+            if (sum < Mmin) {
+                Mmin = sum;
+                index = i;
+            }
+        }
+        return index - T_u;
+    };
+
+    auto rate = [&](chrono::steady_clock::duration d) {
+        return chrono::duration<double>(d).count() / numRuns * 1e9;
+    };
+
+    const pair<FreqsyncMethod, const char*> methods[] = {
+        {FreqsyncMethod::CorrelatePRS, "CorrelatePRS"},
+        {FreqsyncMethod::PatternOfZeros, "PatternOfZeros"} };
+    for (const auto& method : methods) {
+        vector<int> ref_result(numDistinct);
+        auto t0 = chrono::steady_clock::now();
+        for (int n = 0; n < numRuns; n++) {
+            const auto& p = prs[n % numDistinct];
+            ref_result[n % numDistinct] =
+                method.first == FreqsyncMethod::CorrelatePRS ?
+                correlateLoop(p) : patternLoop(p);
+        }
+        auto t1 = chrono::steady_clock::now();
+        const double loopRate = rate(t1 - t0);
+
+        CoarseFrequencySync coarseSync(params, phaseRef, method.first, false);
+        vector<int> result(numDistinct);
+        t0 = chrono::steady_clock::now();
+        for (int n = 0; n < numRuns; n++) {
+            result[n % numDistinct] =
+                coarseSync.estimate(prs[n % numDistinct].data());
+        }
+        t1 = chrono::steady_clock::now();
+
+        size_t mismatches = 0;
+        size_t correct = 0;
+        for (int n = 0; n < numDistinct; n++) {
+            if (result[n] != ref_result[n]) mismatches++;
+            if (result[n] == prsOffset[n]) correct++;
+        }
+        cerr << method.second << ": loop " << loopRate << " ns, new " <<
+            rate(t1 - t0) << " ns per PRS, " << mismatches << "/" <<
+            numDistinct << " estimates differ from the loop, " <<
+            correct << " correct" << endl;
+    }
+
+    // Time to lock on the recording given with -f, until the first FIB
+    // passes the CRC check. The samples are read from memory as fast as
+    // the receiver takes them.
+    const size_t maxSamples = 10 * INPUT_RATE;
+    vector<DSPCOMPLEX> samples;
+    auto raw = dynamic_cast<CRAWFile*>(input_interface.get());
+    if (raw == nullptr) {
+        cerr << "Time to lock needs an IQ file" << endl;
+        return;
+    }
+    raw->restart();
+    vector<DSPCOMPLEX> buf(T_u);
+    while (samples.size() < maxSamples and not raw->endWasReached()) {
+        const int32_t n = min<int32_t>(raw->getSamplesToRead(), buf.size());
+        if (n == 0) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+        raw->getSamples(buf.data(), n);
+        samples.insert(samples.end(), buf.begin(), buf.begin() + n);
+    }
+    raw->stop();
+
+    for (const auto& method : methods) {
+        for (const bool useThread : {false, true}) {
+            RadioReceiverOptions options = rro;
+            options.disable_coarse_corrector = false;
+            options.freqsyncMethod = method.first;
+            options.coarseSyncThread = useThread;
+
+            MemoryInput input(samples);
+            TestRadioInterface ri;
+            RadioReceiver rx(ri, input, options);
+            const auto t0 = chrono::steady_clock::now();
+            rx.restart(false);
+            // The receiver stops reading when less than a symbol is left
+            while (not ri.fib_crc_ok and
+                    input.getSamplesToRead() >= params.T_null) {
+                this_thread::sleep_for(chrono::microseconds(200));
+            }
+            const auto t1 = chrono::steady_clock::now();
+
+            cerr << method.second << (useThread ? " with" : " without") <<
+                " helper thread: ";
+            if (ri.fib_crc_ok) {
+                cerr << "lock after " <<
+                    (double)input.getPosition() / params.T_F << " frames, " <<
+                    chrono::duration<double, milli>(t1 - t0).count() <<
+                    " ms" << endl;
+            }
+            else {
+                cerr << "no lock in " << samples.size() / params.T_F <<
+                    " frames" << endl;
+            }
+        }
+    }
+}
+
+// The bits of data, convolutionally encoded with the DAB mother code,
+// including the 6 tail bits, and sent through an AWGN channel with the
+// given standard deviation, for soft bits of +-127.
+static void encode_frame(const vector<uint8_t>& data, double stddev,
+        vector<int16_t>& softBits)
+{
+    const int polys[RATE] = { 0155, 0117, 0123, 0155 };
+    auto parity = [](int x) {
+        int p = 0;
+        for (; x; x >>= 1) {
+            p ^= x & 1;
+        }
+        return p;
+    };
+
+    normal_distribution<double> noise(0.0, stddev);
+
+    const int frameBits = data.size();
+    softBits.resize(RATE * (frameBits + 6));
+    int sr = 0;
+    for (int i = 0; i < frameBits + 6; i++) {
+        const int b = i < frameBits ? data[i] : 0;
+        sr = (sr << 1) | b;
+        for (int k = 0; k < RATE; k++) {
+            const double s = (parity(sr & polys[k]) ? 127 : -127) +
+                noise(random_generator);
+            softBits[i * RATE + k] = std::max(-127.0, std::min(127.0, s));
+        }
+    }
+}
+
+// Random frame of frameBits bits, encoded and sent as by encode_frame
+static void make_coded_frame(int16_t frameBits, double stddev,
+        vector<uint8_t>& data, vector<int16_t>& softBits)
+{
+    uniform_int_distribution<int> bit(0, 1);
+
+    data.resize(frameBits);
+    for (auto& b : data) {
+        b = bit(random_generator);
+    }
+    encode_frame(data, stddev, softBits);
+}
+
+// The bits of data packed as by Viterbi::deconvolve
+static vector<uint8_t> pack_bits(const vector<uint8_t>& bits)
+{
+    vector<uint8_t> packed(bits.size() / 8);
+    for (size_t i = 0; i < bits.size(); i++) {
+        packed[i / 8] |= bits[i] << (7 - i % 8);
+    }
+    return packed;
+}
+
+// Number of bits in which the packed frames a and b differ
+static size_t count_bit_differences(const uint8_t *a, const uint8_t *b,
+        size_t length)
+{
+    size_t differences = 0;
+    for (size_t i = 0; i < length; i++) {
+        differences += bitset<8>(a[i] ^ b[i]).count();
+    }
+    return differences;
+}
+
+void Tests::benchmark_viterbi()
+{
+    // Decode random frames, convolutionally encoded with the DAB mother
+    // code and sent through an AWGN channel, with every Viterbi kernel.
+    // The kernels are checked against the generic one by src/tests.
+    const int numDistinct = 32;
+    // FIC, and the MSC of a 64 and a 384 kbps subchannel
+    const int16_t frameLengths[] = { 768, 24 * 64, 24 * 384 };
+    const double stddevs[] = { 40.0, 100.0, 160.0 };
+
+    const SimdLevel levels[] = {
+        SimdLevel::Generic, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+
+    for (const auto frameBits : frameLengths) {
+        for (const auto stddev : stddevs) {
+            vector<vector<uint8_t> > data(numDistinct);
+            vector<vector<int16_t> > softBits(numDistinct);
+            for (int n = 0; n < numDistinct; n++) {
+                make_coded_frame(frameBits, stddev, data[n], softBits[n]);
+                data[n] = pack_bits(data[n]);
+            }
+
+            const size_t frameLen = frameBits / 8;
+            for (const auto level : levels) {
+                if (not simdLevelSupported(level)) {
+                    continue;
+                }
+                Viterbi viterbi(frameBits, level);
+                if (viterbi.getSimdLevel() != level) {
+                    continue;
+                }
+
+                vector<uint8_t> out(frameLen);
+                size_t bitErrors = 0;
+                for (int n = 0; n < numDistinct; n++) {
+                    viterbi.deconvolve(softBits[n].data(), out.data());
+                    bitErrors += count_bit_differences(out.data(),
+                            data[n].data(), frameLen);
+                }
+
+                // Decode for about a second of CPU time per kernel
+                const int iterations = std::max(1, 2000000 / frameBits);
+                auto t0 = chrono::steady_clock::now();
+                for (int n = 0; n < iterations; n++) {
+                    viterbi.deconvolve(softBits[n % numDistinct].data(),
+                            out.data());
+                }
+                auto t1 = chrono::steady_clock::now();
+                const double s = chrono::duration<double>(t1 - t0).count();
+
+                cerr << "Viterbi " << simdLevelName(level) <<
+                    " frame " << frameBits << " bits, noise " << stddev <<
+                    ": " << iterations * frameBits / s / 1e6 << " Mbit/s, BER " <<
+                    (double)bitErrors / (numDistinct * frameBits) << endl;
+            }
+        }
+    }
+}
+
+void Tests::benchmark_viterbi_batch()
+{
+    // Decode the frames of all subchannels of a multiplex, one at a time
+    // with the best per-frame kernel, and in batches.
+    const int numRounds = 100;
+    const double stddev = 140.0;
+    // Bitrates in kbps of typical multiplexes
+    const vector<vector<int> > multiplexes = {
+        { 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128 },
+        { 96, 64, 128, 72, 88, 48, 128, 80, 56, 64, 96, 112, 64, 80, 48 },
+        { 384, 192, 160, 128 } };
+
+    const SimdLevel levels[] = {
+        SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+
+    for (const auto& bitrates : multiplexes) {
+        const size_t num = bitrates.size();
+        size_t totalBits = 0;
+
+        vector<unique_ptr<Viterbi> > viterbis;
+        vector<vector<uint8_t> > data(num);
+        vector<vector<int16_t> > softBits(num);
+        vector<vector<uint8_t> > out(num);
+        for (size_t n = 0; n < num; n++) {
+            const int16_t frameBits = 24 * bitrates[n];
+            totalBits += frameBits;
+            make_coded_frame(frameBits, stddev, data[n], softBits[n]);
+            out[n].resize(frameBits / 8);
+            viterbis.emplace_back(make_unique<Viterbi>(frameBits));
+        }
+
+        auto mbps = [&](chrono::steady_clock::duration d) {
+            const double s = chrono::duration<double>(d).count();
+            return numRounds * totalBits / s / 1e6;
+        };
+
+        cerr << "Multiplex of " << num << " subchannels, " << totalBits <<
+            " bits per CIF" << endl;
+
+        auto t0 = chrono::steady_clock::now();
+        for (int r = 0; r < numRounds; r++) {
+            for (size_t n = 0; n < num; n++) {
+                viterbis[n]->deconvolve(softBits[n].data(), out[n].data());
+            }
+        }
+        auto t1 = chrono::steady_clock::now();
+        cerr << " One frame at a time (" <<
+            simdLevelName(viterbis[0]->getSimdLevel()) << "): " <<
+            mbps(t1 - t0) << " Mbit/s" << endl;
+
+        for (const auto level : levels) {
+            if (not simdLevelSupported(level)) {
+                continue;
+            }
+
+            ViterbiBatch batch(level);
+            vector<ViterbiFrame> frames(num);
+            for (size_t n = 0; n < num; n++) {
+                frames[n].viterbi = viterbis[n].get();
+                frames[n].input = softBits[n].data();
+                frames[n].output = out[n].data();
+            }
+
+            t0 = chrono::steady_clock::now();
+            for (int r = 0; r < numRounds; r++) {
+                batch.decodeFrames(frames.data(), num);
+            }
+            t1 = chrono::steady_clock::now();
+            cerr << " Batch " << simdLevelName(level) << " (" <<
+                batch.numLanes() << " lanes): " << mbps(t1 - t0) <<
+                " Mbit/s" << endl;
+        }
+    }
+}
+
+void Tests::benchmark_depuncture()
+{
+    // The schedules are built once per process
+    auto t0 = chrono::steady_clock::now();
+    UEPProtection::buildAllSchedules();
+    auto t1 = chrono::steady_clock::now();
+    const double buildTime = chrono::duration<double>(t1 - t0).count();
+    t0 = chrono::steady_clock::now();
+    UEPProtection::buildAllSchedules();
+    t1 = chrono::steady_clock::now();
+    cerr << "Schedules of all UEP profiles: built in " <<
+        buildTime * 1e3 << " ms, then found in " <<
+        chrono::duration<double>(t1 - t0).count() * 1e3 << " ms" << endl;
+
+    // Decode punctured frames with the EEP and UEP protections, and
+    // with depuncturing into the full mother code first.
+    struct Profile {
+        const char *name;
+        int16_t bitRate;
+        std::unique_ptr<Protection> protection;
+        // (L, PI) pairs of the profile
+        vector<pair<int16_t, int16_t> > blocks;
+    };
+
+    vector<Profile> profiles;
+    profiles.push_back({"EEP 3-A", 128,
+            make_unique<EEPProtection>(128, true, 3),
+            {{6 * 128 / 8 - 3, 8}, {3, 7}}});
+    profiles.push_back({"EEP 1-B", 64,
+            make_unique<EEPProtection>(64, false, 1),
+            {{24 * 64 / 32 - 3, 10}, {3, 9}}});
+    profiles.push_back({"UEP 3", 128,
+            make_unique<UEPProtection>(128, 3),
+            {{11, 16}, {22, 9}, {60, 6}, {3, 10}}});
+
+    const int numDistinct = 32;
+    const double stddev = 60.0;
+
+    for (auto& profile : profiles) {
+        const int16_t frameBits = 24 * profile.bitRate;
+
+        vector<bool> kept;
+        for (const auto& b : profile.blocks) {
+            const int8_t *pi = getPCodes(b.second - 1);
+            for (int i = 0; i < b.first * 128; i++) {
+                kept.push_back(pi[i % 32] != 0);
+            }
+        }
+        for (int i = 0; i < 24; i++) {
+            kept.push_back(PI_X[i] != 0);
+        }
+
+        vector<vector<int16_t> > transmitted(numDistinct);
+        for (int n = 0; n < numDistinct; n++) {
+            vector<uint8_t> data;
+            vector<int16_t> softBits;
+            make_coded_frame(frameBits, stddev, data, softBits);
+            for (size_t i = 0; i < kept.size(); i++) {
+                if (kept[i]) {
+                    transmitted[n].push_back(softBits[i]);
+                }
+            }
+        }
+
+        // Reference: the punctured bits are zeros in the mother code
+        Viterbi viterbi(frameBits);
+        vector<int16_t> viterbiBlock(kept.size());
+        auto depuncture_and_decode = [&](const vector<int16_t>& tx,
+                uint8_t *out) {
+            std::fill(viterbiBlock.begin(), viterbiBlock.end(), 0);
+            size_t c = 0;
+            for (size_t i = 0; i < kept.size(); i++) {
+                if (kept[i]) {
+                    viterbiBlock[i] = tx[c++];
+                }
+            }
+            viterbi.deconvolve(viterbiBlock.data(), out);
+        };
+
+        vector<uint8_t> out(frameBits / 8);
+        const int iterations = std::max(1, 4000000 / frameBits);
+        t0 = chrono::steady_clock::now();
+        for (int n = 0; n < iterations; n++) {
+            depuncture_and_decode(transmitted[n % numDistinct], out.data());
+        }
+        t1 = chrono::steady_clock::now();
+        const double separate = chrono::duration<double>(t1 - t0).count();
+
+        t0 = chrono::steady_clock::now();
+        for (int n = 0; n < iterations; n++) {
+            auto& tx = transmitted[n % numDistinct];
+            profile.protection->deconvolve(tx.data(), tx.size(), out.data());
+        }
+        t1 = chrono::steady_clock::now();
+        const double fused = chrono::duration<double>(t1 - t0).count();
+
+        cerr << profile.name << " " << profile.bitRate << " kbps (" <<
+            simdLevelName(viterbi.getSimdLevel()) << "): depuncture then decode " <<
+            iterations * frameBits / separate / 1e6 << " Mbit/s, fused " <<
+            iterations * frameBits / fused / 1e6 << " Mbit/s" << endl;
+    }
+}
+
+void Tests::test_streaming_viterbi()
+{
+    // Compare the bit error rate of the streaming decoder, which decides
+    // the bits with a window of limited length, with the decoder tracing
+    // back over the whole frame. src/tests checks that the difference is
+    // within the statistical noise.
+    const int numFrames = 200;
+    const int16_t frameLengths[] = { 768, 24 * 128, 24 * 384 };
+    const double stddevs[] = { 100.0, 140.0, 160.0, 180.0 };
+    const SimdLevel levels[] = { SimdLevel::Generic, detectSimdLevel() };
+
+    for (const auto level : levels) {
+        for (const auto frameBits : frameLengths) {
+            Viterbi block(frameBits, level);
+            Viterbi streaming(frameBits, level, true);
+            cerr << "Viterbi " << simdLevelName(block.getSimdLevel()) <<
+                " frame " << frameBits << " bits, working set " <<
+                block.workingSetSize() << " bytes, streaming " <<
+                streaming.workingSetSize() << " bytes" << endl;
+
+            for (const auto stddev : stddevs) {
+                vector<vector<uint8_t> > data(numFrames);
+                vector<vector<int16_t> > softBits(numFrames);
+                for (int n = 0; n < numFrames; n++) {
+                    make_coded_frame(frameBits, stddev, data[n], softBits[n]);
+                    data[n] = pack_bits(data[n]);
+                }
+
+                auto run = [&](Viterbi& viterbi, vector<vector<uint8_t> >& out) {
+                    out.assign(numFrames, vector<uint8_t>(frameBits / 8));
+                    auto t0 = chrono::steady_clock::now();
+                    for (int n = 0; n < numFrames; n++) {
+                        viterbi.deconvolve(softBits[n].data(), out[n].data());
+                    }
+                    auto t1 = chrono::steady_clock::now();
+                    return numFrames * frameBits /
+                        chrono::duration<double>(t1 - t0).count() / 1e6;
+                };
+
+                vector<vector<uint8_t> > outBlock, outStreaming;
+                const double mbpsBlock = run(block, outBlock);
+                const double mbpsStreaming = run(streaming, outStreaming);
+
+                size_t errorsBlock = 0;
+                size_t errorsStreaming = 0;
+                size_t differences = 0;
+                for (int n = 0; n < numFrames; n++) {
+                    const size_t len = frameBits / 8;
+                    errorsBlock += count_bit_differences(outBlock[n].data(),
+                            data[n].data(), len);
+                    errorsStreaming += count_bit_differences(
+                            outStreaming[n].data(), data[n].data(), len);
+                    differences += count_bit_differences(outBlock[n].data(),
+                            outStreaming[n].data(), len);
+                }
+
+                const double numBits = (double)numFrames * frameBits;
+                cerr << " noise " << stddev << ": BER block " <<
+                    errorsBlock / numBits << " (" << mbpsBlock <<
+                    " Mbit/s), streaming " << errorsStreaming / numBits <<
+                    " (" << mbpsStreaming << " Mbit/s), " << differences <<
+                    " bits differ" << endl;
+            }
+        }
+    }
+}
+
+void Tests::benchmark_soft_output()
+{
+    // DAB+ superframes of random bytes, protected by the RS(120, 110)
+    // code, sent with EEP 3-A at 64 kbps through an AWGN channel. They
+    // are decoded with hard decisions, and with the soft output giving
+    // the least reliable bytes to the RS decoder as erasures.
+    const int16_t bitRate = 64;
+    const int16_t frameBits = 24 * bitRate;
+    const size_t frameLen = frameBits / 8;
+    const size_t sfLen = 5 * frameLen;
+    const int subchIndex = sfLen / 120;
+    const int numSuperframes = 400;
+    const double stddevs[] = { 90.0, 100.0, 110.0 };
+
+    void *rs = init_rs_char(8, 0x11D, 0, 1, 10, 135);
+    const auto& runs = EEPProtection::getSchedule(bitRate, true, 3).getRuns();
+    uniform_int_distribution<int> byte(0, 255);
+
+    for (const auto stddev : stddevs) {
+        vector<vector<uint8_t> > superframes(numSuperframes);
+        vector<vector<int16_t> > transmitted(5 * numSuperframes);
+        for (int n = 0; n < numSuperframes; n++) {
+            auto& sf = superframes[n];
+            sf.resize(sfLen);
+            for (int i = 0; i < subchIndex; i++) {
+                uint8_t packet[120];
+                for (int pos = 0; pos < 110; pos++) {
+                    packet[pos] = sf[pos * subchIndex + i] =
+                        byte(random_generator);
+                }
+                encode_rs_char(rs, packet, packet + 110);
+                for (int pos = 110; pos < 120; pos++) {
+                    sf[pos * subchIndex + i] = packet[pos];
+                }
+            }
+
+            for (int f = 0; f < 5; f++) {
+                vector<uint8_t> bits(frameBits);
+                for (int i = 0; i < frameBits; i++) {
+                    bits[i] = (sf[f * frameLen + i / 8] >> (7 - i % 8)) & 1;
+                }
+                vector<int16_t> softBits;
+                encode_frame(bits, stddev, softBits);
+                auto& tx = transmitted[5 * n + f];
+                size_t i = 0;
+                for (const auto& run : runs) {
+                    tx.insert(tx.end(), softBits.begin() + i,
+                            softBits.begin() + i + run.kept);
+                    i += run.kept + run.punctured;
+                }
+            }
+        }
+
+        EEPProtection protection(bitRate, true, 3);
+        struct Result {
+            double decodeTime = 0;
+            double rsTime = 0;
+            int lost = 0;
+            int wrong = 0;
+            int erasureCorrections = 0;
+        };
+        auto run = [&](bool softOutput) {
+            Result result;
+            protection.setSoftOutput(softOutput);
+            RSDecoder rsDecoder;
+            vector<uint8_t> sf(sfLen), reliability(sfLen);
+            for (int n = 0; n < numSuperframes; n++) {
+                for (int f = 0; f < 5; f++) {
+                    auto& tx = transmitted[5 * n + f];
+                    auto t0 = chrono::steady_clock::now();
+                    protection.deconvolve(tx.data(), tx.size(),
+                            sf.data() + f * frameLen);
+                    auto t1 = chrono::steady_clock::now();
+                    result.decodeTime += chrono::duration<double>(t1 - t0).count();
+                    if (softOutput) {
+                        const uint8_t *r = protection.getByteReliability();
+                        copy(r, r + frameLen, reliability.begin() + f * frameLen);
+                    }
+                }
+
+                int corrections = 0;
+                bool uncorrectable = false;
+                auto t0 = chrono::steady_clock::now();
+                rsDecoder.DecodeSuperframe(sf.data(), sfLen, corrections,
+                        uncorrectable, softOutput ? reliability.data() : nullptr);
+                auto t1 = chrono::steady_clock::now();
+                result.rsTime += chrono::duration<double>(t1 - t0).count();
+
+                const auto& ref = superframes[n];
+                const bool correct = equal(ref.begin(),
+                        ref.begin() + 110 * subchIndex, sf.begin());
+                result.lost += not correct;
+                result.wrong += not correct and not uncorrectable;
+            }
+            result.erasureCorrections = rsDecoder.erasure_corrections;
+            return result;
+        };
+
+        const Result hard = run(false);
+        const Result soft = run(true);
+        const double bits = 5.0 * numSuperframes * frameBits;
+        cerr << "EEP 3-A " << bitRate << " kbps, noise " << stddev <<
+            ": superframes lost " << hard.lost << "/" << numSuperframes <<
+            " hard, " << soft.lost << "/" << numSuperframes <<
+            " with erasures (" << soft.erasureCorrections <<
+            " packets corrected with them, wrong corrections " <<
+            hard.wrong << " hard, " << soft.wrong << " with erasures); Viterbi " << bits / hard.decodeTime / 1e6 <<
+            " Mbit/s, soft output " << bits / soft.decodeTime / 1e6 <<
+            " Mbit/s; RS " << hard.rsTime / numSuperframes * 1e6 << " us, " <<
+            soft.rsTime / numSuperframes * 1e6 << " us per superframe" << endl;
+    }
+    free_rs_char(rs);
+
+    // The recording given with -f, with noise added, decoded with and
+    // without soft output. The samples are played at the sample rate.
+    auto raw = dynamic_cast<CRAWFile*>(input_interface.get());
+    if (raw == nullptr) {
+        cerr << "The test on a recording needs an IQ file" << endl;
+        return;
+    }
+    const size_t maxSamples = 60 * INPUT_RATE;
+    vector<DSPCOMPLEX> samples;
+    raw->restart();
+    vector<DSPCOMPLEX> buf(2048);
+    while (samples.size() < maxSamples and not raw->endWasReached()) {
+        const int32_t n = min<int32_t>(raw->getSamplesToRead(), buf.size());
+        if (n == 0) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+        raw->getSamples(buf.data(), n);
+        samples.insert(samples.end(), buf.begin(), buf.begin() + n);
+    }
+    raw->stop();
+
+    double power = 0;
+    for (const auto& z : samples) {
+        power += norm(z);
+    }
+    power /= samples.size();
+
+    DABParams params(1);
+    for (const double snr : { 5.0, 4.0, 3.5 }) {
+        normal_distribution<float> noise(0.0,
+                sqrt(power / 2 * pow(10.0, -snr / 10)));
+        vector<DSPCOMPLEX> noisy(samples);
+        for (auto& z : noisy) {
+            z += DSPCOMPLEX(noise(random_generator), noise(random_generator));
+        }
+
+        for (const float budget : { 0.0f, 1.0f }) {
+            RadioReceiverOptions options = rro;
+            options.viterbiSoftOutputBudget = budget;
+
+            MemoryInput input(noisy, true);
+            TestRadioInterface ri;
+            TestProgrammeHandler tph;
+            RadioReceiver rx(ri, input, options);
+            const clock_t c0 = clock();
+            rx.restart(false);
+
+            bool selected = false;
+            while (input.getSamplesToRead() >= params.T_null) {
+                for (const auto& service : rx.getServiceList()) {
+                    if (selected) {
+                        break;
+                    }
+                    const auto components = rx.getComponents(service);
+                    if (not components.empty() and
+                            components.front().audioType() ==
+                            AudioServiceComponentType::DABPlus) {
+                        selected = rx.playSingleProgramme(tph, "", service);
+                    }
+                }
+                this_thread::sleep_for(chrono::milliseconds(10));
+            }
+            // Let the audio decoder finish the last frames
+            this_thread::sleep_for(chrono::milliseconds(500));
+            const double cpu = (double)(clock() - c0) / CLOCKS_PER_SEC;
+
+            cerr << "SNR " << snr << " dB, soft output " <<
+                (budget > 0 ? "on" : "off") << ": ";
+            if (not selected) {
+                cerr << "no DAB+ programme" << endl;
+                continue;
+            }
+            cerr << tph.frameErrorStats.size() << " frames, " <<
+                std::accumulate(tph.frameErrorStats.begin(),
+                        tph.frameErrorStats.end(), 0) << " AU errors, " <<
+                std::accumulate(tph.rsErrorStats.begin(),
+                        tph.rsErrorStats.end(), 0) <<
+                " superframes with uncorrectable RS errors, " <<
+                std::accumulate(tph.aacErrorStats.begin(),
+                        tph.aacErrorStats.end(), 0) << " AAC errors, " <<
+                cpu << " s CPU" << endl;
+        }
+    }
+}
+
+void Tests::benchmark_energy_dispersal()
+{
+    // Remove the energy dispersal from packed frames with every kernel,
+    // and with the PRBS computed one bit at a time on unpacked bits,
+    // which are then packed as the decoders need them.
+    const int16_t frameLengths[] = { 768, 24 * 64, 24 * 384 };
+    const SimdLevel levels[] = {
+        SimdLevel::Generic, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+    uniform_int_distribution<int> bit(0, 1);
+
+    for (const auto frameBits : frameLengths) {
+        vector<uint8_t> bits(frameBits);
+        for (auto& b : bits) {
+            b = bit(random_generator);
+        }
+        const vector<uint8_t> packed = pack_bits(bits);
+
+        // Reference: one bit per byte, repacked afterwards
+        vector<uint8_t> prbs(frameBits);
+        uint8_t shiftRegister[9];
+        memset(shiftRegister, 1, 9);
+        for (int i = 0; i < frameBits; i++) {
+            prbs[i] = shiftRegister[8] ^ shiftRegister[4];
+            for (int j = 8; j > 0; j--) {
+                shiftRegister[j] = shiftRegister[j - 1];
+            }
+            shiftRegister[0] = prbs[i];
+        }
+
+        vector<uint8_t> unpacked(frameBits), reference(frameBits / 8);
+        const int iterations = std::max(1, 20000000 / frameBits);
+        auto t0 = chrono::steady_clock::now();
+        for (int n = 0; n < iterations; n++) {
+            unpacked = bits;
+            for (int i = 0; i < frameBits; i++) {
+                unpacked[i] ^= prbs[i];
+            }
+            for (int i = 0; i < frameBits / 8; i++) {
+                reference[i] = 0;
+                for (int j = 0; j < 8; j++) {
+                    reference[i] <<= 1;
+                    reference[i] |= unpacked[8 * i + j] & 01;
+                }
+            }
+        }
+        auto t1 = chrono::steady_clock::now();
+        cerr << "Energy dispersal, frame " << frameBits <<
+            " bits: unpacked " << (double)iterations * frameBits /
+            chrono::duration<double>(t1 - t0).count() / 1e6 << " Mbit/s" <<
+            endl;
+
+        for (const auto level : levels) {
+            EnergyDispersal dispersal(level);
+            if (dispersal.getSimdLevel() != level) {
+                continue;
+            }
+
+            vector<uint8_t> out;
+            t0 = chrono::steady_clock::now();
+            for (int n = 0; n < iterations; n++) {
+                out = packed;
+                dispersal.dedisperse(out.data(), out.size());
+            }
+            t1 = chrono::steady_clock::now();
+            cerr << " " << simdLevelName(level) << ": " <<
+                (double)iterations * frameBits /
+                chrono::duration<double>(t1 - t0).count() / 1e6 <<
+                " Mbit/s" << endl;
+        }
+    }
+}
+
+void Tests::benchmark_rs_syndromes()
+{
+    // DAB+ superframes of random RS(120, 110) codewords, clean and with a
+    // few corrupted codewords. Every kernel looks for the codewords with
+    // errors. The superframes are then decoded by the RSDecoder, which
+    // runs libfec only on these codewords, and by libfec on every
+    // codeword, as before.
+    const int bitRates[] = { 48, 96, 192 };
+    const int numSuperframes = 200;
+    const int iterations = 20;
+    const SimdLevel levels[] = {
+        SimdLevel::Generic, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON };
+
+    void *rs = init_rs_char(8, 0x11D, 0, 1, 10, 135);
+    uniform_int_distribution<int> byte(0, 255);
+
+    for (const auto bitRate : bitRates) {
+        const int subchIndex = bitRate / 8;
+        const size_t sfLen = 120 * subchIndex;
+        uniform_int_distribution<int> codeword(0, subchIndex - 1);
+        uniform_int_distribution<int> position(0, 119);
+
+        for (const int corrupted : { 0, 2 }) {
+            vector<vector<uint8_t> > superframes(numSuperframes);
+            for (auto& sf : superframes) {
+                sf.resize(sfLen);
+                for (int i = 0; i < subchIndex; i++) {
+                    uint8_t packet[120];
+                    for (int pos = 0; pos < 110; pos++) {
+                        packet[pos] = byte(random_generator);
+                    }
+                    encode_rs_char(rs, packet, packet + 110);
+                    for (int pos = 0; pos < 120; pos++) {
+                        sf[pos * subchIndex + i] = packet[pos];
+                    }
+                }
+                for (int e = 0; e < corrupted; e++) {
+                    sf[position(random_generator) * subchIndex +
+                        codeword(random_generator)] ^= 1 + byte(random_generator) % 255;
+                }
+            }
+
+            auto decode_all = [&](vector<uint8_t>& sf) {
+                int corrPos[10];
+                uint8_t packet[120];
+                for (int i = 0; i < subchIndex; i++) {
+                    for (int pos = 0; pos < 120; pos++) {
+                        packet[pos] = sf[pos * subchIndex + i];
+                    }
+                    const int count = decode_rs_char(rs, packet, corrPos, 0);
+                    for (int j = 0; j < count; j++) {
+                        const int pos = corrPos[j] - 135;
+                        if (pos >= 0) {
+                            sf[pos * subchIndex + i] = packet[pos];
+                        }
+                    }
+                }
+            };
+            cerr << "RS " << bitRate << " kbps, " << subchIndex <<
+                " codewords per superframe, " << corrupted <<
+                " corrupted bytes per superframe" << endl;
+
+            for (const auto level : levels) {
+                RSSyndromes syndromes(level);
+                if (syndromes.getSimdLevel() != level) {
+                    continue;
+                }
+
+                vector<uint8_t> errors(subchIndex);
+                auto t0 = chrono::steady_clock::now();
+                for (int k = 0; k < iterations; k++) {
+                    for (int n = 0; n < numSuperframes; n++) {
+                        syndromes.check(superframes[n].data(), subchIndex,
+                                errors.data());
+                    }
+                }
+                auto t1 = chrono::steady_clock::now();
+                const double s = chrono::duration<double>(t1 - t0).count();
+                cerr << " Syndromes " << simdLevelName(level) << ": " <<
+                    s / (iterations * numSuperframes) * 1e6 <<
+                    " us per superframe" << endl;
+            }
+
+            // Whole superframes, as rs_speedtest measures the decoder
+            const double bits = 8.0 * 110 * subchIndex * iterations * numSuperframes;
+            vector<uint8_t> sf;
+            auto t0 = chrono::steady_clock::now();
+            for (int k = 0; k < iterations; k++) {
+                for (int n = 0; n < numSuperframes; n++) {
+                    sf = superframes[n];
+                    decode_all(sf);
+                }
+            }
+            auto t1 = chrono::steady_clock::now();
+            const double libfec = chrono::duration<double>(t1 - t0).count();
+
+            RSDecoder rsDecoder;
+            t0 = chrono::steady_clock::now();
+            for (int k = 0; k < iterations; k++) {
+                for (int n = 0; n < numSuperframes; n++) {
+                    sf = superframes[n];
+                    int corrections = 0;
+                    bool uncorrectable = false;
+                    rsDecoder.DecodeSuperframe(sf.data(), sfLen,
+                            corrections, uncorrectable);
+                }
+            }
+            t1 = chrono::steady_clock::now();
+            const double fast = chrono::duration<double>(t1 - t0).count();
+
+            cerr << " Decoder speed: libfec on every codeword " <<
+                bits / libfec << " bits/s, RSDecoder " << bits / fast <<
+                " bits/s" << endl;
+        }
+    }
+
+    free_rs_char(rs);
+}
+
+void Tests::benchmark_fib_crc()
+{
+    // FIBs with a valid CRC, and FIBs with one bit flipped, checked with
+    // the bit by bit CRC over the unpacked bits, and with the CRC over
+    // the packed bytes.
+    const int numFibs = 1000;
+    uniform_int_distribution<int> byte(0, 255);
+    uniform_int_distribution<int> position(0, 255);
+
+    vector<vector<uint8_t> > fibs(numFibs, vector<uint8_t>(32));
+    vector<vector<uint8_t> > fibBits(numFibs);
+    for (int n = 0; n < numFibs; n++) {
+        auto& fib = fibs[n];
+        for (int i = 0; i < 30; i++) {
+            fib[i] = byte(random_generator);
+        }
+        const uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(fib.data(), 30);
+        fib[30] = crc >> 8;
+        fib[31] = crc & 0xFF;
+        if (n % 2) {
+            const int bit = position(random_generator);
+            fib[bit / 8] ^= 0x80 >> (bit % 8);
+        }
+
+        fibBits[n].resize(256);
+        for (int i = 0; i < 256; i++) {
+            fibBits[n][i] = (fib[i / 8] >> (7 - i % 8)) & 1;
+        }
+    }
+
+    const int iterations = 200;
+    size_t valid = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (const auto& bits : fibBits) {
+            valid += check_CRC_bits(bits.data(), 256);
+        }
+    }
+    auto t1 = chrono::steady_clock::now();
+    const double unpackedTime = chrono::duration<double>(t1 - t0).count();
+
+    t0 = chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (const auto& fib : fibs) {
+            valid += CalcCRC::CalcCRC_CRC16_CCITT.Calc(fib.data(), 30) ==
+                ((fib[30] << 8) | fib[31]);
+        }
+    }
+    t1 = chrono::steady_clock::now();
+    const double packedTime = chrono::duration<double>(t1 - t0).count();
+
+    cerr << "FIB CRC: unpacked " << iterations * numFibs / unpackedTime / 1e3 <<
+        " kFIB/s, packed " << iterations * numFibs / packedTime / 1e3 <<
+        " kFIB/s (" << valid << " valid)" << endl;
+}
+
+void Tests::test_all_services()
+{
+    // Decode every service of the ensemble at the same time, as
+    // welle-cli -D does, and remove them while the receiver runs.
+    TestRadioInterface ri;
+    RadioReceiver rx(ri, *input_interface, rro);
+    rx.restart(false);
+
+    map<uint32_t, TestProgrammeHandler> handlers;
+    auto& rawFile = dynamic_cast<CRAWFile&>(*input_interface);
+    while (not rawFile.endWasReached()) {
+        this_thread::sleep_for(chrono::milliseconds(100));
+
+        for (const auto& s : rx.getServiceList()) {
+            if (handlers.count(s.serviceId) or
+                    not rx.serviceHasAudioComponent(s)) {
+                continue;
+            }
+
+            if (rx.addServiceToDecode(handlers[s.serviceId], "", s)) {
+                cerr << "Decoding " << s.serviceLabel.utf8_label() << endl;
+            }
+            else {
+                cerr << "Tune to " << s.serviceLabel.utf8_label() <<
+                    " failed" << endl;
+            }
+        }
+    }
+
+    const auto decodeStats = rx.getSubchannelDecodeStats();
+    for (const auto& s : rx.getServiceList()) {
+        if (handlers.count(s.serviceId)) {
+            rx.removeServiceToDecode(s);
+        }
+    }
+
+    cerr << endl;
+    const auto poolStats = rx.getDecoderPoolStats();
+    cerr << "Decoder threads: " << poolStats.num_threads << ", " <<
+        poolStats.num_tasks << " tasks, " << poolStats.num_steals <<
+        " stolen" << endl;
+    // The batching delays the frames, see viterbiBatchWaitBlocks
+    const auto batchStats = rx.getViterbiBatchStats();
+    double latencySum = 0;
+    double maxLatency = 0;
+    size_t numFrames = 0;
+    for (const auto& d : decodeStats) {
+        latencySum += d.mean_latency_us * d.num_frames;
+        maxLatency = max(maxLatency, d.max_latency_us);
+        numFrames += d.num_frames;
+    }
+    cerr << "Viterbi: " << batchStats.frames << " frames in " <<
+        batchStats.passes << " batched passes (" <<
+        (double)batchStats.frames / max<size_t>(batchStats.passes, 1) <<
+        " per pass), " << batchStats.alone << " alone. Frame latency " <<
+        latencySum / max<size_t>(numFrames, 1) / 1e3 << " ms mean, " <<
+        maxLatency / 1e3 << " ms max" << endl;
+    for (const auto& d : decodeStats) {
+        cerr << "subch " << d.subchannel_id << " : " << d.num_frames <<
+            " frames, " << d.overflow.dropped_frames << " dropped, " <<
+            1e3 * d.cpu_time_s / max<size_t>(d.num_frames, 1) <<
+            " ms CPU per frame, latency " << d.mean_latency_us / 1e3 <<
+            " ms mean, " << d.max_latency_us / 1e3 << " ms max" << endl;
+    }
+    for (const auto& s : rx.getServiceList()) {
+        if (not handlers.count(s.serviceId)) {
+            continue;
+        }
+
+        const auto& tph = handlers.at(s.serviceId);
+        cerr << "0x" << hex << s.serviceId << dec << " '" <<
+            s.serviceLabel.utf8_label() << "' : " <<
+            tph.frameErrorStats.size() << " frames, " <<
+            std::accumulate(tph.frameErrorStats.begin(),
+                    tph.frameErrorStats.end(), 0) << " frame errors, " <<
+            std::accumulate(tph.rsErrorStats.begin(),
+                    tph.rsErrorStats.end(), 0) << " RS errors" << endl;
+    }
+    const auto queueStats = rx.getSymbolQueueStats();
+    cerr << "Symbol queue (max " << queueStats.max_queue_depth << "/" <<
+        queueStats.queue_capacity << ") : " << queueStats.overruns <<
+        " overruns" << endl;
+}
+
+// Takes much longer to play a frame than the 24 ms it lasts
+class SlowProgrammeHandler : public TestProgrammeHandler {
+    public:
+        size_t num_audio = 0;
+
+        virtual void onNewAudio(std::vector<int16_t>&& audioData, int sampleRate, bool isStereo, const string& mode) override {
+            num_audio++;
+            this_thread::sleep_for(chrono::milliseconds(500));
+            TestProgrammeHandler::onNewAudio(move(audioData), sampleRate,
+                    isStereo, mode);
+        }
+};
+
+void Tests::test_frame_overflow()
+{
+    // The audio decoder cannot keep up. Whatever the policy, the symbols
+    // must not be dropped before the MSC.
+    using P = FrameOverflowPolicy;
+    for (const auto policy : {P::DropNewest, P::DropOldest, P::Block}) {
+        auto& rawFile = dynamic_cast<CRAWFile&>(*input_interface);
+        rawFile.rewind();
+
+        RadioReceiverOptions options = rro;
+        options.frameOverflowPolicy = policy;
+        TestRadioInterface ri;
+        RadioReceiver rx(ri, *input_interface, options);
+        rx.restart(false);
+
+        SlowProgrammeHandler tph;
+        bool service_selected = false;
+        while (not rawFile.endWasReached()) {
+            this_thread::sleep_for(chrono::milliseconds(500));
+
+            for (const auto& s : rx.getServiceList()) {
+                if (service_selected) {
+                    break;
+                }
+                service_selected = rx.playSingleProgramme(tph, "", s);
+            }
+        }
+
+        const auto overflow = tph.getOverflow();
+        // Must not wait for the MSC thread blocked on the decoder
+        const auto t0 = chrono::steady_clock::now();
+        rx.restart_decoder();
+        const double stopTime = chrono::duration<double>(
+                chrono::steady_clock::now() - t0).count();
+
+        const auto queueStats = rx.getSymbolQueueStats();
+        const auto msc = rx.getDecoderPipelineStats().msc;
+        cerr << (policy == P::DropNewest ? "drop newest" :
+                 policy == P::DropOldest ? "drop oldest" : "block") <<
+            " : " << tph.num_audio << " frames played, " <<
+            overflow.dropped_frames << " dropped, " << overflow.waits <<
+            " waits, " << queueStats.overruns << " symbol overruns, " <<
+            "MSC latency max " << msc.max_latency_us << " us, stopped in " <<
+            1e3 * stopTime << " ms" << endl;
+    }
+}
+
+void Tests::test_slow_decoders()
+{
+    // The decoders of all services are too slow, and the MSC thread
+    // waits for them. The FIC must still be decoded, the waits of the
+    // services together must fit in a CIF.
+    TestRadioInterface ri;
+    RadioReceiverOptions options = rro;
+    options.frameOverflowPolicy = FrameOverflowPolicy::Block;
+    RadioReceiver rx(ri, *input_interface, options);
+    rx.restart(false);
+
+    map<uint32_t, SlowProgrammeHandler> handlers;
+    auto& rawFile = dynamic_cast<CRAWFile&>(*input_interface);
+    while (not rawFile.endWasReached()) {
+        this_thread::sleep_for(chrono::milliseconds(100));
+
+        for (const auto& s : rx.getServiceList()) {
+            if (handlers.count(s.serviceId) or
+                    not rx.serviceHasAudioComponent(s)) {
+                continue;
+            }
+            rx.addServiceToDecode(handlers[s.serviceId], "", s);
+        }
+    }
+    const auto pipelineStats = rx.getDecoderPipelineStats();
+    rx.restart_decoder();
+
+    size_t dropped = 0;
+    size_t waits = 0;
+    for (auto& h : handlers) {
+        const auto overflow = h.second.getOverflow();
+        dropped += overflow.dropped_frames;
+        waits += overflow.waits;
+    }
+
+    const auto queueStats = rx.getSymbolQueueStats();
+    cerr << handlers.size() << " slow services: " << dropped <<
+        " frames dropped, " << waits << " waits, MSC latency max " <<
+        pipelineStats.msc.max_latency_us << " us" << endl;
+    cerr << "FIC: " << ri.num_fibs_ok << " FIBs valid, " <<
+        ri.num_fib_errors << " CRC errors, latency max " <<
+        pipelineStats.fic.max_latency_us << " us. Symbol queue: " <<
+        queueStats.overruns << " overruns" << endl;
+}
+
+// Notes when the first audio arrives after the service was selected
+class SwitchProgrammeHandler : public TestProgrammeHandler {
+    public:
+        void selected() {
+            lock_guard<mutex> lock(switchMutex);
+            selectTime = chrono::steady_clock::now();
+            waiting = true;
+        }
+
+        vector<double> getAudioLatencies() {
+            lock_guard<mutex> lock(switchMutex);
+            return audioLatencies;
+        }
+
+        virtual void onNewAudio(std::vector<int16_t>&& audioData, int sampleRate, bool isStereo, const string& mode) override {
+            {
+                lock_guard<mutex> lock(switchMutex);
+                if (waiting) {
+                    waiting = false;
+                    audioLatencies.push_back(chrono::duration<double>(
+                                chrono::steady_clock::now() -
+                                selectTime).count());
+                }
+            }
+            TestProgrammeHandler::onNewAudio(move(audioData), sampleRate,
+                    isStereo, mode);
+        }
+
+    private:
+        mutex switchMutex;
+        bool waiting = false;
+        chrono::steady_clock::time_point selectTime;
+        vector<double> audioLatencies;
+};
+
+void Tests::test_service_switch()
+{
+    // Go through the services one after the other, as the carousel of
+    // the web interface does. With a single service, it is selected
+    // again. Only the first switch to a kind of subchannel builds its
+    // decoders.
+    TestRadioInterface ri;
+    RadioReceiver rx(ri, *input_interface, rro);
+    rx.restart(false);
+
+    SwitchProgrammeHandler tph;
+    auto& rawFile = dynamic_cast<CRAWFile&>(*input_interface);
+    size_t next = 0;
+    size_t num_switches = 0;
+    auto switchTime = chrono::steady_clock::now();
+    while (not rawFile.endWasReached()) {
+        // The decoder is stopped soon after the end of the file, which
+        // would cut a superframe short
+        this_thread::sleep_for(chrono::milliseconds(100));
+        if (chrono::steady_clock::now() - switchTime < chrono::seconds(3)) {
+            continue;
+        }
+        switchTime = chrono::steady_clock::now();
+
+        vector<Service> services;
+        for (const auto& s : rx.getServiceList()) {
+            if (rx.serviceHasAudioComponent(s)) {
+                services.push_back(s);
+            }
+        }
+        if (services.empty()) {
+            continue;
+        }
+
+        const auto& s = services[next++ % services.size()];
+        tph.selected();
+        if (rx.playSingleProgramme(tph, "", s)) {
+            num_switches++;
+        }
+    }
+    rx.restart_decoder();
+
+    const auto stats = rx.getDecoderSwitchStats();
+    const auto latencies = tph.getAudioLatencies();
+    cerr << num_switches << " switches: " << stats.num_created <<
+        " decoders created in " << 1e3 * stats.create_time_s /
+        max<size_t>(stats.num_created, 1) << " ms, " << stats.num_reused <<
+        " reused in " << 1e3 * stats.reuse_time_s /
+        max<size_t>(stats.num_reused, 1) << " ms on average" << endl;
+    cerr << "First audio after " << 1e3 * std::accumulate(latencies.begin(),
+            latencies.end(), 0.0) / max<size_t>(latencies.size(), 1) <<
+        " ms on average (" << latencies.size() << " switches), " <<
+        tph.frameErrorStats.size() << " frames, " <<
+        std::accumulate(tph.frameErrorStats.begin(),
+                tph.frameErrorStats.end(), 0) << " frame errors, " <<
+        std::accumulate(tph.rsErrorStats.begin(),
+                tph.rsErrorStats.end(), 0) << " RS errors" << endl;
+}
+
 void Tests::run_test(int test_id)
 {
     rro.ofdmProcessorThreshold = DEFAULT_OFDM_PROCESSOR_THRESHOLD;
@@ -363,5 +2015,21 @@ void Tests::run_test(int test_id)
     if (test_id == 0) test_with_noise();
     else if (test_id == 1 or test_id == 2) test_multipath(test_id);
     else if (test_id == 3) test_with_noise_iteration(0);
+    else if (test_id == 4) benchmark_oscillator();
+    else if (test_id == 5) benchmark_fft();
+    else if (test_id == 6) benchmark_demapper();
+    else if (test_id == 7) benchmark_coarse_sync();
+    else if (test_id == 8) benchmark_viterbi();
+    else if (test_id == 9) benchmark_viterbi_batch();
+    else if (test_id == 10) benchmark_depuncture();
+    else if (test_id == 11) test_streaming_viterbi();
+    else if (test_id == 12) benchmark_soft_output();
+    else if (test_id == 13) benchmark_energy_dispersal();
+    else if (test_id == 14) benchmark_rs_syndromes();
+    else if (test_id == 15) benchmark_fib_crc();
+    else if (test_id == 16) test_all_services();
+    else if (test_id == 17) test_frame_overflow();
+    else if (test_id == 18) test_service_switch();
+    else if (test_id == 19) test_slow_decoders();
     else cerr << "Test " << test_id << " does not exist!" << endl;
 }
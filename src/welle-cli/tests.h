@@ -45,6 +45,22 @@ class Tests {
         void test_with_noise();
         void test_with_noise_iteration(double stddev);
         void test_multipath(int test_id);
+        void benchmark_oscillator();
+        void benchmark_fft();
+        void benchmark_demapper();
+        void benchmark_coarse_sync();
+        void benchmark_viterbi();
+        void benchmark_viterbi_batch();
+        void benchmark_depuncture();
+        void test_streaming_viterbi();
+        void benchmark_soft_output();
+        void benchmark_energy_dispersal();
+        void benchmark_rs_syndromes();
+        void benchmark_fib_crc();
+        void test_all_services();
+        void test_frame_overflow();
+        void test_service_switch();
+        void test_slow_decoders();
 
         std::unique_ptr<CVirtualInput>& input_interface;
         RadioReceiverOptions rro;
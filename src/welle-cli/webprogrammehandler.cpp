@@ -298,3 +298,9 @@ void WebProgrammeHandler::onPADLengthError(size_t announced_xpad_len, size_t xpa
     xpad_error.xpad_len = xpad_len;
 }
 
+void WebProgrammeHandler::onFrameOverflow(const frame_overflow_stats_t& stats)
+{
+    std::unique_lock<std::mutex> lock(stats_mutex);
+    errorcounters.num_droppedFrames = stats.dropped_frames;
+    errorcounters.time = chrono::system_clock::now();
+}
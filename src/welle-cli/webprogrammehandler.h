@@ -89,6 +89,8 @@ class WebProgrammeHandler : public ProgrammeHandlerInterface {
             size_t num_frameErrors = 0;
             size_t num_rsErrors = 0;
             size_t num_aacErrors = 0;
+            // Frames the decoder could not keep up with
+            size_t num_droppedFrames = 0;
         };
     private:
         uint32_t serviceId;
@@ -156,5 +158,6 @@ class WebProgrammeHandler : public ProgrammeHandlerInterface {
         virtual void onNewDynamicLabel(const std::string& label) override;
         virtual void onMOT(const std::vector<uint8_t>& data, int subtype) override;
         virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) override;
+        virtual void onFrameOverflow(const frame_overflow_stats_t& stats) override;
 };
 
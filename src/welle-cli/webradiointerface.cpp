@@ -205,6 +205,8 @@ void WebRadioInterface::retune(const std::string& channel)
         last_snr = 0;
         last_fine_correction = 0;
         last_coarse_correction = 0;
+        last_queue_stats = {};
+        last_milestones = {};
         num_fic_crc_errors = 0;
         tiis.clear();
 
@@ -548,6 +550,7 @@ bool WebRadioInterface::send_mux_json(Socket& s)
                     {"frameerrors", errorcounters.num_frameErrors},
                     {"rserrors", errorcounters.num_rsErrors},
                     {"aacerrors", errorcounters.num_aacErrors},
+                    {"droppedframes", errorcounters.num_droppedFrames},
                     {"time", chrono::system_clock::to_time_t(dls.time)}};
                 j_srv["errorcounters"] = j_errorcounters;
 
@@ -590,6 +593,18 @@ bool WebRadioInterface::send_mux_json(Socket& s)
         j["snr"] = last_snr;
         j["frequencycorrection"] =
             last_fine_correction + last_coarse_correction;
+        j["decoder_overruns"] = {
+            {"symbols", last_queue_stats.overruns},
+            {"frames", last_queue_stats.discarded_frames}};
+        j["milestones"] = {
+            {"null_detected", last_milestones.null_detected},
+            {"prs_locked", last_milestones.prs_locked},
+            {"coarse_corrected", last_milestones.coarse_corrected},
+            {"fib_crc_valid", last_milestones.fib_crc_valid},
+            {"ensemble_label", last_milestones.ensemble_label},
+            {"programme_selected", last_milestones.programme_selected},
+            {"audio_sync", last_milestones.audio_sync},
+            {"first_audio", last_milestones.first_audio}};
 
         for (const auto& tii : getTiiStats()) {
             j["tii"].push_back({
@@ -1142,7 +1157,7 @@ void WebRadioInterface::onDateTimeUpdate(const dab_date_time_t& dateTime)
     last_dateTime = dateTime;
 }
 
-void WebRadioInterface::onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib)
+void WebRadioInterface::onFIBDecoded(bool crcCheckOk, const uint8_t* fib)
 {
     if (not crcCheckOk) {
         lock_guard<mutex> lock(fib_mut);
@@ -1150,17 +1165,7 @@ void WebRadioInterface::onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib)
         return;
     }
 
-    // Convert the fib bitvector to bytes
-    vector<uint8_t> buf(32);
-    for (size_t i = 0; i < buf.size(); i++) {
-        uint8_t v = 0;
-        for (int j = 0; j < 8; j++) {
-            if (fib[8*i+j]) {
-                v |= 1 << (7-j);
-            }
-        }
-        buf[i] = v;
-    }
+    vector<uint8_t> buf(fib, fib + 32);
 
     {
         lock_guard<mutex> lock(fib_mut);
@@ -1192,6 +1197,18 @@ void WebRadioInterface::onConstellationPoints(std::vector<DSPCOMPLEX>&& data)
     last_constellation = move(data);
 }
 
+void WebRadioInterface::onSymbolQueueOverrun(const symbol_queue_stats_t& stats)
+{
+    lock_guard<mutex> lock(data_mut);
+    last_queue_stats = stats;
+}
+
+void WebRadioInterface::onSyncMilestones(const sync_milestones_t& milestones)
+{
+    lock_guard<mutex> lock(data_mut);
+    last_milestones = milestones;
+}
+
 void WebRadioInterface::onMessage(message_level_t level, const std::string& text)
 {
     lock_guard<mutex> lock(data_mut);
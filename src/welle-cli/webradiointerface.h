@@ -78,10 +78,12 @@ class WebRadioInterface : public RadioControllerInterface {
         virtual void onServiceDetected(uint32_t sId, const std::string& label) override;
         virtual void onNewEnsembleName(const std::string& name) override;
         virtual void onDateTimeUpdate(const dab_date_time_t& dateTime) override;
-        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override;
+        virtual void onFIBDecoded(bool crcCheckOk, const uint8_t* fib) override;
         virtual void onNewImpulseResponse(std::vector<float>&& data) override;
         virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override;
         virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override;
+        virtual void onSymbolQueueOverrun(const symbol_queue_stats_t& stats) override;
+        virtual void onSyncMilestones(const sync_milestones_t& milestones) override;
         virtual void onMessage(message_level_t level, const std::string& text) override;
         virtual void onTIIMeasurement(tii_measurement_t&& m) override;
 
@@ -149,6 +151,8 @@ class WebRadioInterface : public RadioControllerInterface {
         int last_fine_correction = 0;
         int last_coarse_correction = 0;
         dab_date_time_t last_dateTime;
+        symbol_queue_stats_t last_queue_stats;
+        sync_milestones_t last_milestones;
         std::deque<std::pair<message_level_t, std::string> > pending_messages;
 
         mutable std::mutex plotdata_mut;
@@ -103,6 +103,12 @@ class AlsaProgrammeHandler: public ProgrammeHandlerInterface {
             cout << "X-PAD length mismatch, expected: " << announced_xpad_len << " got: " << xpad_len << endl;
         }
 
+        virtual void onFrameOverflow(const frame_overflow_stats_t& stats) override
+        {
+            cerr << "Audio decoder too slow: " << stats.dropped_frames <<
+                " frames dropped" << endl;
+        }
+
     private:
         mutex aomutex;
         unique_ptr<AlsaOutput> ao;
@@ -166,6 +172,13 @@ class WavProgrammeHandler: public ProgrammeHandlerInterface {
             cout << "X-PAD length mismatch, expected: " << announced_xpad_len << " got: " << xpad_len << endl;
         }
 
+        virtual void onFrameOverflow(const frame_overflow_stats_t& stats) override
+        {
+            cerr << "[0x" << std::hex << SId << std::dec << "] " <<
+                "Audio decoder too slow: " << stats.dropped_frames <<
+                " frames dropped" << endl;
+        }
+
     private:
         uint32_t SId;
         string filePrefix;
@@ -204,30 +217,39 @@ class RadioInterface : public RadioControllerInterface {
             cout << j << endl;
         }
 
-        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override {
+        virtual void onFIBDecoded(bool crcCheckOk, const uint8_t* fib) override {
             if (fic_fd) {
                 if (not crcCheckOk) {
                     return;
                 }
 
-                // convert bitvector to byte vector
-                vector<uint8_t> buf(32);
-                for (size_t i = 0; i < buf.size(); i++) {
-                    uint8_t v = 0;
-                    for (int j = 0; j < 8; j++) {
-                        if (fib[8*i+j]) {
-                            v |= 1 << (7-j);
-                        }
-                    }
-                    buf[i] = v;
-                }
-
-                fwrite(buf.data(), buf.size(), sizeof(buf[0]), fic_fd);
+                fwrite(fib, 32, 1, fic_fd);
             }
         }
         virtual void onNewImpulseResponse(std::vector<float>&& data) override { (void)data; }
         virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
         virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
+        virtual void onSymbolQueueOverrun(const symbol_queue_stats_t& stats) override
+        {
+            cerr << "Decoder too slow: " << stats.overruns <<
+                " symbols dropped, " << stats.discarded_frames <<
+                " frames discarded" << endl;
+        }
+        virtual void onSyncMilestones(const sync_milestones_t& m) override
+        {
+            json j;
+            j["milestones"] = {
+                {"null_detected", m.null_detected},
+                {"prs_locked", m.prs_locked},
+                {"coarse_corrected", m.coarse_corrected},
+                {"fib_crc_valid", m.fib_crc_valid},
+                {"ensemble_label", m.ensemble_label},
+                {"programme_selected", m.programme_selected},
+                {"audio_sync", m.audio_sync},
+                {"first_audio", m.first_audio}
+            };
+            cout << j << endl;
+        }
         virtual void onMessage(message_level_t level, const std::string& text) override
         {
             switch (level) {
@@ -257,6 +279,34 @@ class RadioInterface : public RadioControllerInterface {
         FILE* fic_fd = nullptr;
 };
 
+static void print_decoder_load(const RadioReceiver& rx)
+{
+    const auto poolStats = rx.getDecoderPoolStats();
+    cerr << "Decoder threads: " << poolStats.num_threads << ", " <<
+        poolStats.num_tasks << " tasks, " << poolStats.num_steals <<
+        " stolen" << endl;
+
+    const auto switchStats = rx.getDecoderSwitchStats();
+    cerr << "Decoders: " << switchStats.num_created << " created in " <<
+        switchStats.create_time_s << " s, " << switchStats.num_reused <<
+        " reused in " << switchStats.reuse_time_s << " s" << endl;
+
+    const auto batchStats = rx.getViterbiBatchStats();
+    cerr << "Viterbi: " << batchStats.frames << " frames in " <<
+        batchStats.passes << " batched passes, " << batchStats.alone <<
+        " alone" << endl;
+
+    // A logical frame lasts 24 ms, the load is the fraction of one core
+    // the subchannel needs in real time
+    for (const auto& s : rx.getSubchannelDecodeStats()) {
+        const double load = s.num_frames ?
+            s.cpu_time_s / (s.num_frames * 0.024) : 0;
+        cerr << "  [subch " << s.subchannel_id << "] " << s.num_frames <<
+            " frames, " << s.overflow.dropped_frames << " dropped, CPU " <<
+            s.cpu_time_s << " s, " << 100 * load << " % of a core" << endl;
+    }
+}
+
 struct options_t {
     string antenna = "";
     int gain = -1;
@@ -308,6 +358,16 @@ static void usage()
         " -u      disable coarse corrector, for receivers who have a low frequency offset." << endl <<
         " -g GAIN set input gain to GAIN or -1 for auto gain." << endl <<
         " -A ANT  set input antenna to ANT (for SoapySDR input only)." << endl <<
+        " -s PCT  let the Viterbi decoder of a DAB+ programme take up to PCT % of the time" << endl <<
+        "         to rate the reliability of the bytes, so that the Reed-Solomon decoder" << endl <<
+        "         can correct more errors." << endl <<
+        " -F N    once the ensemble is stable, decode only one FIC frame in N on average." << endl <<
+        " -T N    decode the programmes with N threads, default one per core." << endl <<
+        " -B N    let a frame wait up to N symbols (default 4) for the frames of other" << endl <<
+        "         programmes, to decode them together. 0 decodes each frame at once." << endl <<
+        " -Q POL  when the decoder of a programme is 16 frames behind, drop the 'newest'" << endl <<
+        "         frame (default) or the 'oldest' one, or 'block' for it first, up to 10 ms" << endl <<
+        "         per CIF for all programmes together." << endl <<
         endl <<
         "Use -t test_number to run a test." << endl <<
         "To understand what the tests do, please see source code." << endl <<
@@ -324,11 +384,14 @@ options_t parse_cmdline(int argc, char **argv)
     options.rro.ofdmProcessorThreshold = NEW_OFDM_PROCESSOR_THRESHOLD;
 
     int opt;
-    while ((opt = getopt(argc, argv, "A:c:C:dDf:g:hp:Pt:w:u")) != -1) {
+    while ((opt = getopt(argc, argv, "A:B:c:C:dDf:F:g:hp:PQ:s:t:T:w:u")) != -1) {
         switch (opt) {
             case 'A':
                 options.antenna = optarg;
                 break;
+            case 'B':
+                options.rro.viterbiBatchWaitBlocks = std::atoi(optarg);
+                break;
             case 'c':
                 options.channel = optarg;
                 break;
@@ -344,6 +407,9 @@ options_t parse_cmdline(int argc, char **argv)
             case 'f':
                 options.iqsource = optarg;
                 break;
+            case 'F':
+                options.rro.ficDecimation = std::atoi(optarg);
+                break;
             case 'g':
                 options.gain = std::atoi(optarg);
                 break;
@@ -353,12 +419,33 @@ options_t parse_cmdline(int argc, char **argv)
             case 'P':
                 options.carousel_pad = true;
                 break;
+            case 'Q':
+                if (string(optarg) == "newest") {
+                    options.rro.frameOverflowPolicy = FrameOverflowPolicy::DropNewest;
+                }
+                else if (string(optarg) == "oldest") {
+                    options.rro.frameOverflowPolicy = FrameOverflowPolicy::DropOldest;
+                }
+                else if (string(optarg) == "block") {
+                    options.rro.frameOverflowPolicy = FrameOverflowPolicy::Block;
+                }
+                else {
+                    cerr << "Unknown overflow policy " << optarg << endl;
+                    exit(1);
+                }
+                break;
+            case 's':
+                options.rro.viterbiSoftOutputBudget = std::atof(optarg) / 100;
+                break;
             case 'h':
                 usage();
                 exit(1);
             case 't':
                 options.tests.push_back(std::atoi(optarg));
                 break;
+            case 'T':
+                options.rro.decoderThreads = std::atoi(optarg);
+                break;
             case 'w':
                 options.web_port = std::atoi(optarg);
                 break;
@@ -505,11 +592,14 @@ int main(int argc, char **argv)
             }
 
             while (true) {
-                cerr << "**** Enter '.' to quit." << endl;
+                cerr << "**** Enter '.' to quit, 's' to show the decoder load." << endl;
                 cin >> service_to_tune;
                 if (service_to_tune == ".") {
                     break;
                 }
+                else if (service_to_tune == "s") {
+                    print_decoder_load(rx);
+                }
             }
         }
         else {
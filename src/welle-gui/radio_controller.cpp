@@ -742,7 +742,7 @@ void CRadioController::onDateTimeUpdate(const dab_date_time_t& dateTime)
     emit dateTimeUpdated(dateTime);
 }
 
-void CRadioController::onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib)
+void CRadioController::onFIBDecoded(bool crcCheckOk, const uint8_t* fib)
 {
     (void)fib;
     if (isFICCRC == crcCheckOk)
@@ -778,6 +778,21 @@ void CRadioController::onTIIMeasurement(tii_measurement_t&& m)
         " with error " << m.error;
 }
 
+void CRadioController::onSymbolQueueOverrun(const symbol_queue_stats_t& stats)
+{
+    qDebug().noquote() << "Decoder too slow:" << stats.overruns <<
+        "symbols dropped," << stats.discarded_frames << "frames discarded";
+}
+
+void CRadioController::onSyncMilestones(const sync_milestones_t& m)
+{
+    qDebug() << "RadioController: Milestones (ms): null" << m.null_detected <<
+        "PRS" << m.prs_locked << "coarse" << m.coarse_corrected <<
+        "FIB" << m.fib_crc_valid << "label" << m.ensemble_label <<
+        "programme" << m.programme_selected << "audio sync" << m.audio_sync <<
+        "first audio" << m.first_audio;
+}
+
 void CRadioController::onMessage(message_level_t level, const std::string& text)
 {
     switch (level) {
@@ -898,3 +913,8 @@ void CRadioController::onPADLengthError(size_t announced_xpad_len, size_t xpad_l
 {
     qDebug() << "X-PAD length mismatch, expected:" << announced_xpad_len << " effective:" << xpad_len;
 }
+
+void CRadioController::onFrameOverflow(const frame_overflow_stats_t& stats)
+{
+    qDebug() << "Audio decoder too slow:" << stats.dropped_frames << "frames dropped";
+}
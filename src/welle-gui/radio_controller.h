@@ -142,6 +142,7 @@ public:
     virtual void onNewDynamicLabel(const std::string& label) override;
     virtual void onMOT(const std::vector<uint8_t>& data, int subtype) override;
     virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) override;
+    virtual void onFrameOverflow(const frame_overflow_stats_t& stats) override;
     virtual void onSNR(int snr) override;
     virtual void onFrequencyCorrectorChange(int fine, int coarse) override;
     virtual void onSyncChange(char isSync) override;
@@ -149,11 +150,13 @@ public:
     virtual void onServiceDetected(uint32_t sId, const std::string& label) override;
     virtual void onNewEnsembleName(const std::string& name) override;
     virtual void onDateTimeUpdate(const dab_date_time_t& dateTime) override;
-    virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override;
+    virtual void onFIBDecoded(bool crcCheckOk, const uint8_t* fib) override;
     virtual void onNewImpulseResponse(std::vector<float>&& data) override;
     virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override;
     virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override;
     virtual void onTIIMeasurement(tii_measurement_t&& m) override;
+    virtual void onSymbolQueueOverrun(const symbol_queue_stats_t& stats) override;
+    virtual void onSyncMilestones(const sync_milestones_t& m) override;
     virtual void onMessage(message_level_t level, const std::string& text) override;
 
 private: